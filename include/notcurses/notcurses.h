@@ -582,9 +582,13 @@ channels_set_bg_default(uint64_t* channels){
 // RGB is used if neither default terminal colors nor palette indexing are in
 // play, and fully supports all transparency options.
 typedef struct cell {
-  // These 32 bits are either a single-byte, single-character grapheme cluster
-  // (values 0--0x7f), or an offset into a per-ncplane attached pool of
-  // varying-length UTF-8 grapheme clusters. This pool may thus be up to 32MB.
+  // These 32 bits are either a grapheme cluster of up to four bytes of UTF-8,
+  // or an offset into a per-ncplane attached pool of longer UTF-8 grapheme
+  // clusters. The former are stored with their first byte in the least
+  // significant position, and any unused bytes zero, so that a lone 7-bit
+  // character has its own value (0--0x7f). The latter have 0x01 in their most
+  // significant byte, and the offset in the remaining 24 bits. This pool may
+  // thus be up to 16MB. See cell_simple_p().
   uint32_t gcluster;          // 4B -> 4B
   // NCSTYLE_* attributes (16 bits) + 8 foreground palette index bits + 8
   // background palette index bits. palette index bits are used only if the
@@ -721,14 +725,29 @@ cell_wide_left_p(const cell* c){
   return cell_double_wide_p(c) && c->gcluster;
 }
 
-// Is the cell simple (a lone ASCII character, encoded as such)?
+// Is the cell simple (its EGC, of no more than four bytes, stored within the
+// cell itself, rather than in the plane's pool)?
 static inline bool
 cell_simple_p(const cell* c){
-  return c->gcluster < 0x80;
+  return (c->gcluster & 0xff000000ul) != 0x01000000ul;
+}
+
+// Write the EGC of the simple cell 'c' to 'egc', which must have room for five
+// bytes, and NUL-terminate it. Returns the length of the EGC in bytes.
+static inline int
+cell_simple_egc(const cell* c, char* egc){
+  int len = 0;
+  for(uint32_t g = c->gcluster ; g ; g >>= 8u){
+    egc[len++] = g & 0xffu;
+  }
+  egc[len] = '\0';
+  return len;
 }
 
 // return a pointer to the NUL-terminated EGC referenced by 'c'. this pointer
 // is invalidated by any further operation on the plane 'n', so...watch out!
+// the EGC of a simple cell is instead copied out to storage local to the
+// calling thread, and overwritten by its fourth subsequent such call.
 API const char* cell_extended_gcluster(const struct ncplane* n, const cell* c);
 
 // copy the UTF8-encoded EGC out of the cell, whether simple or complex. the
@@ -737,9 +756,8 @@ static inline char*
 cell_strdup(const struct ncplane* n, const cell* c){
   char* ret;
   if(cell_simple_p(c)){
-    if( (ret = (char*)malloc(2)) ){ // cast is here for C++ clients
-      ret[0] = c->gcluster;
-      ret[1] = '\0';
+    if( (ret = (char*)malloc(5)) ){ // cast is here for C++ clients
+      cell_simple_egc(c, ret);
     }
   }else{
     ret = strdup(cell_extended_gcluster(n, c));
@@ -786,8 +804,8 @@ static inline int
 cell_load_simple(struct ncplane* n, cell* c, char ch){
   cell_release(n, c);
   c->channels &= ~CELL_WIDEASIAN_MASK;
-  c->gcluster = ch;
-  if(cell_simple_p(c)){
+  c->gcluster = (unsigned char)ch;
+  if(c->gcluster < 0x80){
     return 1;
   }
   return -1;
@@ -797,7 +815,7 @@ cell_load_simple(struct ncplane* n, cell* c, char ch){
 // unsafe results if called on a simple cell.
 static inline uint32_t
 cell_egc_idx(const cell* c){
-  return c->gcluster - 0x80;
+  return c->gcluster & 0x00fffffful;
 }
 
 // These log levels consciously map cleanly to those of libav; notcurses itself
@@ -862,6 +880,43 @@ typedef enum {
 // anything but the virtual console/terminal in which Notcurses is running.
 #define NCOPTION_NO_FONT_CHANGES     0x0080ull
 
+// Paint horizontal bands of the rendering area in parallel, using a pool of
+// worker threads (one per online processor) which persists for the lifetime
+// of the context. Output is identical to that of the serial renderer. This is
+// only likely to help with large terminals and many planes.
+#define NCOPTION_PARALLEL_RENDER     0x0100ull
+
+// Write rendered frames to the terminal from a dedicated thread, so that
+// notcurses_render() needn't wait on a slow terminal (e.g. across a network).
+// Should the writer fall behind, frames which haven't yet begun to be written
+// are dropped in favor of their successors. Use notcurses_render_wait() to
+// wait until the most recent frame has been written.
+#define NCOPTION_ASYNC_WRITE         0x0200ull
+
+// Wrap each frame written to the terminal in synchronized update escapes
+// (terminfo's "Sync" capability, or DEC private mode 2026 in its absence), so
+// that supporting terminals present the frame all at once, rather than
+// repainting as it arrives. Other terminals ignore them.
+#define NCOPTION_SYNC_UPDATES        0x0400ull
+
+// Don't use a terminal at all. Output is instead interpreted by a built-in
+// virtual terminal of 80x24 cells, which can be inspected with
+// notcurses_headless_at(), and resized with notcurses_headless_resize(). The
+// FILE* passed to notcurses_init() is ignored, no tty is opened, no signal
+// handlers are installed, and stdin is neither read nor modified, so any
+// number of headless contexts can coexist with one another (and with a single
+// terminal context). notcurses_getc() never returns input. Escapes are still generated from the terminfo entry
+// named by 'termtype' (or TERM); if neither is set, "xterm-256color" is used.
+// The virtual terminal understands ECMA-48 (xterm-like) control sequences.
+#define NCOPTION_HEADLESS            0x0800ull
+
+// EGCs too long to be stored within a cell live in their plane's egcpool,
+// which is compacted when the plane is resized or erased. With this flag,
+// any plane whose egcpool is mostly released space is also compacted prior
+// to rendering. Cells loaded against such a plane, but not written to it,
+// don't survive compaction.
+#define NCOPTION_COMPACT_EGCPOOLS    0x1000ull
+
 // Configuration for notcurses_init().
 typedef struct notcurses_options {
   // The name of the terminfo database entry describing this terminal. If NULL,
@@ -916,6 +971,23 @@ API int notcurses_stop(struct notcurses* nc);
 // successful call to notcurses_render().
 API int notcurses_render(struct notcurses* nc);
 
+// With NCOPTION_ASYNC_WRITE, notcurses_render() returns once the frame has
+// been handed to the writer thread. Block until every frame so handed off has
+// been written to the terminal (or dropped in favor of a later one). Returns
+// -1 if any write failed since the last such wait. Returns 0 immediately if
+// writes are synchronous. With a notcurses_set_maxfps() limit, this can wait
+// until the next tick.
+API int notcurses_render_wait(struct notcurses* nc);
+
+// Write no more than 'maxfps' frames per second (0 for no limit, the
+// default). Frames are then written by a dedicated thread, as with
+// NCOPTION_ASYNC_WRITE. A frame rendered within 1/maxfps seconds of the last
+// write is held until the next tick, and written then without any further
+// call. Should another frame be rendered meanwhile, the held frame is
+// coalesced into it, and never written. Returns -1 if the writer thread
+// couldn't be launched.
+API int notcurses_set_maxfps(struct notcurses* nc, unsigned maxfps);
+
 // Write the last rendered frame, in its entirety, to 'fp'. This is not valid
 // until notcurses_render() has been successfully called at least once.
 API int notcurses_render_to_file(struct notcurses* nc, FILE* fp);
@@ -1059,6 +1131,38 @@ notcurses_term_dim_yx(const struct notcurses* n, int* RESTRICT rows, int* RESTRI
 API char* notcurses_at_yx(struct notcurses* nc, int yoff, int xoff,
                           uint32_t* attrword, uint64_t* channels);
 
+// Retrieve the contents of the cell at 'y', 'x' (margins included) of a
+// headless context's virtual terminal, as interpreted from the output written
+// to it. Unlike notcurses_at_yx(), this reflects what was actually emitted.
+// Styles and palette indices are written to 'attrword', and colors to
+// 'channels'; colors emitted as palette indices are reported as such. The
+// right half of a wide glyph is an empty EGC with CELL_WIDEASIAN_MASK set.
+// The EGC must be free()d by the caller. Returns NULL if 'nc' isn't headless,
+// or the coordinates are outside the screen. With NCOPTION_ASYNC_WRITE, call
+// notcurses_render_wait() first.
+API char* notcurses_headless_at(const struct notcurses* nc, int y, int x,
+                                uint32_t* attrword, uint64_t* channels);
+
+// Get the cursor location of a headless context's virtual terminal.
+API int notcurses_headless_cursor(const struct notcurses* nc, int* RESTRICT y,
+                                  int* RESTRICT x);
+
+// Resize a headless context's virtual terminal, as if a terminal had been
+// resized. The new geometry is picked up by the next notcurses_render() or
+// notcurses_refresh().
+API int notcurses_headless_resize(struct notcurses* nc, int rows, int cols);
+
+// If the NOTCURSES_TRACE environment variable names a file when notcurses_init()
+// is called, the operations made on planes (creation and destruction, moves,
+// resizes, z-axis changes, and the writing of cells) are recorded to that file,
+// along with each notcurses_render() and the time elapsed between them. Replay
+// such a trace from 'fp' on 'nc', which ought have no planes other than the
+// standard plane. A headless 'nc' is resized to the recorded geometry. With
+// 'realtime', renders are paced as they were recorded; otherwise, they're
+// performed as quickly as possible. Returns the number of frames rendered, or
+// -1 if the trace was malformed.
+API int notcurses_replay(struct notcurses* nc, FILE* fp, bool realtime);
+
 // Create a new ncplane at the specified offset (relative to the standard plane)
 // and the specified size. The number of rows and columns must both be positive.
 // This plane is initially at the top of the z-buffer, as if ncplane_move_top()
@@ -1075,6 +1179,27 @@ API struct ncplane* ncplane_aligned(struct ncplane* n, int rows, int cols,
 API struct ncplane* ncplane_bound(struct ncplane* n, int rows, int cols,
                                   int yoff, int xoff, void* opaque);
 
+// Create a sparse plane, bound to 'boundto' if it is not NULL (see
+// ncplane_bound()). A sparse plane's memory is proportional to its content
+// rather than its extent: it allocates storage for groups of rows only upon
+// their first being written, and releases all of it when erased. Rows never
+// written are drawn with the plane's base cell. This suits very large planes
+// (i.e. scrollable documents) with few rows in use. Operations covering a
+// whole plane (ncplane_greyscale(), fades) leave rows which have never been
+// written as they are.
+API struct ncplane* ncplane_new_sparse(struct notcurses* nc,
+                                       struct ncplane* boundto, int rows,
+                                       int cols, int yoff, int xoff,
+                                       void* opaque);
+
+// Convert an existing plane to sparse storage (dropping any groups of rows
+// which are entirely blank), or back to a single framebuffer. Returns 0 on
+// success, or -1 on failure, in which case the plane is unchanged.
+API int ncplane_set_sparse(struct ncplane* n, bool sparse);
+
+// Does the plane use sparse storage?
+API bool ncplane_sparse_p(const struct ncplane* n);
+
 // Plane 'n' will be unbound from its parent plane, if it is currently bound,
 // and will be made a bound child of 'newparent', if 'newparent' is not NULL.
 API struct ncplane* ncplane_reparent(struct ncplane* n, struct ncplane* newparent);
@@ -1135,6 +1260,9 @@ API bool notcurses_canutf8(const struct notcurses* nc);
 // Can we blit to Sixel?
 API bool notcurses_cansixel(const struct notcurses* nc);
 
+// Buckets in each of the per-phase latency histograms of ncstats.
+#define NCSTATS_BUCKETS 40
+
 typedef struct ncstats {
   // purely increasing stats
   uint64_t renders;          // number of successful notcurses_render() runs
@@ -1153,10 +1281,46 @@ typedef struct ncstats {
   uint64_t bgemissions;      // RGB bg emissions
   uint64_t defaultelisions;  // default color was emitted
   uint64_t defaultemissions; // default color was elided
+  uint64_t cellsculled;      // plane cells skipped, being occluded from above
+  uint64_t frames_dropped;   // unwritten frames superseded by NCOPTION_ASYNC_WRITE
+  uint64_t renders_coalesced;// frames held for the next tick, then superseded
+  // the time spent in each phase of rendering a frame: painting planes into
+  // the frame, finalizing the painted cells (postpaint), rasterizing the frame
+  // into escapes, and writing it to the terminal.
+  uint64_t paint_ns;
+  uint64_t postpaint_ns;
+  uint64_t raster_ns;
+  uint64_t write_ns;
+  // latency histograms for these phases, with a sample per phase per frame.
+  // bucket 0 counts samples of 0ns, and bucket i > 0 those of [2^(i-1), 2^i)
+  // ns. the final bucket additionally counts anything longer. see
+  // ncstats_percentile().
+  uint64_t paint_hist[NCSTATS_BUCKETS];
+  uint64_t postpaint_hist[NCSTATS_BUCKETS];
+  uint64_t raster_hist[NCSTATS_BUCKETS];
+  uint64_t write_hist[NCSTATS_BUCKETS];
+  // rasterized bytes, by what they were spent on. for frames written by
+  // notcurses_render(), these sum to render_bytes.
+  uint64_t motion_bytes;     // cursor motion (including rewritten glyphs)
+  uint64_t style_bytes;      // styles (bold, italic, etc.)
+  uint64_t rgb_bytes;        // RGB colors
+  uint64_t palette_bytes;    // palette-indexed (and quantized RGB) colors
+  uint64_t default_bytes;    // resets to the default colors
+  uint64_t glyph_bytes;      // EGCs, and the escapes which repeat or erase them
+  uint64_t palprog_bytes;    // palette reprogramming
+  uint64_t sync_bytes;       // brackets of NCOPTION_SYNC_UPDATES
+  uint64_t hwscrolls;        // rows scrolled by the terminal, not redrawn
+  uint64_t egcpool_compactions; // plane egcpools rebuilt from their live EGCs
 
   // current state -- these can decrease
   uint64_t fbbytes;          // total bytes devoted to all active framebuffers
   unsigned planes;           // number of planes currently in existence
+  uint64_t arenabytes;       // bytes devoted to render scratch space
+  uint64_t queuedbytes;      // bytes handed to the writer, but not yet written
+  uint64_t egcpool_bytes;    // bytes allocated to planes' egcpools
+  uint64_t egcpool_max_bytes;// bytes allocated to the largest plane egcpool
+  uint64_t egcpool_used;     // bytes of EGCs held in planes' egcpools
+  uint64_t egcpool_free;     // bytes released within egcpools, awaiting reuse
 } ncstats;
 
 // Acquire an atomic snapshot of the notcurses object's stats.
@@ -1165,6 +1329,32 @@ API void notcurses_stats(const struct notcurses* nc, ncstats* stats);
 // Reset all cumulative stats (immediate ones, such as fbbytes, are not reset).
 API void notcurses_reset_stats(struct notcurses* nc, ncstats* stats);
 
+// Estimate the 'p'th percentile (0 < p <= 1, i.e. 0.99 for p99) of one of the
+// latency histograms of ncstats, returning the upper bound (in nanoseconds) of
+// the bucket in which it falls. Returns 0 for an empty histogram.
+static inline uint64_t
+ncstats_percentile(const uint64_t* hist, double p){
+  uint64_t total = 0;
+  for(int i = 0 ; i < NCSTATS_BUCKETS ; ++i){
+    total += hist[i];
+  }
+  if(total == 0){
+    return 0;
+  }
+  uint64_t rank = (uint64_t)(p * total + 0.5);
+  if(rank == 0){
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  int i;
+  for(i = 0 ; i < NCSTATS_BUCKETS - 1 ; ++i){
+    if((seen += hist[i]) >= rank){
+      break;
+    }
+  }
+  return i ? (1ull << i) - 1 : 0;
+}
+
 // Resize the specified ncplane. The four parameters 'keepy', 'keepx',
 // 'keepleny', and 'keeplenx' define a subset of the ncplane to keep,
 // unchanged. This may be a section of size 0, though none of these four
@@ -1357,6 +1547,43 @@ ncplane_putc(struct ncplane* n, const cell* c){
   return ncplane_putc_yx(n, -1, -1, c);
 }
 
+// Replace the 'leny'x'lenx' block of cells having its upper-left corner at
+// 'y', 'x' (-1 for either means the cursor's current coordinate) with the
+// cells of 'cells', a row-major array in which each row begins 'stride' cells
+// after the previous. The EGCs of complex cells are taken from 'src', the
+// plane against which they were loaded (it may be NULL if all the cells are
+// simple). Cells are written as they are, including any wide glyphs and their
+// right halves; wide glyphs split by the block's edges are obliterated, as
+// they are by ncplane_putc_yx(). The block must lie entirely within the plane.
+// The cursor is not moved. Returns the number of cells written, or -1 on error.
+API int ncplane_put_cells(struct ncplane* n, int y, int x, int leny, int lenx,
+                          const struct ncplane* src, const cell* cells,
+                          int stride);
+
+// As ncplane_put_cells(), but the EGC of each cell is looked up in 'egcs', a
+// table of 'egccount' EGCs, using the index at the same position in the
+// row-major array 'indices'. Each cell's attributes and channels come from
+// the cell at that position in 'styles', if it is not NULL (its EGC being
+// ignored), or otherwise from the plane's current styling. An EGC occupying
+// two columns claims the next cell of the block as its right half, and that
+// cell's index is ignored. Each EGC is measured only once, however many cells
+// employ it. Returns the number of cells written, or -1 on error.
+API int ncplane_put_egcs(struct ncplane* n, int y, int x, int leny, int lenx,
+                         const char* const* egcs, int egccount,
+                         const uint32_t* indices, const cell* styles,
+                         int stride);
+
+// Copy the 'leny'x'lenx' block of cells having its upper-left corner at 'y',
+// 'x' (-1 for either means the cursor's current coordinate) into 'cells', a
+// row-major array in which each row begins 'stride' cells after the previous.
+// The block must lie entirely within the plane. Complex EGCs are duplicated
+// into the plane's egcpool, as with ncplane_at_yx_cell(), and each cell must
+// eventually be released with cell_release(). The cells' previous contents are
+// overwritten without being released. Returns the number of cells copied, or
+// -1 on error.
+API int ncplane_get_cells(struct ncplane* n, int y, int x, int leny, int lenx,
+                          cell* cells, int stride);
+
 // Replace the EGC underneath us, but retain the styling. The current styling
 // of the plane will not be changed.
 //
@@ -1365,8 +1592,8 @@ ncplane_putc(struct ncplane* n, const cell* c){
 // This works whether the underlying char is signed or unsigned.
 static inline int
 ncplane_putsimple_yx(struct ncplane* n, int y, int x, char c){
-  cell ce = CELL_INITIALIZER((uint32_t)c, ncplane_attr(n), ncplane_channels(n));
-  if(!cell_simple_p(&ce)){
+  cell ce = CELL_INITIALIZER((unsigned char)c, ncplane_attr(n), ncplane_channels(n));
+  if(ce.gcluster >= 0x80){
     return -1;
   }
   return ncplane_putc_yx(n, y, x, &ce);
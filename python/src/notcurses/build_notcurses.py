@@ -27,9 +27,10 @@ char32_t notcurses_getc_nblock(struct notcurses* n, ncinput* ni);
 char32_t notcurses_getc_blocking(struct notcurses* n, ncinput* ni);
 int notcurses_inputready_fd(struct notcurses* n);
 typedef struct cell {
-  // These 32 bits are either a single-byte, single-character grapheme cluster
-  // (values 0--0x7f), or an offset into a per-ncplane attached pool of
-  // varying-length UTF-8 grapheme clusters. This pool may thus be up to 32MB.
+  // These 32 bits are either a grapheme cluster of up to four bytes of UTF-8
+  // (first byte least significant), or 0x01 in the most significant byte,
+  // and an offset into a per-ncplane attached pool of longer UTF-8 grapheme
+  // clusters in the remaining 24 bits. This pool may thus be up to 16MB.
   uint32_t gcluster;          // 1 * 4b -> 4b
   // CELL_STYLE_* attributes (16 bits) + 16 reserved bits
   uint32_t attrword;          // + 4b -> 8b
@@ -87,6 +88,8 @@ void notcurses_version_components(int* major, int* minor, int* patch, int* tweak
 int notcurses_lex_margins(const char* op, notcurses_options* opts);
 int notcurses_stop(struct notcurses*);
 int notcurses_render(struct notcurses*);
+int notcurses_render_wait(struct notcurses* nc);
+int notcurses_set_maxfps(struct notcurses* nc, unsigned maxfps);
 int notcurses_render_to_file(struct notcurses* nc, FILE* fp);
 struct ncplane* notcurses_stdplane(struct notcurses*);
 const struct ncplane* notcurses_stdplane_const(const struct notcurses* nc);
@@ -98,6 +101,9 @@ void notcurses_drop_planes(struct notcurses* nc);
 int notcurses_refresh(struct notcurses* n, int* restrict y, int* restrict x);
 struct ncplane* ncplane_new(struct notcurses* nc, int rows, int cols, int yoff, int xoff, void* opaque);
 struct ncplane* ncplane_bound(struct ncplane* n, int rows, int cols, int yoff, int xoff, void* opaque);
+struct ncplane* ncplane_new_sparse(struct notcurses* nc, struct ncplane* boundto, int rows, int cols, int yoff, int xoff, void* opaque);
+int ncplane_set_sparse(struct ncplane* n, bool sparse);
+bool ncplane_sparse_p(const struct ncplane* n);
 struct ncplane* ncplane_reparent(struct ncplane* n, struct ncplane* newparent);
 typedef enum {
   NCALIGN_LEFT,
@@ -125,16 +131,23 @@ int ncplane_move_yx(struct ncplane* n, int y, int x);
 void ncplane_yx(struct ncplane* n, int* y, int* x);
 void ncplane_dim_yx(const struct ncplane* n, int* rows, int* cols);
 int ncplane_putc_yx(struct ncplane* n, int y, int x, const cell* c);
+int ncplane_put_cells(struct ncplane* n, int y, int x, int leny, int lenx, const struct ncplane* src, const cell* cells, int stride);
+int ncplane_put_egcs(struct ncplane* n, int y, int x, int leny, int lenx, const char* const* egcs, int egccount, const uint32_t* indices, const cell* styles, int stride);
 void ncplane_move_top(struct ncplane* n);
 void ncplane_move_bottom(struct ncplane* n);
 int ncplane_move_below(struct ncplane* restrict n, struct ncplane* restrict below);
 int ncplane_move_above(struct ncplane* restrict n, struct ncplane* restrict above);
 struct ncplane* ncplane_below(struct ncplane* n);
 char* notcurses_at_yx(struct notcurses* nc, int yoff, int xoff, uint32_t* attrword, uint64_t* channels);
+char* notcurses_headless_at(const struct notcurses* nc, int y, int x, uint32_t* attrword, uint64_t* channels);
+int notcurses_headless_cursor(const struct notcurses* nc, int* y, int* x);
+int notcurses_headless_resize(struct notcurses* nc, int rows, int cols);
+int notcurses_replay(struct notcurses* nc, FILE* fp, bool realtime);
 char* ncplane_at_cursor(struct ncplane* n, uint32_t* attrword, uint64_t* channels);
 int ncplane_at_cursor_cell(struct ncplane* n, cell* c);
 char* ncplane_at_yx(const struct ncplane* n, int y, int x, uint32_t* attrword, uint64_t* channels);
 int ncplane_at_yx_cell(struct ncplane* n, int y, int x, cell* c);
+int ncplane_get_cells(struct ncplane* n, int y, int x, int leny, int lenx, cell* cells, int stride);
 typedef enum {
   NCBLIT_1x1,     // full block                █
   NCBLIT_2x1,     // full/(upper|left) blocks  ▄█
@@ -190,13 +203,41 @@ typedef struct ncstats {
   int64_t render_min_ns;     // min ns spent in successful notcurses_render()
   uint64_t cellelisions;     // cells we elided entirely thanks to damage maps
   uint64_t cellemissions;    // cells we emitted due to inferred damage
-  uint64_t fbbytes;          // total bytes devoted to all active framebuffers
   uint64_t fgelisions;       // RGB fg elision count
   uint64_t fgemissions;      // RGB fg emissions
   uint64_t bgelisions;       // RGB bg elision count
   uint64_t bgemissions;      // RGB bg emissions
   uint64_t defaultelisions;  // default color was emitted
   uint64_t defaultemissions; // default color was elided
+  uint64_t cellsculled;      // plane cells skipped, being occluded from above
+  uint64_t frames_dropped;   // unwritten frames superseded by NCOPTION_ASYNC_WRITE
+  uint64_t renders_coalesced;// frames held for the next tick, then superseded
+  uint64_t paint_ns;
+  uint64_t postpaint_ns;
+  uint64_t raster_ns;
+  uint64_t write_ns;
+  uint64_t paint_hist[40];   // NCSTATS_BUCKETS
+  uint64_t postpaint_hist[40];
+  uint64_t raster_hist[40];
+  uint64_t write_hist[40];
+  uint64_t motion_bytes;
+  uint64_t style_bytes;
+  uint64_t rgb_bytes;
+  uint64_t palette_bytes;
+  uint64_t default_bytes;
+  uint64_t glyph_bytes;
+  uint64_t palprog_bytes;
+  uint64_t sync_bytes;
+  uint64_t hwscrolls;
+  uint64_t egcpool_compactions;
+  uint64_t fbbytes;          // total bytes devoted to all active framebuffers
+  unsigned planes;           // number of planes currently in existence
+  uint64_t arenabytes;       // bytes devoted to render scratch space
+  uint64_t queuedbytes;      // bytes handed to the writer, but not yet written
+  uint64_t egcpool_bytes;    // bytes allocated to planes' egcpools
+  uint64_t egcpool_max_bytes;// bytes allocated to the largest plane egcpool
+  uint64_t egcpool_used;     // bytes of EGCs held in planes' egcpools
+  uint64_t egcpool_free;     // bytes released within egcpools, awaiting reuse
 } ncstats;
 void notcurses_stats(struct notcurses* nc, ncstats* stats);
 void notcurses_reset_stats(struct notcurses* nc, ncstats* stats);
@@ -228,6 +269,7 @@ int cell_set_fg_alpha(cell* c, unsigned alpha);
 int cell_set_bg_alpha(cell* c, unsigned alpha);
 bool cell_double_wide_p(const cell* c);
 bool cell_simple_p(const cell* c);
+int cell_simple_egc(const cell* c, char* egc);
 const char* cell_extended_gcluster(const struct ncplane* n, const cell* c);
 int cell_load_simple(struct ncplane* n, cell* c, char ch);
 uint32_t cell_egc_idx(const cell* c);
@@ -13,6 +13,11 @@ NCOPTION_RETAIN_CURSOR = 0x0010
 NCOPTION_SUPPRESS_BANNERS = 0x0020
 NCOPTION_NO_ALTERNATE_SCREEN = 0x0040
 NCOPTION_NO_FONT_CHANGES = 0x0080
+NCOPTION_PARALLEL_RENDER = 0x0100
+NCOPTION_ASYNC_WRITE = 0x0200
+NCOPTION_SYNC_UPDATES = 0x0400
+NCOPTION_HEADLESS = 0x0800
+NCOPTION_COMPACT_EGCPOOLS = 0x1000
 
 class NotcursesError(Exception):
     """Base class for notcurses exceptions."""
@@ -47,7 +52,7 @@ class Cell:
         lib.cell_set_bg_rgb(self.c, r, g, b)
 
     def simpleP(self):
-        return self.c.gcluster < 0x80
+        return lib.cell_simple_p(self.c)
 
     def getNccell(self):
         return self.c
@@ -0,0 +1,829 @@
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <notcurses/notcurses.h>
+#include "egcpool.h"
+
+// notcurses-bench: repeatable microbenchmarks of the library's hot paths,
+// written to stdout as JSON. everything is rendered into a headless context
+// of fixed geometry, so no terminal is needed, and results don't depend on
+// the one we were launched from. all inputs are generated deterministically.
+
+#define BENCH_ROWS 50
+#define BENCH_COLS 160
+
+typedef struct benchmark {
+  const char* name;
+  int param;            // interpreted by the benchmark's callbacks
+  int ops;              // operations per run (before scaling by -s)
+  // returns opaque state, or NULL if the benchmark can't be run here
+  void* (*setup)(int param);
+  // perform operations [first, first + ops), returning non-zero on error
+  int (*run)(void* state, int param, int first, int ops);
+  // called after the untimed warmup run. may be NULL.
+  void (*warmed)(void* state);
+  // write any additional JSON members (with leading commas), given the
+  // number of timed operations. may be NULL.
+  void (*extra)(void* state, FILE* out, uint64_t ops);
+  void (*teardown)(void* state);
+} benchmark;
+
+static uint64_t
+timenow_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static struct notcurses*
+bench_notcurses(void){
+  notcurses_options opts = {
+    .flags = NCOPTION_INHIBIT_SETLOCALE | NCOPTION_SUPPRESS_BANNERS |
+             NCOPTION_HEADLESS,
+  };
+  struct notcurses* nc = notcurses_init(&opts, NULL);
+  if(nc == NULL){
+    return NULL;
+  }
+  if(notcurses_headless_resize(nc, BENCH_ROWS, BENCH_COLS)){
+    notcurses_stop(nc);
+    return NULL;
+  }
+  return nc;
+}
+
+// fill the standard plane with styled text, varying with 'seed'
+static void
+fill_stdplane(struct notcurses* nc, int seed){
+  struct ncplane* n = notcurses_stdplane(nc);
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    ncplane_set_fg_rgb(n, (y * 5 + seed) % 256, 0xc0, 0x40);
+    ncplane_set_bg_rgb(n, 0x10, (y * 3) % 256, 0x30);
+    ncplane_cursor_move_yx(n, y, 0);
+    for(int x = 0 ; x < dimx ; ++x){
+      ncplane_putsimple(n, 'a' + (x + y + seed) % 26);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// rendering. 'param' is the number of planes atop the standard plane. each
+// operation moves every plane one cell, and renders a frame.
+
+typedef struct renderstate {
+  struct notcurses* nc;
+  struct ncplane** planes;
+  int count;
+  ncstats stats;
+} renderstate;
+
+static void*
+render_setup(int param){
+  renderstate* rs = calloc(1, sizeof(*rs));
+  if(rs == NULL){
+    return NULL;
+  }
+  if((rs->nc = bench_notcurses()) == NULL){
+    free(rs);
+    return NULL;
+  }
+  fill_stdplane(rs->nc, 0);
+  if((rs->planes = calloc(param, sizeof(*rs->planes))) == NULL){
+    notcurses_stop(rs->nc);
+    free(rs);
+    return NULL;
+  }
+  for(int i = 0 ; i < param ; ++i){
+    struct ncplane* p = ncplane_new(rs->nc, 8, 24, 0, 0, NULL);
+    if(p == NULL){
+      break;
+    }
+    rs->planes[rs->count++] = p;
+    ncplane_set_fg_rgb(p, 0xff, (i * 37) % 256, 0);
+    ncplane_set_bg_rgb(p, 0, 0, (i * 59) % 256);
+    // every other plane is translucent, so the planes beneath it show through
+    ncplane_set_bg_alpha(p, i % 2 ? CELL_ALPHA_BLEND : CELL_ALPHA_OPAQUE);
+    for(int y = 0 ; y < 8 ; ++y){
+      ncplane_putstr_yx(p, y, 0, "plane ▚▞ 全角 é ✔ plane");
+    }
+  }
+  if(rs->count != param){
+    for(int i = 0 ; i < rs->count ; ++i){
+      ncplane_destroy(rs->planes[i]);
+    }
+    free(rs->planes);
+    notcurses_stop(rs->nc);
+    free(rs);
+    return NULL;
+  }
+  return rs;
+}
+
+static int
+render_run(void* state, int param, int first, int ops){
+  renderstate* rs = state;
+  (void)param;
+  for(int op = first ; op < first + ops ; ++op){
+    for(int i = 0 ; i < rs->count ; ++i){
+      ncplane_move_yx(rs->planes[i], (i * 7 + op) % (BENCH_ROWS - 4),
+                      (i * 13 + op * 3) % (BENCH_COLS - 12));
+    }
+    if(notcurses_render(rs->nc)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// break the time spent rendering down by phase. the write phase is the
+// headless context interpreting the frame, standing in for the terminal.
+static void
+render_extra(void* state, FILE* out, uint64_t ops){
+  renderstate* rs = state;
+  notcurses_stats(rs->nc, &rs->stats);
+  // stats were reset following the untimed warmup run
+  const uint64_t r = rs->stats.renders;
+  if(r != ops){
+    return;
+  }
+  fprintf(out, ",\"paint_ns\":%" PRIu64 ",\"postpaint_ns\":%" PRIu64
+          ",\"raster_ns\":%" PRIu64 ",\"write_ns\":%" PRIu64
+          ",\"bytes\":%" PRIu64 ",\"cells_emitted\":%" PRIu64,
+          rs->stats.paint_ns / r, rs->stats.postpaint_ns / r,
+          rs->stats.raster_ns / r, rs->stats.write_ns / r,
+          rs->stats.render_bytes / r, rs->stats.cellemissions / r);
+}
+
+static void
+render_warmed(void* state){
+  renderstate* rs = state;
+  notcurses_reset_stats(rs->nc, &rs->stats);
+}
+
+static void
+render_teardown(void* state){
+  renderstate* rs = state;
+  notcurses_stop(rs->nc);
+  free(rs->planes);
+  free(rs);
+}
+
+// ---------------------------------------------------------------------------
+// rasterization. 'param' is the percentage of cells changed in each frame.
+// the same cells change in every frame, alternating between two glyphs and
+// colors, so that each frame damages exactly them.
+
+static bool
+damaged_p(int y, int x, int pct){
+  uint32_t h = (uint32_t)(y * BENCH_COLS + x) * 2654435761u;
+  return (h >> 16u) % 100 < (unsigned)pct;
+}
+
+static void*
+raster_setup(int param){
+  (void)param;
+  return render_setup(0);
+}
+
+static int
+raster_run(void* state, int param, int first, int ops){
+  renderstate* rs = state;
+  struct ncplane* n = notcurses_stdplane(rs->nc);
+  for(int op = first ; op < first + ops ; ++op){
+    if(param){
+      for(int y = 0 ; y < BENCH_ROWS ; ++y){
+        for(int x = 0 ; x < BENCH_COLS ; ++x){
+          if(damaged_p(y, x, param)){
+            ncplane_set_fg_rgb(n, op % 2 ? 0xff : 0x40, x % 256, y % 256);
+            ncplane_putsimple_yx(n, y, x, op % 2 ? '#' : '=');
+          }
+        }
+      }
+    }
+    if(notcurses_render(rs->nc)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// egcpool churn. 'param' EGCs of assorted lengths are kept live, each
+// operation releasing the oldest and stashing a new one in its place. the
+// time per operation ought not grow with the number of live EGCs.
+
+static const char* const churn_egcs[] = {
+  "é", "全", "✔", "▚", "👩‍🔬", "é̂", "🇺🇸", "ज़्", "☕️", "각",
+};
+
+typedef struct churnstate {
+  egcpool pool;
+  int* live;
+} churnstate;
+
+static void
+churn_teardown(void* state){
+  churnstate* cs = state;
+  egcpool_dump(&cs->pool);
+  free(cs->live);
+  free(cs);
+}
+
+static void*
+churn_setup(int param){
+  churnstate* cs = malloc(sizeof(*cs));
+  if(cs == NULL){
+    return NULL;
+  }
+  egcpool_init(&cs->pool);
+  if((cs->live = malloc(sizeof(*cs->live) * param)) == NULL){
+    free(cs);
+    return NULL;
+  }
+  for(int i = 0 ; i < param ; ++i){
+    const char* egc = churn_egcs[i % (sizeof(churn_egcs) / sizeof(*churn_egcs))];
+    if((cs->live[i] = egcpool_stash(&cs->pool, egc, strlen(egc))) < 0){
+      churn_teardown(cs);
+      return NULL;
+    }
+  }
+  return cs;
+}
+
+static int
+churn_run(void* state, int param, int first, int ops){
+  churnstate* cs = state;
+  const size_t egccount = sizeof(churn_egcs) / sizeof(*churn_egcs);
+  for(int op = first ; op < first + ops ; ++op){
+    int slot = op % param;
+    egcpool_release(&cs->pool, cs->live[slot]);
+    // step through the EGCs with a stride coprime to their count, so that
+    // freed slots are refilled with EGCs of different lengths
+    const char* egc = churn_egcs[(op * 3u) % egccount];
+    if((cs->live[slot] = egcpool_stash(&cs->pool, egc, strlen(egc))) < 0){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void
+churn_extra(void* state, FILE* out, uint64_t ops){
+  churnstate* cs = state;
+  (void)ops;
+  fprintf(out, ",\"poolsize\":%d,\"poolused\":%d,\"poolfree\":%d",
+          cs->pool.poolsize, cs->pool.poolused, cs->pool.poolfree);
+}
+
+// ---------------------------------------------------------------------------
+// blitting. 'param' is the ncblitter_e. each operation blits a gradient with
+// a translucent stripe onto a plane.
+
+#define BLITROWS 96
+#define BLITCOLS 128
+
+typedef struct blitstate {
+  struct notcurses* nc;
+  struct ncplane* n;
+  uint32_t* rgba;
+} blitstate;
+
+static void
+blit_teardown(void* state){
+  blitstate* bs = state;
+  free(bs->rgba);
+  notcurses_stop(bs->nc);
+  free(bs);
+}
+
+static int blit_run(void* state, int param, int first, int ops);
+
+static void*
+blit_setup(int param){
+  blitstate* bs = calloc(1, sizeof(*bs));
+  if(bs == NULL){
+    return NULL;
+  }
+  if((bs->nc = bench_notcurses()) == NULL){
+    free(bs);
+    return NULL;
+  }
+  bs->n = notcurses_stdplane(bs->nc);
+  if((bs->rgba = malloc(sizeof(*bs->rgba) * BLITROWS * BLITCOLS)) == NULL){
+    blit_teardown(bs);
+    return NULL;
+  }
+  for(int y = 0 ; y < BLITROWS ; ++y){
+    for(int x = 0 ; x < BLITCOLS ; ++x){
+      uint32_t* px = &bs->rgba[y * BLITCOLS + x];
+      *px = 0;
+      ncpixel_set_r(px, x * 2);
+      ncpixel_set_g(px, y * 2);
+      ncpixel_set_b(px, (x + y) % 256);
+      ncpixel_set_a(px, (x / 8 + y / 8) % 5 ? 0xff : 0);
+    }
+  }
+  // not every blitter is available in every environment
+  if(blit_run(bs, param, 0, 1)){
+    blit_teardown(bs);
+    return NULL;
+  }
+  return bs;
+}
+
+static int
+blit_run(void* state, int param, int first, int ops){
+  blitstate* bs = state;
+  struct ncvisual_options vopts = {
+    .n = bs->n,
+    .leny = BLITROWS,
+    .lenx = BLITCOLS,
+    .blitter = param,
+    .flags = NCVISUAL_OPTION_NODEGRADE,
+  };
+  for(int op = first ; op < first + ops ; ++op){
+    if(ncblit_rgba(bs->rgba, BLITCOLS * sizeof(*bs->rgba), &vopts) <= 0){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// ncplane_puttext(). each operation lays out a paragraph of mixed text.
+
+static const char puttext_text[] =
+  "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+  "tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim "
+  "veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea "
+  "commodo consequat. Ἐν ἀρχῇ ἦν ὁ λόγος, καὶ ὁ λόγος ἦν πρὸς τὸν θεόν. "
+  "色は匂へど 散りぬるを 我が世誰ぞ 常ならむ 有為の奥山 今日越えて "
+  "Duis aute irure dolor in reprehenderit in voluptate velit esse cillum "
+  "dolore eu fugiat nulla pariatur. Excepteur sint occaecat cupidatat non "
+  "proident, sunt in culpa qui officia deserunt mollit anim id est laborum.";
+
+typedef struct textstate {
+  struct notcurses* nc;
+  struct ncplane* n;
+} textstate;
+
+static void*
+puttext_setup(int param){
+  (void)param;
+  textstate* ts = malloc(sizeof(*ts));
+  if(ts == NULL){
+    return NULL;
+  }
+  if((ts->nc = bench_notcurses()) == NULL){
+    free(ts);
+    return NULL;
+  }
+  if((ts->n = ncplane_new(ts->nc, 16, 60, 0, 0, NULL)) == NULL){
+    notcurses_stop(ts->nc);
+    free(ts);
+    return NULL;
+  }
+  return ts;
+}
+
+static int
+puttext_run(void* state, int param, int first, int ops){
+  textstate* ts = state;
+  (void)param;
+  for(int op = first ; op < first + ops ; ++op){
+    size_t bytes;
+    if(ncplane_puttext(ts->n, 0, op % 3, puttext_text, &bytes) < 0 ||
+       bytes != sizeof(puttext_text) - 1){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void
+puttext_teardown(void* state){
+  textstate* ts = state;
+  notcurses_stop(ts->nc);
+  free(ts);
+}
+
+// ---------------------------------------------------------------------------
+// ncplane_putstr_yx(). each operation writes the lorem ipsum text, scrolling,
+// with 'param' selecting ASCII (0) or mixed (1) text.
+
+static const char putstr_ascii[] =
+  "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+  "tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim "
+  "veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea "
+  "commodo consequat. Duis aute irure dolor in reprehenderit in voluptate "
+  "velit esse cillum dolore eu fugiat nulla pariatur. Excepteur sint occaecat "
+  "cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id "
+  "est laborum.";
+
+static void*
+putstr_setup(int param){
+  textstate* ts = puttext_setup(param);
+  if(ts){
+    ncplane_set_scrolling(ts->n, true);
+  }
+  return ts;
+}
+
+static int
+putstr_run(void* state, int param, int first, int ops){
+  textstate* ts = state;
+  const char* text = param ? puttext_text : putstr_ascii;
+  (void)first;
+  for(int op = 0 ; op < ops ; ++op){
+    if(ncplane_putstr(ts->n, text) <= 0){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// writing a grid of cells from a model, as a spreadsheet might. 'param'
+// selects ncplane_putc_yx() per cell (0), ncplane_put_cells() (1), or
+// ncplane_put_egcs() (2). each operation rewrites the entire plane.
+
+static const char* const grid_egcs[] = {
+  "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ".", " ", "-",
+  "€", "✔", "a\xcc\x80\xcc\x81",
+};
+
+#define GRID_EGCS (sizeof(grid_egcs) / sizeof(*grid_egcs))
+
+typedef struct gridstate {
+  struct notcurses* nc;
+  struct ncplane* n;
+  cell* cells;         // the model, loaded against 'n'
+  uint32_t* indices;   // the model, as indices into grid_egcs
+} gridstate;
+
+static void
+grid_teardown(void* state){
+  gridstate* gs = state;
+  if(gs->cells){
+    for(int i = 0 ; i < BENCH_ROWS * BENCH_COLS ; ++i){
+      cell_release(gs->n, &gs->cells[i]);
+    }
+  }
+  free(gs->cells);
+  free(gs->indices);
+  notcurses_stop(gs->nc);
+  free(gs);
+}
+
+static void*
+grid_setup(int param){
+  (void)param;
+  gridstate* gs = calloc(1, sizeof(*gs));
+  if(gs == NULL){
+    return NULL;
+  }
+  if((gs->nc = bench_notcurses()) == NULL){
+    free(gs);
+    return NULL;
+  }
+  if((gs->n = ncplane_new(gs->nc, BENCH_ROWS, BENCH_COLS, 0, 0, NULL)) == NULL){
+    notcurses_stop(gs->nc);
+    free(gs);
+    return NULL;
+  }
+  gs->cells = calloc(BENCH_ROWS * BENCH_COLS, sizeof(*gs->cells));
+  gs->indices = malloc(sizeof(*gs->indices) * BENCH_ROWS * BENCH_COLS);
+  if(gs->cells == NULL || gs->indices == NULL){
+    grid_teardown(gs);
+    return NULL;
+  }
+  uint32_t seed = 1;
+  for(int i = 0 ; i < BENCH_ROWS * BENCH_COLS ; ++i){
+    seed = seed * 1103515245u + 12345u;
+    gs->indices[i] = (seed >> 16) % GRID_EGCS;
+    cell* c = &gs->cells[i];
+    if(cell_load(gs->n, c, grid_egcs[gs->indices[i]]) < 0){
+      grid_teardown(gs);
+      return NULL;
+    }
+    cell_set_fg(c, seed & 0xffffffu);
+  }
+  return gs;
+}
+
+static int
+grid_run(void* state, int param, int first, int ops){
+  gridstate* gs = state;
+  (void)first;
+  for(int op = 0 ; op < ops ; ++op){
+    if(param == 0){
+      for(int y = 0 ; y < BENCH_ROWS ; ++y){
+        for(int x = 0 ; x < BENCH_COLS ; ++x){
+          if(ncplane_putc_yx(gs->n, y, x, &gs->cells[y * BENCH_COLS + x]) < 0){
+            return -1;
+          }
+        }
+      }
+    }else if(param == 1){
+      if(ncplane_put_cells(gs->n, 0, 0, BENCH_ROWS, BENCH_COLS, gs->n,
+                           gs->cells, BENCH_COLS) < 0){
+        return -1;
+      }
+    }else if(ncplane_put_egcs(gs->n, 0, 0, BENCH_ROWS, BENCH_COLS, grid_egcs,
+                              GRID_EGCS, gs->indices, gs->cells,
+                              BENCH_COLS) < 0){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// utf8_egc_len(). 'param' selects ASCII (0) or mixed (1) text. each operation
+// measures a single EGC, cycling through the text.
+
+static const char egclen_ascii[] =
+  "The quick brown fox jumps over the lazy dog, 0123456789 times!";
+static const char egclen_mixed[] =
+  "aé全角▚▞👩‍🔬é̂🇺🇸ज़्☕️각 Ἐν ἀρχῇ ✔ 色は匂へど";
+
+static void*
+egclen_setup(int param){
+  return (void*)(param ? egclen_mixed : egclen_ascii);
+}
+
+static int
+egclen_run(void* state, int param, int first, int ops){
+  const char* text = state;
+  const char* cur = text;
+  (void)param;
+  (void)first;
+  for(int op = 0 ; op < ops ; ++op){
+    if(*cur == '\0'){
+      cur = text;
+    }
+    int cols;
+    int len = utf8_egc_len(cur, &cols);
+    if(len <= 0){
+      return -1;
+    }
+    cur += len;
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// ncvisual_resize(). each operation scales a visual between two sizes. this
+// requires a multimedia engine; without one, the benchmark is skipped.
+
+typedef struct resizestate {
+  uint32_t* rgba;
+  struct ncvisual* ncv;
+} resizestate;
+
+static void
+resize_teardown(void* state){
+  resizestate* rs = state;
+  ncvisual_destroy(rs->ncv);
+  free(rs->rgba);
+  free(rs);
+}
+
+static void*
+resize_setup(int param){
+  (void)param;
+  resizestate* rs = calloc(1, sizeof(*rs));
+  if(rs == NULL){
+    return NULL;
+  }
+  if((rs->rgba = malloc(sizeof(*rs->rgba) * BLITROWS * BLITCOLS)) == NULL){
+    free(rs);
+    return NULL;
+  }
+  for(int i = 0 ; i < BLITROWS * BLITCOLS ; ++i){
+    rs->rgba[i] = 0xff000000ul | (i * 2654435761u >> 8u);
+  }
+  rs->ncv = ncvisual_from_rgba(rs->rgba, BLITROWS, BLITCOLS * sizeof(*rs->rgba),
+                               BLITCOLS);
+  if(rs->ncv == NULL || ncvisual_resize(rs->ncv, BLITROWS / 2, BLITCOLS / 2)){
+    resize_teardown(rs);
+    return NULL;
+  }
+  return rs;
+}
+
+static int
+resize_run(void* state, int param, int first, int ops){
+  resizestate* rs = state;
+  (void)param;
+  for(int op = first ; op < first + ops ; ++op){
+    int rows = op % 2 ? BLITROWS / 2 : BLITROWS;
+    int cols = op % 2 ? BLITCOLS / 2 : BLITCOLS;
+    if(ncvisual_resize(rs->ncv, rows, cols) != NCERR_SUCCESS){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static const benchmark benchmarks[] = {
+  { "render/planes=1", 1, 200, render_setup, render_run, render_warmed, render_extra, render_teardown, },
+  { "render/planes=8", 8, 200, render_setup, render_run, render_warmed, render_extra, render_teardown, },
+  { "render/planes=64", 64, 100, render_setup, render_run, render_warmed, render_extra, render_teardown, },
+  { "render/planes=512", 512, 20, render_setup, render_run, render_warmed, render_extra, render_teardown, },
+  { "rasterize/damage=0", 0, 500, raster_setup, raster_run, render_warmed, render_extra, render_teardown, },
+  { "rasterize/damage=1", 1, 500, raster_setup, raster_run, render_warmed, render_extra, render_teardown, },
+  { "rasterize/damage=10", 10, 200, raster_setup, raster_run, render_warmed, render_extra, render_teardown, },
+  { "rasterize/damage=50", 50, 100, raster_setup, raster_run, render_warmed, render_extra, render_teardown, },
+  { "rasterize/damage=100", 100, 100, raster_setup, raster_run, render_warmed, render_extra, render_teardown, },
+  { "egcpool/live=1024", 1024, 200000, churn_setup, churn_run, NULL, churn_extra, churn_teardown, },
+  { "egcpool/live=65536", 65536, 200000, churn_setup, churn_run, NULL, churn_extra, churn_teardown, },
+  { "egcpool/live=1048576", 1048576, 200000, churn_setup, churn_run, NULL, churn_extra, churn_teardown, },
+  { "blit/1x1", NCBLIT_1x1, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/2x1", NCBLIT_2x1, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/1x1x4", NCBLIT_1x1x4, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/2x2", NCBLIT_2x2, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/4x1", NCBLIT_4x1, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/braille", NCBLIT_BRAILLE, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/8x1", NCBLIT_8x1, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "blit/sixel", NCBLIT_SIXEL, 200, blit_setup, blit_run, NULL, NULL, blit_teardown, },
+  { "puttext", 0, 2000, puttext_setup, puttext_run, NULL, NULL, puttext_teardown, },
+  { "putstr/ascii", 0, 2000, putstr_setup, putstr_run, NULL, NULL, puttext_teardown, },
+  { "putstr/mixed", 1, 2000, putstr_setup, putstr_run, NULL, NULL, puttext_teardown, },
+  { "grid/putc", 0, 200, grid_setup, grid_run, NULL, NULL, grid_teardown, },
+  { "grid/put_cells", 1, 200, grid_setup, grid_run, NULL, NULL, grid_teardown, },
+  { "grid/put_egcs", 2, 200, grid_setup, grid_run, NULL, NULL, grid_teardown, },
+  { "utf8_egc_len/ascii", 0, 1000000, egclen_setup, egclen_run, NULL, NULL, NULL, },
+  { "utf8_egc_len/mixed", 1, 1000000, egclen_setup, egclen_run, NULL, NULL, NULL, },
+  { "ncvisual_resize", 0, 200, resize_setup, resize_run, NULL, NULL, resize_teardown, },
+  { NULL, 0, 0, NULL, NULL, NULL, NULL, NULL, },
+};
+
+static int
+cmp_u64(const void* va, const void* vb){
+  uint64_t a = *(const uint64_t*)va;
+  uint64_t b = *(const uint64_t*)vb;
+  return a < b ? -1 : a > b;
+}
+
+// run 'b' once untimed to warm up, then 'runs' times, timing each run. emits
+// the benchmark's JSON object. returns -1 if it failed after a good setup.
+static int
+run_benchmark(const benchmark* b, FILE* out, int runs, double scale, bool first){
+  fprintf(out, "%s\n    {\"name\":\"%s\"", first ? "" : ",", b->name);
+  int ops = b->ops * scale;
+  if(ops <= 0){
+    ops = 1;
+  }
+  void* state = b->setup(b->param);
+  if(state == NULL){
+    fprintf(out, ",\"skipped\":true}");
+    return 0;
+  }
+  int ret = 0;
+  uint64_t* ns = malloc(sizeof(*ns) * runs);
+  if(ns == NULL || b->run(state, b->param, 0, ops)){
+    ret = -1;
+  }else{
+    if(b->warmed){
+      b->warmed(state);
+    }
+    for(int r = 0 ; r < runs ; ++r){
+      uint64_t start = timenow_ns();
+      if(b->run(state, b->param, ops * (r + 1), ops)){
+        ret = -1;
+        break;
+      }
+      ns[r] = timenow_ns() - start;
+    }
+  }
+  if(ret){
+    fprintf(out, ",\"failed\":true}");
+  }else{
+    qsort(ns, runs, sizeof(*ns), cmp_u64);
+    fprintf(out, ",\"ops\":%d,\"runs\":%d,\"ns_per_op_min\":%.1f"
+            ",\"ns_per_op_median\":%.1f,\"ns_per_op_max\":%.1f",
+            ops, runs, (double)ns[0] / ops, (double)ns[runs / 2] / ops,
+            (double)ns[runs - 1] / ops);
+    if(b->extra){
+      b->extra(state, out, (uint64_t)ops * runs);
+    }
+    fprintf(out, "}");
+  }
+  free(ns);
+  if(b->teardown){
+    b->teardown(state);
+  }
+  return ret;
+}
+
+// a benchmark is selected if no patterns were provided, or its name begins
+// with any of them
+static bool
+selected_p(const benchmark* b, char* const* patterns, int count){
+  if(count == 0){
+    return true;
+  }
+  for(int i = 0 ; i < count ; ++i){
+    if(strncmp(b->name, patterns[i], strlen(patterns[i])) == 0){
+      return true;
+    }
+  }
+  return false;
+}
+
+static void
+usage(const char* exe, int status){
+  FILE* out = status == EXIT_SUCCESS ? stdout : stderr;
+  fprintf(out, "usage: %s [ -hl ] [ -r runs ] [ -s scale ] [ -o jsonfile ] [ prefix... ]\n", exe);
+  fprintf(out, " -h: this message\n");
+  fprintf(out, " -l: list benchmarks and exit\n");
+  fprintf(out, " -r runs: timed runs of each benchmark (default 5)\n");
+  fprintf(out, " -s scale: multiply operations per run by this (default 1)\n");
+  fprintf(out, " -o jsonfile: write results to this file rather than stdout\n");
+  fprintf(out, " prefix: run only benchmarks whose names begin with a prefix\n");
+  exit(status);
+}
+
+int main(int argc, char** argv){
+  if(!setlocale(LC_ALL, "")){
+    fprintf(stderr, "Couldn't set locale\n");
+    return EXIT_FAILURE;
+  }
+  FILE* out = stdout;
+  int runs = 5;
+  double scale = 1;
+  int c;
+  while((c = getopt(argc, argv, "hlr:s:o:")) != EOF){
+    switch(c){
+      case 'h':
+        usage(*argv, EXIT_SUCCESS);
+        break;
+      case 'l':
+        for(const benchmark* b = benchmarks ; b->name ; ++b){
+          printf("%s\n", b->name);
+        }
+        return EXIT_SUCCESS;
+      case 'r':{
+        char* eptr;
+        runs = strtol(optarg, &eptr, 10);
+        if(*eptr || runs <= 0){
+          fprintf(stderr, "Invalid run count: %s\n", optarg);
+          usage(*argv, EXIT_FAILURE);
+        }
+        break;
+      }case 's':{
+        char* eptr;
+        scale = strtod(optarg, &eptr);
+        if(*eptr || scale <= 0){
+          fprintf(stderr, "Invalid scale: %s\n", optarg);
+          usage(*argv, EXIT_FAILURE);
+        }
+        break;
+      }case 'o':
+        if(out != stdout){
+          fprintf(stderr, "Supplied -o twice\n");
+          usage(*argv, EXIT_FAILURE);
+        }
+        if((out = fopen(optarg, "wb")) == NULL){
+          fprintf(stderr, "Error opening %s for JSON (%s?)\n", optarg, strerror(errno));
+          return EXIT_FAILURE;
+        }
+        break;
+      default:
+        usage(*argv, EXIT_FAILURE);
+    }
+  }
+  const char* term = getenv("TERM");
+  fprintf(out, "{\"notcurses-bench\":{\"version\":\"%s\",\"TERM\":\"%s\","
+          "\"rows\":%d,\"cols\":%d,\"benchmarks\":[",
+          notcurses_version(), term ? term : "", BENCH_ROWS, BENCH_COLS);
+  int failed = 0;
+  bool first = true;
+  for(const benchmark* b = benchmarks ; b->name ; ++b){
+    if(!selected_p(b, argv + optind, argc - optind)){
+      continue;
+    }
+    if(run_benchmark(b, out, runs, scale, first)){
+      fprintf(stderr, "Benchmark %s failed\n", b->name);
+      ++failed;
+    }
+    first = false;
+    fflush(out);
+  }
+  fprintf(out, "\n  ]}}\n");
+  if(out != stdout && fclose(out)){
+    fprintf(stderr, "Error writing JSON (%s?)\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -64,6 +64,9 @@ tria_blit_ascii(ncplane* nc, int placey, int placex, int linesize,
       const unsigned char* rgbbase_up = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
       cell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       // use the default for the background, as that's the only way it's
       // effective in that case anyway
       c->channels = 0;
@@ -118,6 +121,9 @@ tria_blit(ncplane* nc, int placey, int placex, int linesize,
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
       cell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       // use the default for the background, as that's the only way it's
       // effective in that case anyway
       c->channels = 0;
@@ -306,6 +312,9 @@ quadrant_blit(ncplane* nc, int placey, int placex, int linesize,
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_tl[0], rgbbase_tr[1], rgbbase_bl[2], rgbbase_br[3]);
       cell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       c->channels = 0;
       c->attrword = 0;
       // FIXME for now, we're only transparent if all four are transparent. we ought
@@ -440,6 +449,9 @@ braille_blit(ncplane* nc, int placey, int placex, int linesize,
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
       cell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       // use the default for the background, as that's the only way it's
       // effective in that case anyway
       c->channels = 0;
@@ -529,6 +541,20 @@ const char* notcurses_str_blitter(ncblitter_e blitter){
   return NULL;
 }
 
+// all blits go through here. the blitters write directly to the framebuffer,
+// so when tracing, we snapshot everything from the origin of the blit onwards.
+static int
+blit_traced(ncplane* nc, const struct blitset* bset, int placey, int placex,
+            int linesize, const void* data, int begy, int begx,
+            int leny, int lenx, bool bgr, bool blendcolors){
+  int ret = bset->blit(nc, placey, placex, linesize, data, begy, begx,
+                       leny, lenx, bgr, blendcolors);
+  if(ret >= 0 && ncplane_traced(nc)){
+    trace_cells(nc, placey, placex, -1, -1);
+  }
+  return ret;
+}
+
 int ncblit_bgrx(const void* data, int linesize, const struct ncvisual_options* vopts){
   if(vopts->flags > NCVISUAL_OPTION_BLEND){
     return -1;
@@ -548,12 +574,12 @@ int ncblit_bgrx(const void* data, int linesize, const struct ncvisual_options* v
   const bool degrade = !(vopts->flags & NCVISUAL_OPTION_NODEGRADE);
   const struct blitset* bset = lookup_blitset(notcurses_canutf8(nc->nc),
                                               vopts->blitter, degrade);
-  if(bset == NULL){
+  if(bset == NULL || bset->blit == NULL){ // FIXME sixel isn't yet implemented
     return -1;
   }
   const bool blend = (vopts->flags & NCVISUAL_OPTION_BLEND);
-  return bset->blit(nc, vopts->y, vopts->x, linesize, data, begy, begx,
-                    leny, lenx, true, blend);
+  return blit_traced(nc, bset, vopts->y, vopts->x, linesize, data, begy, begx,
+                     leny, lenx, true, blend);
 }
 
 int ncblit_rgba(const void* data, int linesize, const struct ncvisual_options* vopts){
@@ -575,17 +601,17 @@ int ncblit_rgba(const void* data, int linesize, const struct ncvisual_options* v
   const bool degrade = !(vopts->flags & NCVISUAL_OPTION_NODEGRADE);
   const struct blitset* bset = lookup_blitset(notcurses_canutf8(nc->nc),
                                               vopts->blitter, degrade);
-  if(bset == NULL){
+  if(bset == NULL || bset->blit == NULL){ // FIXME sixel isn't yet implemented
     return -1;
   }
   const bool blend = (vopts->flags & NCVISUAL_OPTION_BLEND);
-  return bset->blit(nc, vopts->y, vopts->x, linesize, data, begy, begx,
-                    leny, lenx, false, blend);
+  return blit_traced(nc, bset, vopts->y, vopts->x, linesize, data, begy, begx,
+                     leny, lenx, false, blend);
 }
 
 int rgba_blit_dispatch(ncplane* nc, const struct blitset* bset, int placey,
                        int placex, int linesize, const void* data, int begy,
                        int begx, int leny, int lenx, bool blendcolors){
-  return bset->blit(nc, placey, placex, linesize, data, begy, begx,
-                    leny, lenx, false, blendcolors);
+  return blit_traced(nc, bset, placey, placex, linesize, data, begy, begx,
+                     leny, lenx, false, blendcolors);
 }
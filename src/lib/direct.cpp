@@ -276,20 +276,28 @@ ncdirect_dump_plane(ncdirect* n, const ncplane* np, int xoff){
         return -1;
       }
     }
+    // assemble the entire row, and write it out all at once
     for(int x = 0 ; x < dimx ; ++x){
       uint32_t attrword;
       uint64_t channels;
       char* egc = ncplane_at_yx(np, y, x, &attrword, &channels);
       if(egc == nullptr){
+        fbuf_reset(&n->f);
         return -1;
       }
-      ncdirect_fg(n, channels_fg(channels));
-      ncdirect_bg(n, channels_bg(channels));
+      ncdirect_fg_stage(n, channels_fg(channels));
+      ncdirect_bg_stage(n, channels_bg(channels));
 //fprintf(stderr, "%03d/%03d [%s] (%03dx%03d)\n", y, x, egc, dimy, dimx);
-      if(fprintf(n->ttyfp, "%s", strlen(egc) == 0 ? " " : egc) < 0){
+      int r = fbuf_puts(&n->f, strlen(egc) == 0 ? " " : egc);
+      free(egc);
+      if(r < 0){
+        fbuf_reset(&n->f);
         return -1;
       }
     }
+    if(fbuf_flush(&n->f, n->ttyfp)){
+      return -1;
+    }
     if(dimx < totx){
       ncdirect_bg_default(n);
       if(putc('\n', n->ttyfp) == EOF){
@@ -341,7 +349,7 @@ nc_err_e ncdirect_render_image(ncdirect* n, const char* file, ncalign_e align,
   struct ncplane* faken = ncplane_create(nullptr, nullptr,
                                          disprows / encoding_y_scale(bset),
                                          dispcols / encoding_x_scale(bset),
-                                         0, 0, nullptr, nullptr);
+                                         0, 0, nullptr, nullptr, false);
   if(faken == nullptr){
     return NCERR_NOMEM;
   }
@@ -440,6 +448,14 @@ ncdirect* ncdirect_init(const char* termtype, FILE* outfp){
     delete(ret);
     return nullptr;
   }
+  // if the keypad neen't be explicitly enabled, smkx is not present
+  if(ret->tcache.smkx){
+    if(putp(tiparm(ret->tcache.smkx)) != OK){
+      fprintf(stderr, "Error entering keypad transmit mode\n");
+      delete(ret);
+      return nullptr;
+    }
+  }
   ret->fgdefault = ret->bgdefault = true;
   ret->fgrgb = ret->bgrgb = 0;
   ncdirect_styles_set(ret, 0);
@@ -467,63 +483,69 @@ int ncdirect_stop(ncdirect* nc){
     if(nc->ctermfd >= 0){
       ret |= close(nc->ctermfd);
     }
+    fbuf_free(&nc->f);
     delete(nc);
   }
   return ret;
 }
 
+// stage the sgr for 'stylebits', along with any non-default colors (which sgr
+// resets), into the fbuf
 static inline int
-ncdirect_style_emit(ncdirect* n, const char* sgr, unsigned stylebits, FILE* out){
+ncdirect_style_emit(ncdirect* n, const char* sgr, unsigned stylebits, fbuf* out){
   if(sgr == nullptr){
     return -1;
   }
-  int r = term_emit("sgr", tiparm(sgr, stylebits & NCSTYLE_STANDOUT,
-                                  stylebits & NCSTYLE_UNDERLINE,
-                                  stylebits & NCSTYLE_REVERSE,
-                                  stylebits & NCSTYLE_BLINK,
-                                  stylebits & NCSTYLE_DIM,
-                                  stylebits & NCSTYLE_BOLD,
-                                  stylebits & NCSTYLE_INVIS,
-                                  stylebits & NCSTYLE_PROTECT, 0), out, false);
+  int r = fbuf_emit(out, tiparm(sgr, stylebits & NCSTYLE_STANDOUT,
+                                stylebits & NCSTYLE_UNDERLINE,
+                                stylebits & NCSTYLE_REVERSE,
+                                stylebits & NCSTYLE_BLINK,
+                                stylebits & NCSTYLE_DIM,
+                                stylebits & NCSTYLE_BOLD,
+                                stylebits & NCSTYLE_INVIS,
+                                stylebits & NCSTYLE_PROTECT, 0));
   // sgr resets colors, so set them back up if not defaults
   if(r == 0){
     if(!n->fgdefault){
-      r |= ncdirect_fg(n, n->fgrgb);
+      r |= ncdirect_fg_stage(n, n->fgrgb);
     }
     if(!n->bgdefault){
-      r |= ncdirect_bg(n, n->bgrgb);
+      r |= ncdirect_bg_stage(n, n->bgrgb);
     }
   }
   return r;
 }
 
-int ncdirect_styles_on(ncdirect* n, unsigned stylebits){
-  n->attrword |= stylebits;
-  if(ncdirect_style_emit(n, n->tcache.sgr, n->attrword, n->ttyfp)){
+// stage and write out the escapes necessary to reach the current stylebits
+static int
+ncdirect_style_update(ncdirect* n, unsigned stylebits){
+  if(ncdirect_style_emit(n, n->tcache.sgr, n->attrword, &n->f)){
+    fbuf_reset(&n->f);
     return 0;
   }
-  return term_setstyle(n->ttyfp, n->attrword, stylebits, NCSTYLE_ITALIC,
-                       n->tcache.italics, n->tcache.italoff);
+  int ret = term_setstyle(&n->f, n->attrword, stylebits, NCSTYLE_ITALIC,
+                          n->tcache.italics, n->tcache.italoff);
+  if(fbuf_flush(&n->f, n->ttyfp)){
+    ret = -1;
+  }
+  return ret;
+}
+
+int ncdirect_styles_on(ncdirect* n, unsigned stylebits){
+  n->attrword |= stylebits;
+  return ncdirect_style_update(n, stylebits);
 }
 
 // turn off any specified stylebits
 int ncdirect_styles_off(ncdirect* n, unsigned stylebits){
   n->attrword &= ~stylebits;
-  if(ncdirect_style_emit(n, n->tcache.sgr, n->attrword, n->ttyfp)){
-    return 0;
-  }
-  return term_setstyle(n->ttyfp, n->attrword, stylebits, NCSTYLE_ITALIC,
-                       n->tcache.italics, n->tcache.italoff);
+  return ncdirect_style_update(n, stylebits);
 }
 
 // set the current stylebits to exactly those provided
 int ncdirect_styles_set(ncdirect* n, unsigned stylebits){
   n->attrword = stylebits;
-  if(ncdirect_style_emit(n, n->tcache.sgr, n->attrword, n->ttyfp)){
-    return 0;
-  }
-  return term_setstyle(n->ttyfp, n->attrword, stylebits, NCSTYLE_ITALIC,
-                       n->tcache.italics, n->tcache.italoff);
+  return ncdirect_style_update(n, stylebits);
 }
 
 int ncdirect_palette_size(const ncdirect* nc){
@@ -6,43 +6,104 @@
 #include <stdio.h>
 #include <wctype.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include "notcurses/notcurses.h"
+#include "unitables.h"
+// vectorized scans load whole aligned vectors, possibly beyond the end of the
+// string, to which AddressSanitizer (rightly, in general) objects
+#if defined(__AVX2__) && !defined(__SANITIZE_ADDRESS__)
+#include <immintrin.h>
+#define UTF8_SCAN_AVX2
+#elif defined(__SSE2__) && !defined(__SANITIZE_ADDRESS__)
+#include <emmintrin.h>
+#define UTF8_SCAN_SSE2
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// cells only provide storage for a single 7-bit character. if there's anything
-// more than that, it's spilled into the egcpool, and the cell is given an
-// offset. when a cell is released, the memory it owned is zeroed out, and
-// recognizable as use for another cell.
+// cells provide storage for up to four bytes of UTF-8, which covers any single
+// code point. if there's anything more than that, it's spilled into the
+// egcpool, and the cell is given an offset.
+//
+// the pool is carved into slots by advancing 'poolwrite'. each slot is sized
+// to its EGC (plus NUL terminator), up to EGCPOOL_EXACT_BYTES; beyond that,
+// slots are rounded up to a power of two. when a cell is released, its slot
+// is pushed onto the free list for its size, and the next stash of that size
+// pops it, so neither operation depends on the pool's size or fragmentation.
+// a free slot is a NUL, followed by the 24-bit link (offset + 1, 0 ending the
+// list) to the next free slot of its size.
+
+#define EGCPOOL_MIN_SLOT 4     // room for the NUL and link of a free slot
+#define EGCPOOL_EXACT_BYTES 32 // largest slot not rounded to a power of two
+// one class per exact size, then one per power of two through 2^24
+#define EGCPOOL_CLASSES (EGCPOOL_EXACT_BYTES - EGCPOOL_MIN_SLOT + 1 + 24 - 5)
 
 typedef struct egcpool {
-  char* pool;         // ringbuffer of attached extension storage
+  char* pool;         // attached extension storage
   int poolsize;       // total number of bytes in pool
-  int poolused;       // bytes actively used, grow when this gets too large
-  int poolwrite;      // next place to *look for* a place to write
+  int poolused;       // bytes of live EGCs, including their NUL terminators
+  int poolwrite;      // slots have been carved from [0, poolwrite)
+  int poolfree;       // bytes in released slots, awaiting reuse
+  int freelists[EGCPOOL_CLASSES]; // links to the first free slot of each size
 } egcpool;
 
 #define POOL_MINIMUM_ALLOC BUFSIZ
-#define POOL_MAXIMUM_BYTES (1u << 30u) // max 1GB
+#define POOL_MAXIMUM_BYTES (1u << 24u) // max 16MB, as cells hold 24-bit offsets
+
+// the most UTF-8 a cell can hold without recourse to the pool
+#define CELL_INLINE_BYTES 4
+
+// the gcluster of a cell holding the 'len' bytes of 'egc' itself
+static inline uint32_t
+egc_inline(const char* egc, size_t len){
+  uint32_t g = 0;
+  for(size_t i = 0 ; i < len ; ++i){
+    g |= (uint32_t)(unsigned char)egc[i] << (i * 8u);
+  }
+  return g;
+}
+
+// can the 'len' bytes of 'egc' be held within a cell? a four-byte EGC ending
+// in 0x01 cannot, as its gcluster would be taken for a pool offset.
+static inline bool
+egc_inlinable_p(const char* egc, size_t len){
+  if(len < CELL_INLINE_BYTES){
+    return true;
+  }
+  return len == CELL_INLINE_BYTES && (unsigned char)egc[3] != 0x01;
+}
+
+// the length of the EGC held within a cell's 'gcluster'
+static inline int
+egc_inline_len(uint32_t gcluster){
+  return gcluster ? 4 - __builtin_clz(gcluster) / 8 : 0;
+}
+
+// the gcluster of a cell whose EGC was stashed at 'offset'
+static inline uint32_t
+egcpool_gcluster(int offset){
+  return 0x01000000ul | offset;
+}
 
 static inline void
 egcpool_init(egcpool* p){
   memset(p, 0, sizeof(*p));
 }
 
+// grow the pool so that at least 'len' bytes lie beyond poolwrite
 static inline int
 egcpool_grow(egcpool* pool, size_t len){
   size_t newsize = pool->poolsize * 2;
   if(newsize < POOL_MINIMUM_ALLOC){
     newsize = POOL_MINIMUM_ALLOC;
   }
-  while(len > newsize - pool->poolsize){ // ensure we make enough space
+  while(len > newsize - pool->poolwrite){ // ensure we make enough space
     newsize *= 2;
   }
   if(newsize > POOL_MAXIMUM_BYTES){
@@ -59,137 +120,296 @@ egcpool_grow(egcpool* pool, size_t len){
   return 0;
 }
 
-// Eat an EGC from the UTF-8 string input. This consists of extracting a
-// multibyte via mbrtowc, then continuing to extract any which have zero
-// width until hitting another spacing character or a NUL terminator. Writes
-// the number of columns occupied to '*colcount'. Returns the number of bytes
-// consumed, not including any NUL terminator. Note that neither the number
-// of bytes nor columns is necessarily equivalent to the number of decoded code
-// points. Such are the ways of Unicode.
+// ensure that 'len' bytes can be bump-allocated without growing the pool
+static inline int
+egcpool_reserve(egcpool* pool, size_t len){
+  if(len <= (size_t)(pool->poolsize - pool->poolwrite)){
+    return 0;
+  }
+  return egcpool_grow(pool, len);
+}
+
+// Decode the UTF-8 code point at 's' into '*cp'. Returns the number of bytes
+// consumed (0 for the NUL terminator), or -1 if 's' doesn't begin with valid
+// UTF-8 (including overlong forms, surrogates, and truncated sequences). This
+// is independent of the locale.
+static inline int
+utf8_decode(const char* s, uint32_t* cp){
+  const unsigned char* u = (const unsigned char*)s;
+  *cp = u[0];
+  if(u[0] < 0x80){
+    return u[0] ? 1 : 0;
+  }
+  int len;
+  uint32_t min;
+  if(u[0] < 0xc2){ // continuation byte, or overlong two-byte form
+    return -1;
+  }else if(u[0] < 0xe0){
+    len = 2;
+    min = 0x80;
+    *cp &= 0x1f;
+  }else if(u[0] < 0xf0){
+    len = 3;
+    min = 0x800;
+    *cp &= 0x0f;
+  }else if(u[0] < 0xf5){
+    len = 4;
+    min = 0x10000;
+    *cp &= 0x07;
+  }else{
+    return -1;
+  }
+  for(int i = 1 ; i < len ; ++i){
+    if((u[i] & 0xc0) != 0x80){ // this catches a premature NUL, too
+      return -1;
+    }
+    *cp = (*cp << 6u) | (u[i] & 0x3f);
+  }
+  if(*cp < min || *cp > 0x10ffff || (*cp >= 0xd800 && *cp <= 0xdfff)){
+    return -1;
+  }
+  return len;
+}
+
+// The number of columns occupied by code point 'cp', as looked up in the
+// tables generated by tools/unitables.py. Like wcwidth(), returns 0 for those
+// which combine with their predecessor, and -1 for those which aren't drawn
+// (controls, separators, and unassigned code points). Unlike wcwidth(), this
+// doesn't depend on the locale, nor on the libc's Unicode tables.
+static inline int
+ucs_width(uint32_t cp){
+  if(cp >= 0x110000){
+    return -1;
+  }
+  const uint8_t* block = ucs_width_stage2[ucs_width_stage1[cp >> UCS_WIDTH_BLOCKBITS]];
+  const unsigned idx = cp & ((1u << UCS_WIDTH_BLOCKBITS) - 1);
+  const int w = (block[idx / 4] >> ((idx % 4) * 2)) & 0x3;
+  return w == 3 ? -1 : w;
+}
+
+// The number of bytes at the start of 's' which are printable ASCII (0x20
+// through 0x7e), each of which is an EGC of a single column. Where SSE2 or
+// AVX2 is available, sixteen or thirty-two bytes are checked at a time. Once
+// 's' is suitably aligned, such loads can't cross a page boundary, and thus
+// can't fault even when reading past the NUL terminator.
+static inline size_t
+utf8_ascii_run(const char* s){
+  size_t n = 0;
+#if defined(UTF8_SCAN_AVX2) || defined(UTF8_SCAN_SSE2)
+#ifdef UTF8_SCAN_AVX2
+  const size_t vecbytes = 32;
+#else
+  const size_t vecbytes = 16;
+#endif
+  while((uintptr_t)(s + n) % vecbytes){
+    if(s[n] < 0x20 || s[n] > 0x7e){ // char may be signed, making >= 0x80 negative
+      return n;
+    }
+    ++n;
+  }
+#ifdef UTF8_SCAN_AVX2
+  const __m256i ctrl = _mm256_set1_epi8(0x1f);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  for( ; ; n += vecbytes){
+    // compared as signed bytes, those >= 0x80 are negative, and fail the first
+    const __m256i v = _mm256_load_si256((const __m256i*)(s + n));
+    const __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(v, ctrl),
+                                        _mm256_cmpgt_epi8(del, v));
+    const uint32_t mask = _mm256_movemask_epi8(ok);
+    if(mask != 0xfffffffful){
+      return n + __builtin_ctz(~mask);
+    }
+  }
+#else
+  const __m128i ctrl = _mm_set1_epi8(0x1f);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  for( ; ; n += vecbytes){
+    // compared as signed bytes, those >= 0x80 are negative, and fail the first
+    const __m128i v = _mm_load_si128((const __m128i*)(s + n));
+    const __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, ctrl),
+                                     _mm_cmpgt_epi8(del, v));
+    const unsigned mask = _mm_movemask_epi8(ok);
+    if(mask != 0xffffu){
+      return n + __builtin_ctz(~mask);
+    }
+  }
+#endif
+#else
+  while(s[n] >= 0x20 && s[n] <= 0x7e){
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// Eat an EGC from the UTF-8 string input. This consists of decoding a code
+// point, then continuing to decode any which have zero width until hitting
+// another spacing character or a NUL terminator. Writes the number of columns
+// occupied to '*colcount'. Returns the number of bytes consumed, not including
+// any NUL terminator. Note that neither the number of bytes nor columns is
+// necessarily equivalent to the number of decoded code points. Such are the
+// ways of Unicode. Neither decoding nor widths depend on the locale.
 static inline int
 utf8_egc_len(const char* gcluster, int* colcount){
-  size_t ret = 0;
+  // printable ASCII followed by anything ASCII (which can't extend it) is by
+  // far the most common case, and needn't be decoded
+  const unsigned char* u = (const unsigned char*)gcluster;
+  if(u[0] >= 0x20 && u[0] < 0x7f && u[1] < 0x80){
+    *colcount = 1;
+    return 1;
+  }
+  int ret = 0;
   *colcount = 0;
-  wchar_t wc;
+  uint32_t cp;
   int r;
-  mbstate_t mbt;
-  memset(&mbt, 0, sizeof(mbt));
-  do{
-    r = mbrtowc(&wc, gcluster, MB_CUR_MAX, &mbt);
+  while( (r = utf8_decode(gcluster + ret, &cp)) ){
     if(r < 0){
       return -1;
-    }else if(r){
-      int cols = wcwidth(wc);
-      if(cols){
-        if(*colcount){ // this must be starting a new EGC, exit and do not claim
-          break;
-        }
-        if(cols < 0){
-          if(iswspace(wc)){ // newline or tab
-            return ret + 1;
-          }
-          cols = 0;
+    }
+    int cols = ucs_width(cp);
+    if(cols){
+      if(*colcount){ // this must be starting a new EGC, exit and do not claim
+        break;
+      }
+      if(cols < 0){
+        // whitespace (newlines, tabs, separators) stands alone
+        if((cp >= '\t' && cp <= '\r') || cp == 0x2028 || cp == 0x2029){
+          return ret + r;
         }
-        *colcount += cols;
+        cols = 0;
       }
-      ret += r;
-      gcluster += r;
+      *colcount += cols;
     }
-  }while(r);
+    ret += r;
+  }
   return ret;
 }
 
-// if we're inserting a EGC of |len| bytes, ought we proactively realloc?
-static inline bool
-egcpool_alloc_justified(const egcpool* pool, int len){
-  const int poolfree = pool->poolsize - pool->poolused;
-  // proactively get more space if we have less than 10% free. this doesn't
-  // guarantee that we'll have enough space to insert the string -- we could
-  // theoretically have every 10th byte free, and be unable to write even a
-  // two-byte egc -- so we might have to allocate after an expensive search :/.
-  if(poolfree >= len && poolfree * 10 > pool->poolsize){
-    return false;
+// the size of the slot holding an EGC of 'len' bytes (including its NUL)
+static inline int
+egcpool_slot_bytes(int len){
+  if(len < EGCPOOL_MIN_SLOT){
+    return EGCPOOL_MIN_SLOT;
   }
-  return true;
+  if(len <= EGCPOOL_EXACT_BYTES){
+    return len;
+  }
+  return 1 << (32 - __builtin_clz(len - 1));
+}
+
+// the free list for slots of 'slot' bytes (as returned by egcpool_slot_bytes())
+static inline int
+egcpool_class(int slot){
+  if(slot <= EGCPOOL_EXACT_BYTES){
+    return slot - EGCPOOL_MIN_SLOT;
+  }
+  // the first power of two past EGCPOOL_EXACT_BYTES is 2^6
+  return EGCPOOL_EXACT_BYTES - EGCPOOL_MIN_SLOT + 1 + (31 - __builtin_clz(slot)) - 6;
+}
+
+// the size of the slots on free list 'sizeclass'
+static inline int
+egcpool_class_bytes(int sizeclass){
+  if(sizeclass <= EGCPOOL_EXACT_BYTES - EGCPOOL_MIN_SLOT){
+    return sizeclass + EGCPOOL_MIN_SLOT;
+  }
+  return 1 << (sizeclass - (EGCPOOL_EXACT_BYTES - EGCPOOL_MIN_SLOT + 1) + 6);
+}
+
+// release the slot of 'slot' bytes at 'offset' to its free list
+static inline void
+egcpool_push(egcpool* pool, int offset, int slot){
+  const int sizeclass = egcpool_class(slot);
+  const unsigned link = pool->freelists[sizeclass];
+  unsigned char* s = (unsigned char*)pool->pool + offset;
+  s[0] = '\0';
+  s[1] = link & 0xffu;
+  s[2] = (link >> 8u) & 0xffu;
+  s[3] = (link >> 16u) & 0xffu;
+  pool->freelists[sizeclass] = offset + 1;
+  pool->poolfree += slot;
+}
+
+// take the first slot from free list 'sizeclass', which must not be empty
+static inline int
+egcpool_pop(egcpool* pool, int sizeclass){
+  const int offset = pool->freelists[sizeclass] - 1;
+  const unsigned char* s = (const unsigned char*)pool->pool + offset;
+  pool->freelists[sizeclass] = s[1] | (s[2] << 8u) | (s[3] << 16u);
+  pool->poolfree -= egcpool_class_bytes(sizeclass);
+  return offset;
+}
+
+// the pool can't grow, and there's no free slot of the size we want. take
+// one from the first larger size available, releasing what we don't need as
+// slots of up to EGCPOOL_EXACT_BYTES. any tail too small to be a slot is lost
+// until the pool is dumped.
+static inline int
+egcpool_carve(egcpool* pool, int slot){
+  for(int sizeclass = egcpool_class(slot) + 1 ; sizeclass < EGCPOOL_CLASSES ; ++sizeclass){
+    if(pool->freelists[sizeclass]){
+      const int offset = egcpool_pop(pool, sizeclass);
+      int tail = offset + slot;
+      int remains = egcpool_class_bytes(sizeclass) - slot;
+      while(remains >= EGCPOOL_MIN_SLOT){
+        int piece = remains;
+        if(piece > EGCPOOL_EXACT_BYTES){
+          piece = EGCPOOL_EXACT_BYTES;
+          if(remains - piece < EGCPOOL_MIN_SLOT){
+            piece /= 2; // don't leave an unusable sliver
+          }
+        }
+        egcpool_push(pool, tail, piece);
+        tail += piece;
+        remains -= piece;
+      }
+      return offset;
+    }
+  }
+  return -1;
 }
 
 // stash away the provided UTF8, NUL-terminated grapheme cluster. the cluster
-// should not be less than 2 bytes (such a cluster should be directly stored in
-// the cell). returns -1 on error, and otherwise a non-negative offset. 'ulen'
-// must be the number of bytes to lift from egc (utf8_egc_len()).
+// should not satisfy egc_inlinable_p() (such clusters ought be stored
+// directly in the cell, using egc_inline()). returns -1 on error, and
+// otherwise a non-negative offset. 'ulen' must be the number of bytes to lift
+// from egc (utf8_egc_len()).
 __attribute__ ((nonnull (1, 2))) static inline int
 egcpool_stash(egcpool* pool, const char* egc, size_t ulen){
-  int len = ulen + 1; // count the NUL terminator
-  if(len <= 2){ // should never be empty, nor a single byte + NUL
+  if(ulen < 2 || ulen >= POOL_MAXIMUM_BYTES){ // never empty, nor a single byte
     return -1;
   }
-  // the first time through, we don't force a grow unless we expect ourselves
-  // to have too little space. once we've done a search, we do force the grow.
-  // we should thus never have more than two iterations of this loop.
-  bool searched = false;
-  // we might have to realloc our underlying pool. it is possible that this EGC
-  // is actually *in* that pool, in which case our pointer will be invalidated.
-  // to be safe, duplicate prior to a realloc, and free along all paths.
-  char* duplicated = NULL;
-  do{
-    if(egcpool_alloc_justified(pool, len) || searched){
-      if(!duplicated){
-        if((duplicated = strndup(egc, ulen)) == NULL){
-          return -1;
-        }
-      }
-      if(egcpool_grow(pool, len) && searched){
-        free(duplicated);
-        return -1;
-      }
-      egc = duplicated;
+  const int len = ulen + 1; // count the NUL terminator
+  const int slot = egcpool_slot_bytes(len);
+  const int sizeclass = egcpool_class(slot);
+  int offset;
+  if(pool->freelists[sizeclass]){
+    offset = egcpool_pop(pool, sizeclass);
+  }else if(pool->poolsize - pool->poolwrite >= slot){
+    offset = pool->poolwrite;
+    pool->poolwrite += slot;
+  }else{
+    // the EGC might live in the pool itself, in which case a realloc would
+    // invalidate it. we'll need to rebase it if so.
+    ptrdiff_t inpool = -1;
+    if((uintptr_t)egc >= (uintptr_t)pool->pool &&
+       (uintptr_t)egc < (uintptr_t)pool->pool + pool->poolsize){
+      inpool = egc - pool->pool;
     }
-    // we now look for a place to lay out this egc. we need |len| zeroes in a
-    // row. starting at pool->poolwrite, look for such a range of unused
-    // memory. if we find it, write it out, and update used count. if we come
-    // back to where we started, force a growth and try again.
-    int curpos = pool->poolwrite;
-//fprintf(stderr, "Stashing [%s] %d starting at %d\n", egc, len, curpos);
-    do{
-      if(curpos == pool->poolsize){
-        curpos = 0;
+    if(egcpool_grow(pool, slot) == 0){
+      if(inpool >= 0){
+        egc = pool->pool + inpool;
       }
-      if(pool->pool[curpos]){ // can't write if there's stuff here
-        ++curpos;
-      }else if(curpos && pool->pool[curpos - 1]){ // don't kill someone's NUL
-        ++curpos;
-      }else if(pool->poolsize - curpos < len){ // can't wrap around
-        if(pool->poolwrite > curpos){
-          break;
-        }
-        curpos = 0; // can this skip pool->poolwrite?
-      }else{ // promising! let's see if there's enough space
-        int need = len;
-        size_t trial = curpos;
-        while(--need){
-          if(pool->pool[++trial]){ // alas, not enough space here
-            break;
-          }
-        }
-        if(need == 0){ // found a suitable space, copy it!
-          memcpy(pool->pool + curpos, egc, len - 1);
-          pool->pool[curpos + len - 1] = '\0';
-          pool->poolwrite = curpos + len;
-          pool->poolused += len;
-          free(duplicated);
-//fprintf(stderr, "Stashing AT %d\n", curpos);
-          return curpos;
-        }
-        if(pool->poolwrite > curpos && pool->poolwrite - (len - need) < curpos){
-          break;
-        }
-        curpos += len - need;
-      }
-    }while(curpos != pool->poolwrite);
-  }while( (searched = !searched) );
-  free(duplicated);
-  assert(false);
-  return -1; // should never get here
+      offset = pool->poolwrite;
+      pool->poolwrite += slot;
+    }else if((offset = egcpool_carve(pool, slot)) < 0){
+      return -1;
+    }
+  }
+  memcpy(pool->pool + offset, egc, ulen);
+  pool->pool[offset + ulen] = '\0';
+  pool->poolused += len;
+  return offset;
 }
 
 // Run a consistency check on the offset; ensure it's a valid, non-empty EGC.
@@ -204,14 +424,12 @@ egcpool_check_validity(const egcpool* pool, int offset){
     fprintf(stderr, "Bad offset 0x%06x: empty\n", offset);
     return false;
   }
-  mbstate_t mbstate;
-  memset(&mbstate, 0, sizeof(mbstate));
   do{
-    wchar_t wcs;
-    int r = mbrtowc(&wcs, egc, strlen(egc), &mbstate);
+    uint32_t cp;
+    int r = utf8_decode(egc, &cp);
     if(r < 0){
-      fprintf(stderr, "Invalid UTF8 at offset 0x%06x, len %zu [%s]\n",
-              offset, strlen(egc), strerror(errno));
+      fprintf(stderr, "Invalid UTF8 at offset 0x%06x, len %zu\n",
+              offset, strlen(egc));
       return false;
     }
     egc += r;
@@ -219,38 +437,56 @@ egcpool_check_validity(const egcpool* pool, int offset){
   return true;
 }
 
-// remove the egc from the pool. start at offset, and zero out everything until
-// we find a zero (our own NUL terminator). remove that number of bytes from
-// the usedcount.
+// remove the egc at 'offset' from the pool, returning its slot to the free
+// list for its size.
 static inline void
 egcpool_release(egcpool* pool, int offset){
-  size_t freed = 1; // account for free(d) NUL terminator
   assert(egcpool_check_validity(pool, offset));
-  while(pool->pool[offset]){
-    pool->pool[offset] = '\0';
-    ++freed;
-    ++offset;
-    assert(offset < pool->poolsize);
-  }
-  pool->poolused -= freed;
-  // FIXME ought we update pool->poolwrite?
+  const int len = strlen(pool->pool + offset) + 1;
+  pool->poolused -= len;
+  egcpool_push(pool, offset, egcpool_slot_bytes(len));
 }
 
 static inline void
 egcpool_dump(egcpool* pool){
   free(pool->pool);
-  pool->pool = NULL;
-  pool->poolsize = 0;
-  pool->poolwrite = 0;
-  pool->poolused = 0;
+  egcpool_init(pool);
 }
 
+// the EGC of 'c', which must not be simple
 __attribute__ ((__returns_nonnull__)) static inline const char*
 egcpool_extended_gcluster(const egcpool* pool, const cell* c) {
   uint32_t idx = cell_egc_idx(c);
   return pool->pool + idx;
 }
 
+// ought the pool be compacted? only once released slots make up the majority
+// of those carved, and there are enough of them to be worth the bother.
+static inline bool
+egcpool_fragmented_p(const egcpool* pool){
+  return pool->poolfree >= POOL_MINIMUM_ALLOC &&
+         pool->poolfree > pool->poolwrite - pool->poolfree;
+}
+
+// the bytes which the EGC of 'c' would occupy in a compacted pool
+static inline int
+egcpool_compacted_bytes(const egcpool* pool, const cell* c){
+  if(cell_simple_p(c)){
+    return 0;
+  }
+  return egcpool_slot_bytes(strlen(egcpool_extended_gcluster(pool, c)) + 1);
+}
+
+// copy the EGC of 'c' from 'src' to 'dst', rewriting its offset. 'dst' must
+// already have room for it beyond its poolwrite (see egcpool_compacted_bytes()).
+static inline void
+egcpool_move(egcpool* dst, const egcpool* src, cell* c){
+  if(!cell_simple_p(c)){
+    const char* egc = egcpool_extended_gcluster(src, c);
+    c->gcluster = egcpool_gcluster(egcpool_stash(dst, egc, strlen(egc)));
+  }
+}
+
 // Duplicate the contents of EGCpool 'src' onto another, wiping out any prior
 // contents in 'dst'.
 static inline int
@@ -263,6 +499,8 @@ egcpool_dup(egcpool* dst, const egcpool* src){
   dst->poolsize = src->poolsize;
   dst->poolused = src->poolused;
   dst->poolwrite = src->poolwrite;
+  dst->poolfree = src->poolfree;
+  memcpy(dst->freelists, src->freelists, sizeof(dst->freelists));
   memcpy(dst->pool, src->pool, src->poolsize);
   return 0;
 }
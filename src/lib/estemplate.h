@@ -0,0 +1,114 @@
+#ifndef NOTCURSES_ESTEMPLATE
+#define NOTCURSES_ESTEMPLATE
+
+#include <stdbool.h>
+#include "fbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// terminfo capabilities are little programs, run by tiparm() for each use.
+// tiparm() is a general interpreter, and far too slow for the rendering hot
+// path. most capabilities we emit are simple, though: literal text with some
+// parameters printed as decimals (possibly offset by a constant, or by %i), or
+// as characters. we compile these at startup into an estemplate, a sequence of
+// literals and numeric slots, which can be expanded without interpretation.
+// capabilities doing anything more interesting (conditionals, other formats,
+// etc.) are left invalid, and must still go through tiparm().
+#define ESTEMPLATE_SLOTS 4
+#define ESTEMPLATE_LITERALS 40
+// longest possible expansion: all literals, and slots of "-2147483648"
+#define ESTEMPLATE_MAXLEN (ESTEMPLATE_LITERALS + ESTEMPLATE_SLOTS * 11)
+
+typedef struct esslot {
+  unsigned char param; // 0-based index of the parameter printed here
+  signed char delta;   // added to the parameter before printing it
+  bool chr;            // print as a character (%c) rather than decimal (%d)
+} esslot;
+
+typedef struct estemplate {
+  bool valid;                       // did the capability compile?
+  unsigned char slots;              // number of slots in use
+  unsigned char params;             // parameters consumed (highest %p)
+  // lit[] holds each literal run, back to back. litlen[i] is the length of the
+  // run preceding slot i; litlen[slots] is that of the trailing run.
+  unsigned char litlen[ESTEMPLATE_SLOTS + 1];
+  char lit[ESTEMPLATE_LITERALS];
+  esslot slot[ESTEMPLATE_SLOTS];
+} estemplate;
+
+// compile the terminfo capability 'cap' (which may be NULL). 't' is left
+// invalid if 'cap' is NULL, or uses anything beyond the supported subset.
+void estemplate_compile(estemplate* t, const char* cap);
+
+// write the decimal form of 'v' into 'buf', returning the number of bytes
+static inline int
+estemplate_itoa(char* buf, int v){
+  char tmp[11];
+  unsigned u = v < 0 ? -(unsigned)v : (unsigned)v;
+  int len = 0;
+  do{
+    tmp[len++] = '0' + u % 10;
+    u /= 10;
+  }while(u);
+  int w = 0;
+  if(v < 0){
+    buf[w++] = '-';
+  }
+  while(len){
+    buf[w++] = tmp[--len];
+  }
+  return w;
+}
+
+// expand 't' with the parameters 'p' into 'buf', which must have room for
+// ESTEMPLATE_MAXLEN bytes. 't' must be valid. returns the length of the
+// expansion, which is not NUL-terminated.
+static inline int
+estemplate_expand(const estemplate* t, char* buf, const int* p){
+  const char* lit = t->lit;
+  int w = 0;
+  for(unsigned s = 0 ; s < t->slots ; ++s){
+    memcpy(buf + w, lit, t->litlen[s]);
+    w += t->litlen[s];
+    lit += t->litlen[s];
+    int v = p[t->slot[s].param] + t->slot[s].delta;
+    if(t->slot[s].chr){
+      buf[w++] = v;
+    }else{
+      w += estemplate_itoa(buf + w, v);
+    }
+  }
+  memcpy(buf + w, lit, t->litlen[t->slots]);
+  return w + t->litlen[t->slots];
+}
+
+static inline int
+estemplate_emit(fbuf* f, const estemplate* t, const int* p){
+  if(fbuf_reserve(f, ESTEMPLATE_MAXLEN)){
+    return -1;
+  }
+  f->used += estemplate_expand(t, f->buf + f->used, p);
+  return 0;
+}
+
+// capabilities which can't be compiled, but are only ever used with small
+// parameters (setaf and setab, with palette indices), are instead expanded
+// for each possible parameter at startup.
+#define ESTABLE_ENTRIES 256
+
+typedef struct estable {
+  unsigned char len[ESTABLE_ENTRIES]; // 0 where no expansion is available
+  char seq[ESTABLE_ENTRIES][23];
+} estable;
+
+// expand the single-parameter capability 'cap' (which may be NULL) for each
+// parameter less than 'count' (at most ESTABLE_ENTRIES).
+void estable_fill(estable* table, const char* cap, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
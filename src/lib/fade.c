@@ -35,7 +35,7 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   int y, x;
   for(y = 0 ; y < pp->rows ; ++y){
     for(x = 0 ; x < pp->cols ; ++x){
-      channels = n->fb[nfbcellidx(n, y, x)].channels;
+      channels = ncplane_row(n, y)[x].channels;
       pp->channels[y * pp->cols + x] = channels;
       channels_fg_rgb(channels, &r, &g, &b);
       if(r > pp->maxr){
@@ -113,13 +113,19 @@ int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
   // possibility of a resize event :/
   int dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
+  ncplane_dirty(n);
   for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
+    // a sparse plane's missing rows have only default colors; leave them be
+    cell* row = ncplane_row_present(n, y);
+    if(row == NULL){
+      continue;
+    }
     for(x = 0 ; x < nctx->cols && x < dimx; ++x){
       unsigned r, g, b;
       channels_fg_rgb(nctx->channels[nctx->cols * y + x], &r, &g, &b);
       unsigned br, bg, bb;
       channels_bg_rgb(nctx->channels[nctx->cols * y + x], &br, &bg, &bb);
-      cell* c = &n->fb[dimx * y + x];
+      cell* c = &row[x];
       if(!cell_fg_default_p(c)){
         r = r * iter / nctx->maxsteps;
         g = g * iter / nctx->maxsteps;
@@ -134,6 +140,9 @@ int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
       }
     }
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, 0, 0, nctx->rows, nctx->cols);
+  }
   uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
   struct timespec sleepspec;
   sleepspec.tv_sec = nextwake / NANOSECS_IN_SEC;
@@ -180,9 +189,15 @@ int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
   // possibility of a resize event :/
   int dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
+  ncplane_dirty(n);
   for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
+    // a sparse plane's missing rows have only default colors; leave them be
+    cell* row = ncplane_row_present(n, y);
+    if(row == NULL){
+      continue;
+    }
     for(x = 0 ; x < nctx->cols && x < dimx; ++x){
-      cell* c = &n->fb[dimx * y + x];
+      cell* c = &row[x];
       if(!cell_fg_default_p(c)){
         channels_fg_rgb(nctx->channels[nctx->cols * y + x], &r, &g, &b);
         r = r * (nctx->maxsteps - iter) / nctx->maxsteps;
@@ -214,6 +229,10 @@ int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
     bb = bb * (nctx->maxsteps - iter) / nctx->maxsteps;
     cell_set_bg_rgb(&n->basecell, br, bg, bb);
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, 0, 0, nctx->rows, nctx->cols);
+    trace_base(n);
+  }
   uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
   struct timespec sleepspec;
   sleepspec.tv_sec = nextwake / NANOSECS_IN_SEC;
@@ -0,0 +1,119 @@
+#ifndef NOTCURSES_FBUF
+#define NOTCURSES_FBUF
+
+#include <stdio.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// an append-only byte buffer into which output is assembled. it replaces
+// stdio (and its per-call locking and bookkeeping) on the hot output paths.
+// it is reset, but never shrunk, between uses, so that a steady state of
+// rendering performs no allocation. its contents are not NUL-terminated.
+typedef struct fbuf {
+  char* buf;    // contents, NULL until the first write
+  size_t used;  // bytes currently written
+  size_t size;  // bytes allocated
+} fbuf;
+
+// initial allocation, sufficient for a typical frame's worth of updates
+#define FBUF_INITIAL_SIZE 16384
+
+// make room for at least 'n' more bytes, doubling as necessary
+static inline int
+fbuf_reserve(fbuf* f, size_t n){
+  if(f->used + n <= f->size){
+    return 0;
+  }
+  size_t size = f->size ? f->size : FBUF_INITIAL_SIZE;
+  while(f->used + n > size){
+    size *= 2;
+  }
+  char* tmp = (char*)realloc(f->buf, size);
+  if(tmp == NULL){
+    return -1;
+  }
+  f->buf = tmp;
+  f->size = size;
+  return 0;
+}
+
+static inline int
+fbuf_putc(fbuf* f, char c){
+  if(f->used == f->size){
+    if(fbuf_reserve(f, 1)){
+      return -1;
+    }
+  }
+  f->buf[f->used++] = c;
+  return 0;
+}
+
+static inline int
+fbuf_putn(fbuf* f, const char* s, size_t len){
+  if(fbuf_reserve(f, len)){
+    return -1;
+  }
+  memcpy(f->buf + f->used, s, len);
+  f->used += len;
+  return 0;
+}
+
+static inline int
+fbuf_puts(fbuf* f, const char* s){
+  return fbuf_putn(f, s, strlen(s));
+}
+
+// append a (terminfo-derived) escape sequence. a NULL 'seq' is an error, as
+// it indicates that the terminal lacks the capability.
+static inline int
+fbuf_emit(fbuf* f, const char* seq){
+  if(seq == NULL){
+    return -1;
+  }
+  return fbuf_puts(f, seq);
+}
+
+static inline void
+fbuf_reset(fbuf* f){
+  f->used = 0;
+}
+
+// write the entirety of the contents to 'fp' (with a single call, unless the
+// descriptor is nonblocking and fills up), and reset.
+static inline int
+fbuf_flush(fbuf* f, FILE* fp){
+  int ret = 0;
+  size_t written = 0;
+  while(written < f->used){
+    written += fwrite(f->buf + written, 1, f->used - written, fp);
+    if(written < f->used){
+      if(errno != EAGAIN){
+        ret = -1;
+        break;
+      }
+      clearerr(fp);
+    }
+  }
+  fbuf_reset(f);
+  return ret;
+}
+
+static inline void
+fbuf_free(fbuf* f){
+  free(f->buf);
+  f->buf = NULL;
+  f->used = 0;
+  f->size = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,9 +1,12 @@
 #include "internal.h"
 
+// a sparse plane's missing tiles are left blank
 void ncplane_greyscale(ncplane *n){
-  for(int y = 0 ; y < n->leny ; ++y){
-    for(int x = 0 ; x < n->lenx ; ++x){
-      cell* c = &n->fb[nfbcellidx(n, y, x)];
+  ncplane_dirty(n);
+  for(int chunk = 0 ; chunk < ncplane_chunkcount(n) ; ++chunk){
+    int cells;
+    cell* c = ncplane_chunk(n, chunk, &cells);
+    for(int i = 0 ; c && i < cells ; ++i, ++c){
       unsigned r, g, b;
       cell_fg_rgb(c, &r, &g, &b);
       int gy = rgb_greyscale(r, g, b);
@@ -13,6 +16,9 @@ void ncplane_greyscale(ncplane *n){
       cell_set_bg_rgb(c, gy, gy, gy);
     }
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, 0, 0, -1, -1);
+  }
 }
 
 // if this is not polyfillable cell, we return 0. if it is, we attempt to fill
@@ -27,7 +33,10 @@ ncplane_polyfill_recurse(ncplane* n, int y, int x, const cell* c, const char* ta
   if(y < 0 || x < 0){
     return 0; // not fillable
   }
-  cell* cur = &n->fb[nfbcellidx(n, y, x)];
+  cell* cur = ncplane_cell_ref_yx(n, y, x);
+  if(cur == NULL){
+    return -1;
+  }
   char* glust = cell_strdup(n, cur);
 //fprintf(stderr, "checking %d/%d (%s) for [%s]\n", y, x, glust, targ);
   if(strcmp(glust, targ)){
@@ -69,7 +78,7 @@ int ncplane_polyfill_yx(ncplane* n, int y, int x, const cell* c){
       if(y < 0 || x < 0){
         return -1; // not fillable
       }
-      cell* cur = &n->fb[nfbcellidx(n, y, x)];
+      const cell* cur = &ncplane_row(n, y)[x];
       char* targ = cell_strdup(n, cur);
       char* fillegc = cell_strdup(n, c);
       if(strcmp(fillegc, targ) == 0){
@@ -80,6 +89,10 @@ int ncplane_polyfill_yx(ncplane* n, int y, int x, const cell* c){
       free(fillegc);
       ret = ncplane_polyfill_recurse(n, y, x, c, targ);
       free(targ);
+      // the fill can reach anywhere, so take the whole plane
+      if(ret > 0 && ncplane_traced(n)){
+        trace_cells(n, 0, 0, -1, -1);
+      }
     }
   }
   return ret;
@@ -175,6 +188,9 @@ int ncplane_highgradient(ncplane* n, uint32_t ul, uint32_t ur,
   for(int y = yoff ; y <= ystop ; ++y){
     for(int x = xoff ; x <= xstop ; ++x){
       cell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       targc->channels = 0;
       if(cell_load(n, targc, "▀") < 0){
         return -1;
@@ -183,6 +199,9 @@ int ncplane_highgradient(ncplane* n, uint32_t ul, uint32_t ur,
       ++total;
     }
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, yoff, xoff, ystop - yoff + 1, xstop - xoff + 1);
+  }
   return total;
 }
 
@@ -230,6 +249,9 @@ int ncplane_gradient(ncplane* n, const char* egc, uint32_t attrword,
   for(int y = yoff ; y <= ystop ; ++y){
     for(int x = xoff ; x <= xstop ; ++x){
       cell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       targc->channels = 0;
       if(cell_load(n, targc, egc) < 0){
         return -1;
@@ -240,6 +262,9 @@ int ncplane_gradient(ncplane* n, const char* egc, uint32_t attrword,
       ++total;
     }
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, yoff, xoff, ystop - yoff + 1, xstop - xoff + 1);
+  }
   return total;
 }
 
@@ -269,6 +294,9 @@ int ncplane_stain(struct ncplane* n, int ystop, int xstop,
   for(int y = yoff ; y <= ystop ; ++y){
     for(int x = xoff ; x <= xstop ; ++x){
       cell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       if(targc->gcluster){
         calc_gradient_channels(&targc->channels, tl, tr, bl, br,
                               y - yoff, x - xoff, ylen, xlen);
@@ -276,6 +304,9 @@ int ncplane_stain(struct ncplane* n, int ystop, int xstop,
       ++total;
     }
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, yoff, xoff, ystop - yoff + 1, xstop - xoff + 1);
+  }
   return total;
 }
 
@@ -298,10 +329,16 @@ int ncplane_format(struct ncplane* n, int ystop, int xstop, uint32_t attrword){
   for(int y = yoff ; y < ystop + 1 ; ++y){
     for(int x = xoff ; x < xstop + 1 ; ++x){
       cell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       targc->attrword = attrword;
       ++total;
     }
   }
+  if(ncplane_traced(n)){
+    trace_cells(n, yoff, xoff, ystop - yoff + 1, xstop - xoff + 1);
+  }
   return total;
 }
 
@@ -309,13 +346,13 @@ int ncplane_format(struct ncplane* n, int ystop, int xstop, uint32_t attrword){
 // the background. if we're a full block, set both to the foreground.
 static int
 rotate_channels(ncplane* src, const cell* c, uint32_t* fchan, uint32_t* bchan){
-  if(cell_simple_p(c)){
+  if(cell_ascii_p(c)){
     if(!isgraph(c->gcluster)){
       *fchan = *bchan;
     }
     return 0;
   }
-  const char* origc = cell_extended_gcluster(src, c);
+  const char* origc = extended_gcluster(src, c);
   if(strcmp(origc, "▄") == 0 || strcmp(origc, "▀") == 0){
     uint32_t tmp = *fchan;
     *fchan = *bchan;
@@ -444,13 +481,16 @@ rotate_merge(ncplane* n, ncplane* newp){
   if(ret == 0){
     for(int y = 0 ; y < dimy ; ++y){
       for(int x = 0 ; x < dimx ; ++x){
-        const cell* src = &newp->fb[fbcellidx(y, dimx, x)];
-        cell* targ = &n->fb[fbcellidx(y, dimx, x)];
-        if(cell_duplicate_far(&n->pool, targ, newp, src) < 0){
+        const cell* src = &ncplane_row(newp, y)[x];
+        cell* targ = ncplane_cell_ref_yx(n, y, x);
+        if(targ == NULL || cell_duplicate_far(&n->pool, targ, newp, src) < 0){
           return -1;
         }
       }
     }
+    if(ncplane_traced(n)){
+      trace_cells(n, 0, 0, -1, -1);
+    }
   }
   return ret;
 }
@@ -299,7 +299,8 @@ static char32_t
 handle_input(notcurses* nc, ncinput* ni){
   int r;
   // getc() returns unsigned chars cast to ints
-  while(!input_queue_full(nc) && (r = getc(nc->ttyinfp)) >= 0){
+  // a headless context has no input source
+  while(nc->ttyinfp && !input_queue_full(nc) && (r = getc(nc->ttyinfp)) >= 0){
     nc->inputbuf[nc->inputbuf_write_at] = (unsigned char)r;
 // fprintf(stderr, "OCCUPY: %u@%u read: %d\n", nc->inputbuf_occupied, nc->inputbuf_write_at, nc->inputbuf[nc->inputbuf_write_at]);
     if(++nc->inputbuf_write_at == sizeof(nc->inputbuf) / sizeof(*nc->inputbuf)){
@@ -36,6 +36,10 @@ const char* oiio_version(void);
 #include <langinfo.h>
 #include "notcurses/notcurses.h"
 #include "egcpool.h"
+#include "fbuf.h"
+#include "estemplate.h"
+#include "vscreen.h"
+#include "trace.h"
 
 struct esctrie;
 
@@ -61,8 +65,19 @@ struct esctrie;
 // The framebuffer 'fb' is a set of rows. For scrolling, we interpret it as a
 // circular buffer of rows. 'logrow' is the index of the row at the logical top
 // of the plane.
+//
+// Sparse planes (see ncplane_set_sparse()) have no 'fb'. Their rows are
+// instead grouped into tiles of NCPLANE_TILE_ROWS (virtual) rows, each
+// allocated upon the first write to any of its rows, and freed when the plane
+// is erased. A missing tile reads as blank cells, i.e. the base cell. Get at
+// rows with ncplane_row() and ncplane_row_writable(), never 'fb' directly.
+#define NCPLANE_TILE_ROWS 16
+
 typedef struct ncplane {
-  cell* fb;              // "framebuffer" of character cells
+  cell* fb;              // "framebuffer" of character cells, NULL if sparse
+  cell** tiles;          // sparse planes only: tiles of NCPLANE_TILE_ROWS rows
+  cell* blankrow;        // sparse planes only: 'lenx' zeroed cells
+  size_t fbbytes;        // bytes of 'fb', or of 'tiles' and what they hold
   int logrow;            // logical top row, starts at 0, add one for each scroll
   int x, y;              // current cursor location within this plane
   int absx, absy;        // origin of the plane relative to the screen
@@ -78,9 +93,17 @@ typedef struct ncplane {
   uint32_t attrword;     // same deal as in a cell
   void* userptr;         // slot for the user to stick some opaque pointer
   cell basecell;         // cell written anywhere that fb[i].gcluster == 0
+  int dirtyy0, dirtyy1;  // logical rows [dirtyy0, dirtyy1) changed since render
+  int scrolls;           // rows scrolled since render, with unchanged geometry
   struct notcurses* nc;  // notcurses object of which we are a part
   bool scrolling;        // is scrolling enabled? always disabled by default
   char* name;            // used only for debugging
+  // while the context is being traced, the plane's identifier in the trace,
+  // and its cursor and styling as of the last records (see trace.h)
+  unsigned traceid;
+  int tracey, tracex;
+  uint32_t traceattr;
+  uint64_t tracechannels;
 } ncplane;
 
 #include "blitset.h"
@@ -88,12 +111,10 @@ typedef struct ncplane {
 // current presentation state of the terminal. it is carried across render
 // instances. initialize everything to 0 on a terminal reset / startup.
 typedef struct renderstate {
-  // we assemble the encoded output in a POSIX memstream, and keep it around
-  // between uses. this could be a problem if it ever tremendously spiked, but
-  // that's a highly unlikely situation.
-  char* mstream;  // buffer for rendering memstream, see open_memstream(3)
-  FILE* mstreamfp;// FILE* for rendering memstream
-  size_t mstrsize;// size of rendering memstream
+  // we assemble the encoded output in an fbuf, and keep it around between
+  // uses. this could be a problem if it ever tremendously spiked, but that's
+  // a highly unlikely situation.
+  fbuf f;
 
   // the current cursor position. this is independent of whether the cursor is
   // visible. it is the cell at which the next write will take place. this is
@@ -117,6 +138,88 @@ typedef struct renderstate {
   bool defaultelidable;
 } renderstate;
 
+// persistent pool of threads which paint horizontal bands of the rendering
+// area in parallel, enabled via NCOPTION_PARALLEL_RENDER. each band owns the
+// egcpool backing its rows of lastframe, so no two threads ever write to the
+// same pool. bands are claimed dynamically; the rendering thread claims them
+// alongside the workers, and then waits for any stragglers.
+typedef struct renderworkers {
+  pthread_t* tids;         // 'bands - 1' worker threads
+  unsigned bands;          // number of bands (and egcpools), at least 2
+  egcpool* pools;          // one pool per band, backing lastframe's EGCs
+  int bandrows;            // rows per band, recomputed when lastframe resizes
+  pthread_mutex_t lock;    // guards everything below
+  pthread_cond_t cond;     // signaled on new work or shutdown
+  pthread_cond_t donecond; // signaled when the last band of a frame completes
+  uint64_t generation;     // incremented for each frame handed out
+  unsigned nextband;       // next band to be claimed in this generation
+  unsigned pending;        // bands not yet completed in this generation
+  uint64_t culled;         // occluded cells culled in this generation
+  uint64_t postpaintns;    // longest any band of this generation spent in postpaint
+  bool failed;             // did any band of this generation fail?
+  bool shutdown;           // workers ought exit
+} renderworkers;
+
+// rows [top, bottom] of the rendering area (relative to the standard plane)
+// shifted up by 'rows', using the terminal's scrolling region. the 'rows' rows
+// exposed at the bottom must be redrawn. 'rows' is 0 for no scroll.
+typedef struct hwscroll {
+  int top, bottom;
+  int rows;
+} hwscroll;
+
+// dedicated thread writing rasterized frames to the terminal, enabled via
+// NCOPTION_ASYNC_WRITE or notcurses_set_maxfps(). frames are double-buffered:
+// the renderer fills its own fbuf, and swaps it into 'queued'; the writer
+// swaps 'queued' into 'writing', and writes it without holding the lock. with
+// a frame interval, the writer holds a queued frame until the interval has
+// passed since it began the last write. if a frame is still queued when the
+// next one arrives, the queued frame is dropped (or, if it was being held,
+// coalesced). its damage is folded into the new frame's, and the renderstate
+// is rewound to what it was before the dropped frame was rasterized, so the
+// new frame brings the terminal fully up to date.
+typedef struct ttywriter {
+  pthread_t tid;
+  int fd;                  // descriptor to which frames are written
+  vscreen* vscreen;        // headless virtual terminal written instead, or NULL
+  pthread_mutex_t lock;    // guards everything below
+  pthread_cond_t cond;     // signaled when a frame is queued, or on shutdown
+  pthread_cond_t donecond; // signaled when the writer goes idle
+  fbuf queued;             // frame awaiting the writer, if 'used' is nonzero
+  fbuf writing;            // frame being written, owned by the writer
+  bool busy;               // is the writer writing?
+  bool failed;             // has a write failed since the last fence?
+  bool shutdown;           // writer ought drain the queue, and exit
+  uint64_t interval;       // minimum ns between writes, 0 for no limit
+  uint64_t lastwritens;    // CLOCK_MONOTONIC ns at which the last write began
+  uint64_t write_ns;       // write timings not yet folded into the stats
+  uint64_t write_hist[NCSTATS_BUCKETS];
+  // what is necessary to re-rasterize the queued frame's damage, should it be
+  // dropped: the presentation state and palette damage preceding it, and its
+  // damage map (qdimy rows of qdimx columns). these are only ever touched by
+  // the rendering thread, but qdimy is -1 if they don't describe 'queued'.
+  renderstate rstate;      // 'f' is unused
+  bool palette_damage[NCPALETTESIZE];
+  uint64_t* qdamage;
+  size_t qdamagewords;     // capacity of qdamage, in words
+  int qdimy, qdimx;
+  hwscroll qscroll;        // hardware scroll emitted by the queued frame
+} ttywriter;
+
+// Scratch state for solving a frame, owned by the notcurses context and reused
+// across renders. It grows as necessary (typically on resize), but is never
+// shrunk. Indices are row-major over the area being solved.
+typedef struct renderarena {
+  cell* fb;              // scratch framebuffer into which planes are painted
+  ncplane** planes;      // plane which supplied each cell's EGC, if any
+  struct crender* rvec;  // per-cell blending state, see render.c
+  uint64_t* damage;      // bit per cell, set if it differs from lastframe
+  int* rowlocked;        // locked-in cells per row; a full row occludes below
+  size_t cells;          // capacity of fb, planes, and rvec
+  size_t damagewords;    // capacity of damage, in words
+  size_t rows;           // capacity of rowlocked
+} renderarena;
+
 // ncmenu_item and ncmenu_section have internal and (minimal) external forms
 typedef struct ncmenu_int_item {
   char* desc;           // utf-8 menu item, NULL for horizontal separator
@@ -236,6 +339,7 @@ typedef struct tinfo {
   char* cud;      // move N cells down
   char* cuf1;     // move 1 cell right
   char* cub1;     // move 1 cell left
+  char* cr;       // move to the beginning of the line
   char* home;     // home cursor
   char* civis;    // hide cursor
   char* cnorm;    // restore cursor to default state
@@ -254,6 +358,11 @@ typedef struct tinfo {
   char* clearscr; // erase screen and home cursor
   char* cleareol; // clear to end of line
   char* clearbol; // clear to beginning of line
+  char* ech;      // erase N characters, without moving the cursor
+  char* rep;      // repeat a character N times
+  char* csr;      // change the scrolling region
+  char* ind;      // scroll the region up one row (from its bottom row)
+  char* indn;     // scroll the region up N rows
   char* sc;       // push the cursor location onto the stack
   char* rc;       // pop the cursor location off the stack
   char* smkx;     // enter keypad transmit mode (keypad_xmit)
@@ -262,14 +371,51 @@ typedef struct tinfo {
   bool RGBflag;   // ti-reported "RGB" flag for 24bpc truecolor
   bool CCCflag;   // ti-reported "CCC" flag for palette set capability
   bool AMflag;    // ti-reported "AM" flag for automatic movement to next line
+  bool BCEflag;   // ti-reported "bce" flag: erasure uses the background color
+  bool sgrmerge;  // attributes are set with ECMA-48 SGR, which can be combined
+  char bsu[16];   // begin synchronized update
+  char esu[16];   // end synchronized update
   char* smcup;    // enter alternate mode
   char* rmcup;    // restore primary mode
+  // compiled forms of the parameterized capabilities emitted while rendering.
+  // those which couldn't be compiled are invalid, and need tiparm().
+  estemplate cupt, cuut, cudt, cuft, cubt, hpat, vpat, echt, rept, initct;
+  estemplate setaft, setabt;
+  // setaf and setab expanded for each palette index, if they didn't compile
+  estable setafs, setabs;
 } tinfo;
 
+// a cached expansion of a single-parameter escape
+typedef struct esentry {
+  char seq[15];      // expansion, not NUL-terminated
+  unsigned char len; // 0 if not yet expanded, UCHAR_MAX if too long to cache
+} esentry;
+
+// lazily-populated expansions of a single-parameter escape, indexed by the
+// parameter, so that the steady state needn't call tiparm().
+typedef struct escache {
+  const char* cap;   // capability from the terminfo cache, NULL if absent
+  const estemplate* tmpl; // compiled 'cap', NULL if it didn't compile
+  esentry* entries;  // 'count' entries, grown on demand
+  int count;
+  // 'cap' is rep, which takes a character and a count. entries are what
+  // follows the character, i.e. repetitions of the previous glyph.
+  bool repeat;
+  char scratch[ESTEMPLATE_MAXLEN + 1]; // expansions too long to cache
+} escache;
+
+// expansions of the parameterized escapes used during rasterization: cursor
+// movements (see stage_cursor()), erasure, and repetition.
+typedef struct paramcache {
+  escache cuf, cub, cuu, cud, hpa, vpa;
+  escache ech, rep;
+} paramcache;
+
 typedef struct ncdirect {
   int attrword;              // current styles
   palette256 palette;        // 256-indexed palette can be used instead of/with RGB
   FILE* ttyfp;               // FILE* for output tty
+  fbuf f;                    // escapes and EGCs staged for ttyfp
   int ctermfd;               // fd for controlling terminal
   tinfo tcache;              // terminfo cache
   unsigned fgrgb, bgrgb;     // last RGB values of foreground/background
@@ -284,13 +430,28 @@ typedef struct notcurses {
 
   // the style state of the terminal is carried across render runs
   renderstate rstate;
+  paramcache pcache; // parameterized escapes, expanded as they're needed
 
   // we keep a copy of the last rendered frame. this facilitates O(1)
   // notcurses_at_yx() and O(1) damage detection (at the cost of some memory).
   cell* lastframe;// last rendered framebuffer, NULL until first render
   int lfdimx;     // dimensions of lastframe, unchanged by screen resize
   int lfdimy;     // lfdimx/lfdimy are 0 until first render
-  egcpool pool;   // duplicate EGCs into this pool
+  egcpool pool;   // duplicate EGCs into this pool (unless 'rworkers' is set)
+  renderworkers* rworkers; // parallel painters, NULL for serial rendering
+  ttywriter* writer; // asynchronous frame writer, NULL for synchronous writes
+  bool asyncwrite;        // NCOPTION_ASYNC_WRITE (else the writer only paces)
+  bool syncupdates;       // NCOPTION_SYNC_UPDATES: bracket each frame
+  bool compactpools;      // NCOPTION_COMPACT_EGCPOOLS: compact when rendering
+  renderarena arena; // scratch space for rendering, reused across frames
+  // rows of the rendering area which must be solved anew in the next render,
+  // due to geometry changes (moves, resizes, destruction). each plane tracks
+  // its own changed rows; these are folded in at render time. only rows
+  // marked here are composited, and only they can be damaged. lfdimy long.
+  bool* dirtyrows;
+  // a hardware scroll already applied to lastframe, which the next frame
+  // rasterized must perform on the terminal
+  hwscroll hwscroll;
 
   ncstats stats;  // some statistics across the lifetime of the notcurses ctx
   ncstats stashstats; // cumulative stats, unaffected by notcurses_reset_stats()
@@ -298,13 +459,16 @@ typedef struct notcurses {
   int truecols;   // true number of columns in the physical rendering area.
                   // used only to see if output motion takes us to the next
                   // line thanks to terminal action alone.
+  int truerows;   // true number of rows, needed to reset the scrolling region
 
   tinfo tcache;   // terminfo cache
 
-  FILE* ttyfp;    // FILE* for writing rasterized data
+  FILE* ttyfp;    // FILE* for writing rasterized data, NULL if headless
   int ttyfd;      // file descriptor for controlling tty
   FILE* ttyinfp;  // FILE* for processing input
   FILE* renderfp; // debugging FILE* to which renderings are written
+  vscreen* vscreen; // NCOPTION_HEADLESS virtual terminal, replacing ttyfp
+  nctrace* trace;   // recording of plane operations (NOTCURSES_TRACE), or NULL
   struct termios tpreserved; // terminal state upon entry
   bool suppress_banner; // from notcurses_options
   unsigned char inputbuf[BUFSIZ];
@@ -397,15 +561,193 @@ nfbcellidx(const ncplane* n, int row, int col){
   return fbcellidx(logical_to_virtual(n, row), n->lenx, col);
 }
 
+static inline int
+ncplane_tilecount(const ncplane* n){
+  return (n->leny + NCPLANE_TILE_ROWS - 1) / NCPLANE_TILE_ROWS;
+}
+
+// the number of rows in tile 't' of a sparse plane (the last might be short)
+static inline int
+ncplane_tile_rows(const ncplane* n, int t){
+  int rows = n->leny - t * NCPLANE_TILE_ROWS;
+  return rows > NCPLANE_TILE_ROWS ? NCPLANE_TILE_ROWS : rows;
+}
+
+// allocate blank tile 't' of sparse plane 'n', returning NULL on failure
+cell* ncplane_tile_alloc(ncplane* n, int t);
+
+// the cells of logical row 'y', for reading. rows of a sparse plane's missing
+// tiles read as blank cells.
+static inline const cell*
+ncplane_row(const ncplane* n, int y){
+  const int vy = logical_to_virtual(n, y);
+  if(n->fb){
+    return n->fb + fbcellidx(vy, n->lenx, 0);
+  }
+  const cell* tile = n->tiles[vy / NCPLANE_TILE_ROWS];
+  if(tile == NULL){
+    return n->blankrow;
+  }
+  return tile + fbcellidx(vy % NCPLANE_TILE_ROWS, n->lenx, 0);
+}
+
+// the cells of logical row 'y', for modification in place, or NULL if the
+// row lies within a sparse plane's missing tile (and is thus blank).
+static inline cell*
+ncplane_row_present(ncplane* n, int y){
+  const int vy = logical_to_virtual(n, y);
+  if(n->fb){
+    return n->fb + fbcellidx(vy, n->lenx, 0);
+  }
+  cell* tile = n->tiles[vy / NCPLANE_TILE_ROWS];
+  if(tile == NULL){
+    return NULL;
+  }
+  return tile + fbcellidx(vy % NCPLANE_TILE_ROWS, n->lenx, 0);
+}
+
+// the cells of logical row 'y', for writing, allocating a sparse plane's
+// missing tile. returns NULL if the tile can't be allocated.
+static inline cell*
+ncplane_row_writable(ncplane* n, int y){
+  cell* row = ncplane_row_present(n, y);
+  if(row == NULL){
+    const int vy = logical_to_virtual(n, y);
+    cell* tile = ncplane_tile_alloc(n, vy / NCPLANE_TILE_ROWS);
+    if(tile){
+      row = tile + fbcellidx(vy % NCPLANE_TILE_ROWS, n->lenx, 0);
+    }
+  }
+  return row;
+}
+
+// the cell storage of a plane, for those passes which visit every cell and
+// care not for their coordinates: a dense plane's 'fb' is its only chunk,
+// while a sparse plane has a chunk per tile. returns the cells of chunk 'i'
+// and their number, or NULL if it is a missing tile.
+static inline int
+ncplane_chunkcount(const ncplane* n){
+  return n->fb ? 1 : ncplane_tilecount(n);
+}
+
+static inline cell*
+ncplane_chunk(const ncplane* n, int i, int* cells){
+  if(n->fb){
+    *cells = n->leny * n->lenx;
+    return n->fb;
+  }
+  *cells = ncplane_tile_rows(n, i) * n->lenx;
+  return n->tiles[i];
+}
+
+// note that logical rows [y, y + rows) of 'n' have changed since the last
+// render. any path writing to a plane's framebuffer or base cell must do so.
+static inline void
+ncplane_dirty_rows(ncplane* n, int y, int rows){
+  if(y < n->dirtyy0){
+    n->dirtyy0 = y;
+  }
+  if(y + rows > n->dirtyy1){
+    n->dirtyy1 = y + rows;
+  }
+}
+
+static inline void
+ncplane_dirty(ncplane* n){
+  ncplane_dirty_rows(n, 0, n->leny);
+}
+
+static inline void
+ncplane_clean(ncplane* n){
+  n->dirtyy0 = INT_MAX;
+  n->dirtyy1 = 0;
+  n->scrolls = 0;
+}
+
+// note that the rendering area rows covering absolute rows [absy, absy + rows)
+// must be solved anew. until the first render, everything will be solved
+// anyway, and there's nothing to mark.
+static inline void
+notcurses_dirty_rows(notcurses* nc, int absy, int rows){
+  if(nc == NULL || nc->dirtyrows == NULL){
+    return;
+  }
+  int y = absy - nc->margin_t; // the standard plane's origin
+  if(y < 0){
+    rows += y;
+    y = 0;
+  }
+  if(y + rows > nc->lfdimy){
+    rows = nc->lfdimy - y;
+  }
+  if(rows > 0){
+    memset(nc->dirtyrows + y, true, rows);
+  }
+}
+
+// a plane is about to change its geometry, or leave the z-axis. the rows it
+// currently covers must be solved anew, as must all of its own rows.
+static inline void
+ncplane_dirty_geometry(ncplane* n){
+  notcurses_dirty_rows(n->nc, n->absy, n->leny);
+  ncplane_dirty(n);
+  n->scrolls = 0;
+}
+
+// are operations on 'n' being recorded? ncdirect's fake planes have no 'nc'.
+static inline bool
+ncplane_traced(const ncplane* n){
+  return n->nc && n->nc->trace;
+}
+
+// the egcpool backing row 'y' of lastframe. this is the context's pool, unless
+// we're painting in parallel, in which case each band has its own.
+static inline egcpool*
+lastframe_pool(notcurses* nc, int y){
+  if(nc->rworkers == NULL){
+    return &nc->pool;
+  }
+  return &nc->rworkers->pools[y / nc->rworkers->bandrows];
+}
+
+// launch the parallel painters, one per online processor. returns 0 without
+// launching anything if there is only one processor to work with.
+int render_workers_start(notcurses* nc);
+
+// join the parallel painters, and free their pools. safe to call if they
+// were never launched.
+void render_workers_stop(notcurses* nc);
+
+// prepare the parameterized escape cache for the capabilities of 'ti'.
+// nothing is expanded until it is needed.
+void paramcache_init(paramcache* pc, const tinfo* ti);
+
+// release all cached escape expansions
+void paramcache_free(paramcache* pc);
+
+// launch the asynchronous frame writer.
+int tty_writer_start(notcurses* nc);
+
+// drain any queued frames, and join the asynchronous frame writer. safe to
+// call if it was never launched. returns -1 if any write failed.
+int tty_writer_stop(notcurses* nc);
+
+// set the bytes handed to the asynchronous frame writer but not yet written
+// in 'stats', and add the writer's write timings to it. if 'take', the timings
+// are cleared, having been folded into 'stats' for good.
+void tty_writer_stats(const notcurses* nc, ncstats* stats, bool take);
+
+// release the render arena's memory, leaving it empty (but usable)
+void render_arena_free(renderarena* ra);
+
 // copy the UTF8-encoded EGC out of the cell, whether simple or complex. the
 // result is not tied to the ncplane, and persists across erases / destruction.
 static inline char*
 pool_egc_copy(const egcpool* e, const cell* c){
   char* ret;
   if(cell_simple_p(c)){
-    if( (ret = (char*)malloc(2)) ){
-      ret[0] = c->gcluster;
-      ret[1] = '\0';
+    if( (ret = (char*)malloc(CELL_INLINE_BYTES + 1)) ){
+      cell_simple_egc(c, ret);
     }
   }else{
     ret = strdup(egcpool_extended_gcluster(e, c));
@@ -493,20 +835,20 @@ rgb_greyscale(int r, int g, int b){
   return fg * 255;
 }
 
+// write all of 'buf' to 'fd', waiting on poll() whenever a nonblocking 'fd'
+// is full. returns -1 on any other error.
+int blocking_write(int fd, const char* buf, size_t buflen);
+
+// the terminal's descriptor is nonblocking, and might be full of our output
 static inline int
 tty_emit(const char* name __attribute__ ((unused)), const char* seq, int fd){
   if(!seq){
     return -1;
   }
-  ssize_t ret = write(fd, seq, strlen(seq));
-  if(ret < 0){
+  if(blocking_write(fd, seq, strlen(seq))){
 //fprintf(stderr, "Error emitting %zub %s escape (%s)\n", strlen(seq), name, strerror(errno));
     return -1;
   }
-  if((size_t)ret != strlen(seq)){
-//fprintf(stderr, "Short write (%db) for %zub %s sequence\n", ret, strlen(seq), name);
-    return -1;
-  }
   return 0;
 }
 
@@ -532,27 +874,74 @@ term_emit(const char* name __attribute__ ((unused)), const char* seq,
   return 0;
 }
 
+// if the 'len' bytes at 's' begin with an ECMA-48 SGR escape having only
+// numeric parameters (i.e. "\e[1;38;5;9m"), return its length, otherwise 0.
+static inline size_t
+sgr_len(const char* s, size_t len){
+  if(len < 3 || s[0] != '\x1b' || s[1] != '['){
+    return 0;
+  }
+  for(size_t i = 2 ; i < len ; ++i){
+    if(s[i] == 'm'){
+      return i + 1;
+    }
+    if((s[i] < '0' || s[i] > '9') && s[i] != ';' && s[i] != ':'){
+      break;
+    }
+  }
+  return 0;
+}
+
+// emit the single-parameter capability 'cap' using its template 't' or table
+// 'table' of expansions, falling back to tiparm() only when neither applies.
+static inline int
+term_emit_param(fbuf* out, const char* cap, const estemplate* t,
+                const estable* table, int p){
+  if(t->valid){
+    return estemplate_emit(out, t, &p);
+  }
+  if(p >= 0 && p < ESTABLE_ENTRIES && table->len[p]){
+    return fbuf_putn(out, table->seq[p], table->len[p]);
+  }
+  return fbuf_emit(out, tiparm(cap, p));
+}
+
 static inline int
-term_bg_palindex(const notcurses* nc, FILE* out, unsigned pal){
-  if(nc->tcache.setab == NULL){
+term_bg_palindex(const notcurses* nc, fbuf* out, unsigned pal){
+  const tinfo* ti = &nc->tcache;
+  if(ti->setab == NULL){
     return 0;
   }
-  return term_emit("setab", tiparm(nc->tcache.setab, pal), out, false);
+  return term_emit_param(out, ti->setab, &ti->setabt, &ti->setabs, pal);
 }
 
 static inline int
-term_fg_palindex(const notcurses* nc, FILE* out, unsigned pal){
-  if(nc->tcache.setaf == NULL){
+term_fg_palindex(const notcurses* nc, fbuf* out, unsigned pal){
+  const tinfo* ti = &nc->tcache;
+  if(ti->setaf == NULL){
     return 0;
   }
-  return term_emit("setaf", tiparm(nc->tcache.setaf, pal), out, false);
+  return term_emit_param(out, ti->setaf, &ti->setaft, &ti->setafs, pal);
 }
 
 static inline const char*
 extended_gcluster(const ncplane* n, const cell* c){
+  if(cell_simple_p(c)){
+    return cell_extended_gcluster(n, c);
+  }
   return egcpool_extended_gcluster(&n->pool, c);
 }
 
+// is the cell's EGC empty, or a lone 7-bit character? (the ctype.h functions
+// can only be applied to such cells' gclusters.)
+static inline bool
+cell_ascii_p(const cell* c){
+  return c->gcluster < 0x80;
+}
+
+// a reference to the cell at 'y', 'x', marked dirty for writing. returns
+// NULL if it lies within a sparse plane's tile, and the tile can't be
+// allocated.
 cell* ncplane_cell_ref_yx(ncplane* n, int y, int x);
 
 static inline void
@@ -562,6 +951,14 @@ cell_set_wide(cell* c){
 
 #define NANOSECS_IN_SEC 1000000000
 
+// record a sample of 'ns' spent in a phase of rendering, see ncstats
+static inline void
+stats_phase(uint64_t* total, uint64_t* hist, uint64_t ns){
+  unsigned bucket = ns ? 64 - __builtin_clzll(ns) : 0;
+  *total += ns;
+  ++hist[bucket < NCSTATS_BUCKETS ? bucket : NCSTATS_BUCKETS - 1];
+}
+
 static inline uint64_t
 timespec_to_ns(const struct timespec* t){
   return t->tv_sec * NANOSECS_IN_SEC + t->tv_nsec;
@@ -577,8 +974,10 @@ ns_to_timespec(uint64_t ns, struct timespec* ts){
 static inline void
 cell_debug(const egcpool* p, const cell* c){
 	if(cell_simple_p(c)){
-		fprintf(stderr, "gcluster: %u %c attr: 0x%08x chan: 0x%016jx\n",
-				    c->gcluster, c->gcluster, c->attrword, c->channels);
+		char egc[CELL_INLINE_BYTES + 1];
+		cell_simple_egc(c, egc);
+		fprintf(stderr, "gcluster: %u %s attr: 0x%08x chan: 0x%016jx\n",
+				    c->gcluster, egc, c->attrword, c->channels);
 	}else{
 		fprintf(stderr, "gcluster: %u %s attr: 0x%08x chan: 0x%016jx\n",
 				    c->gcluster, egcpool_extended_gcluster(p, c), c->attrword, c->channels);
@@ -593,7 +992,7 @@ plane_debug(const ncplane* n, bool details){
   if(details){
     for(int y = 0 ; y < 1 ; ++y){
       for(int x = 0 ; x < 10 ; ++x){
-        const cell* c = &n->fb[fbcellidx(y, dimx, x)];
+        const cell* c = &ncplane_row(n, y)[x];
         fprintf(stderr, "[%03d/%03d] ", y, x);
         cell_debug(&n->pool, c);
       }
@@ -617,7 +1016,7 @@ cell_duplicate_far(egcpool* tpool, cell* targ, const ncplane* splane, const cell
   targ->channels = c->channels;
   if(cell_simple_p(c)){
     targ->gcluster = c->gcluster;
-    return !!c->gcluster;
+    return egc_inline_len(c->gcluster);
   }
   assert(splane);
   const char* egc = extended_gcluster(splane, c);
@@ -626,7 +1025,7 @@ cell_duplicate_far(egcpool* tpool, cell* targ, const ncplane* splane, const cell
   if(eoffset < 0){
     return -1;
   }
-  targ->gcluster = eoffset + 0x80;
+  targ->gcluster = egcpool_gcluster(eoffset);
   return ulen;
 }
 
@@ -634,6 +1033,9 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
                             int keepleny, int keeplenx, int yoff, int xoff,
                             int ylen, int xlen);
 
+// rebuild the plane's egcpool from only its live EGCs, rewriting their offsets
+int ncplane_compact(ncplane* n);
+
 int update_term_dimensions(int fd, int* rows, int* cols);
 
 static inline void*
@@ -777,7 +1179,8 @@ calc_gradient_channels(uint64_t* channels, uint64_t ul, uint64_t ur,
 // ncvisual_render(), and thus calls these low-level internal functions.
 // they are not for general use -- check ncplane_new() and ncplane_destroy().
 ncplane* ncplane_create(notcurses* nc, ncplane* n, int rows, int cols,
-                        int yoff, int xoff, void* opaque, const char* name);
+                        int yoff, int xoff, void* opaque, const char* name,
+                        bool sparse);
 void free_plane(ncplane* p);
 
 // heap-allocated formatted output
@@ -826,9 +1229,14 @@ int get_controlling_tty(void);
 // Convert a notcurses log level to some multimedia library equivalent.
 int ffmpeg_log_level(ncloglevel_e level);
 
-int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
+int term_setstyle(fbuf* out, unsigned cur, unsigned targ, unsigned stylebit,
                   const char* ton, const char* toff);
 
+// Stage the escapes selecting an RGB foreground/background into the ncdirect
+// context's fbuf, without writing them out.
+int ncdirect_fg_stage(ncdirect* nc, unsigned rgb);
+int ncdirect_bg_stage(ncdirect* nc, unsigned rgb);
+
 // how many edges need touch a corner for it to be printed?
 static inline unsigned
 box_corner_needs(unsigned ctlword){
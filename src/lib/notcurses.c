@@ -48,6 +48,9 @@ drop_signals(notcurses* nc){
 // any preexisting styling) and shutdown (to not affect further programs).
 static int
 reset_term_attributes(notcurses* nc){
+  if(nc->vscreen){ // there's no terminal to restore
+    return 0;
+  }
   int ret = 0;
   if(nc->tcache.op && term_emit("op", nc->tcache.op, nc->ttyfp, false)){
     ret = -1;
@@ -68,7 +71,9 @@ reset_term_attributes(notcurses* nc){
 static int
 notcurses_stop_minimal(notcurses* nc){
   int ret = 0;
-  drop_signals(nc);
+  if(!nc->vscreen){ // headless contexts never registered for signals
+    drop_signals(nc);
+  }
   // be sure to write the restoration sequences *prior* to running rmcup, as
   // they apply to the screen (alternate or otherwise) we're actually using.
   ret |= reset_term_attributes(nc);
@@ -215,14 +220,14 @@ char* ncplane_at_cursor(ncplane* n, uint32_t* attrword, uint64_t* channels){
   if(cursor_invalid_p(n)){
     return NULL;
   }
-  return cell_extract(n, &n->fb[nfbcellidx(n, n->y, n->x)], attrword, channels);
+  return cell_extract(n, &ncplane_row(n, n->y)[n->x], attrword, channels);
 }
 
 char* ncplane_at_yx(const ncplane* n, int y, int x, uint32_t* attrword, uint64_t* channels){
   char* ret = NULL;
   if(y < n->leny && x < n->lenx){
     if(y >= 0 && x >= 0){
-      ret = cell_extract(n, &n->fb[nfbcellidx(n, y, x)], attrword, channels);
+      ret = cell_extract(n, &ncplane_row(n, y)[x], attrword, channels);
     }
   }
   return ret;
@@ -231,7 +236,12 @@ char* ncplane_at_yx(const ncplane* n, int y, int x, uint32_t* attrword, uint64_t
 cell* ncplane_cell_ref_yx(ncplane* n, int y, int x){
   assert(y < n->leny);
   assert(x < n->lenx);
-  return &n->fb[nfbcellidx(n, y, x)];
+  cell* row = ncplane_row_writable(n, y);
+  if(row == NULL){
+    return NULL;
+  }
+  ncplane_dirty_rows(n, y, 1); // assume it's being acquired for writing
+  return &row[x];
 }
 
 void ncplane_dim_yx(const ncplane* n, int* rows, int* cols){
@@ -270,16 +280,60 @@ int update_term_dimensions(int fd, int* rows, int* cols){
   return 0;
 }
 
+// free the tiles of a sparse plane (which needn't all be present), the array
+// holding them, and the blank row
+static void
+free_tiles(cell** tiles, int tilecount, cell* blankrow){
+  if(tiles){
+    for(int t = 0 ; t < tilecount ; ++t){
+      free(tiles[t]);
+    }
+    free(tiles);
+  }
+  free(blankrow);
+}
+
+// allocate blank tile 't' of a sparse plane of 'leny' rows of 'lenx' cells,
+// adding its size to '*bytes'
+static cell*
+alloc_tile(cell** tiles, int t, int leny, int lenx, size_t* bytes){
+  int rows = leny - t * NCPLANE_TILE_ROWS;
+  if(rows > NCPLANE_TILE_ROWS){
+    rows = NCPLANE_TILE_ROWS;
+  }
+  cell* tile = calloc(rows * lenx, sizeof(*tile));
+  if(tile){
+    tiles[t] = tile;
+    *bytes += sizeof(*tile) * rows * lenx;
+  }
+  return tile;
+}
+
+cell* ncplane_tile_alloc(ncplane* n, int t){
+  const size_t bytes = n->fbbytes;
+  cell* tile = alloc_tile(n->tiles, t, n->leny, n->lenx, &n->fbbytes);
+  if(tile == NULL){
+    logerror(n->nc, "Couldn't allocate tile %d of %dx%d\n", t, n->leny, n->lenx);
+    return NULL;
+  }
+  if(n->nc){
+    n->nc->stats.fbbytes += n->fbbytes - bytes;
+  }
+  return tile;
+}
+
 void free_plane(ncplane* p){
   if(p){
     // ncdirect fakes an ncplane with no ->nc
     if(p->nc){
+      notcurses_dirty_rows(p->nc, p->absy, p->leny);
       --p->nc->stats.planes;
-      p->nc->stats.fbbytes -= sizeof(*p->fb) * p->leny * p->lenx;
+      p->nc->stats.fbbytes -= p->fbbytes;
     }
     egcpool_dump(&p->pool);
     free(p->name);
     free(p->fb);
+    free_tiles(p->tiles, ncplane_tilecount(p), p->blankrow);
     free(p);
   }
 }
@@ -293,19 +347,39 @@ void free_plane(ncplane* p){
 // relative to that plane.
 // there's a denormalized case we also must handle, that of the "fake" isolated
 // ncplane created by ncdirect for rendering visuals. in that case (and only in
-// that case), nc is NULL.
+// that case), nc is NULL. a sparse plane starts with no tiles at all.
 ncplane* ncplane_create(notcurses* nc, ncplane* n, int rows, int cols,
-                        int yoff, int xoff, void* opaque, const char* name){
+                        int yoff, int xoff, void* opaque, const char* name,
+                        bool sparse){
   if(rows <= 0 || cols <= 0){
     return NULL;
   }
   ncplane* p = malloc(sizeof(*p));
-  size_t fbsize = sizeof(*p->fb) * (rows * cols);
-  if((p->fb = malloc(fbsize)) == NULL){
-    free(p);
+  if(p == NULL){
     return NULL;
   }
-  memset(p->fb, 0, fbsize);
+  p->fb = NULL;
+  p->tiles = NULL;
+  p->blankrow = NULL;
+  if(sparse){
+    const int tilecount = (rows + NCPLANE_TILE_ROWS - 1) / NCPLANE_TILE_ROWS;
+    p->tiles = calloc(tilecount, sizeof(*p->tiles));
+    p->blankrow = calloc(cols, sizeof(*p->blankrow));
+    if(p->tiles == NULL || p->blankrow == NULL){
+      free(p->tiles);
+      free(p->blankrow);
+      free(p);
+      return NULL;
+    }
+    p->fbbytes = sizeof(*p->tiles) * tilecount + sizeof(*p->blankrow) * cols;
+  }else{
+    p->fbbytes = sizeof(*p->fb) * (rows * cols);
+    if((p->fb = malloc(p->fbbytes)) == NULL){
+      free(p);
+      return NULL;
+    }
+    memset(p->fb, 0, p->fbbytes);
+  }
   p->scrolling = false;
   p->userptr = NULL;
   p->leny = rows;
@@ -330,8 +404,14 @@ ncplane* ncplane_create(notcurses* nc, ncplane* n, int rows, int cols,
   }
   p->attrword = 0;
   p->channels = 0;
+  p->traceid = 0;
+  p->tracey = p->tracex = 0;
+  p->traceattr = 0;
+  p->tracechannels = 0;
   egcpool_init(&p->pool);
   cell_init(&p->basecell);
+  ncplane_clean(p);
+  ncplane_dirty(p);
   p->userptr = opaque;
   p->above = NULL;
   if( (p->nc = nc) ){
@@ -341,8 +421,11 @@ ncplane* ncplane_create(notcurses* nc, ncplane* n, int rows, int cols,
       nc->bottom = p;
     }
     nc->top = p;
-    nc->stats.fbbytes += fbsize;
+    nc->stats.fbbytes += p->fbbytes;
     ++nc->stats.planes;
+    if(nc->trace){
+      trace_create(p, n, yoff, xoff);
+    }
   }else{
     p->below = NULL;
   }
@@ -355,7 +438,7 @@ static ncplane*
 create_initial_ncplane(notcurses* nc, int dimy, int dimx){
   nc->stdplane = ncplane_create(nc, NULL, dimy - (nc->margin_t + nc->margin_b),
                                 dimx - (nc->margin_l + nc->margin_r), 0, 0, NULL,
-                                "std");
+                                "std", false);
   return nc->stdplane;
 }
 
@@ -368,17 +451,92 @@ const ncplane* notcurses_stdplane_const(const notcurses* nc){
 }
 
 ncplane* ncplane_new(notcurses* nc, int rows, int cols, int yoff, int xoff, void* opaque){
-  return ncplane_create(nc, NULL, rows, cols, yoff, xoff, opaque, NULL);
+  return ncplane_create(nc, NULL, rows, cols, yoff, xoff, opaque, NULL, false);
+}
+
+ncplane* ncplane_new_sparse(notcurses* nc, ncplane* boundto, int rows, int cols,
+                            int yoff, int xoff, void* opaque){
+  return ncplane_create(nc, boundto, rows, cols, yoff, xoff, opaque, NULL, true);
 }
 
 ncplane* ncplane_bound(ncplane* n, int rows, int cols, int yoff, int xoff, void* opaque){
-  return ncplane_create(n->nc, n, rows, cols, yoff, xoff, opaque, NULL);
+  return ncplane_create(n->nc, n, rows, cols, yoff, xoff, opaque, NULL, false);
 }
 
 ncplane* ncplane_aligned(ncplane* n, int rows, int cols, int yoff,
                          ncalign_e align, void* opaque){
   return ncplane_create(n->nc, n, rows, cols, yoff,
-                        ncplane_align(n, align, cols), opaque, NULL);
+                        ncplane_align(n, align, cols), opaque, NULL, false);
+}
+
+bool ncplane_sparse_p(const ncplane* n){
+  return n->fb == NULL;
+}
+
+// is the tile of 'rows' rows of 'lenx' cells at 'cells' entirely blank?
+static bool
+blank_tile_p(const cell* cells, int rows, int lenx){
+  for(int i = 0 ; i < rows * lenx ; ++i){
+    if(cells[i].gcluster || cells[i].attrword || cells[i].channels){
+      return false;
+    }
+  }
+  return true;
+}
+
+int ncplane_set_sparse(ncplane* n, bool sparse){
+  if(sparse == ncplane_sparse_p(n)){
+    return 0;
+  }
+  const int tilecount = ncplane_tilecount(n);
+  size_t fbbytes = 0;
+  if(sparse){
+    // only those tiles holding something other than blank cells are kept
+    cell** tiles = calloc(tilecount, sizeof(*tiles));
+    cell* blankrow = calloc(n->lenx, sizeof(*blankrow));
+    if(tiles == NULL || blankrow == NULL){
+      free(tiles);
+      free(blankrow);
+      return -1;
+    }
+    fbbytes = sizeof(*tiles) * tilecount + sizeof(*blankrow) * n->lenx;
+    for(int t = 0 ; t < tilecount ; ++t){
+      const int rows = ncplane_tile_rows(n, t);
+      const cell* src = n->fb + fbcellidx(t * NCPLANE_TILE_ROWS, n->lenx, 0);
+      if(!blank_tile_p(src, rows, n->lenx)){
+        cell* tile = alloc_tile(tiles, t, n->leny, n->lenx, &fbbytes);
+        if(tile == NULL){
+          free_tiles(tiles, tilecount, blankrow);
+          return -1;
+        }
+        memcpy(tile, src, sizeof(*tile) * rows * n->lenx);
+      }
+    }
+    free(n->fb);
+    n->fb = NULL;
+    n->tiles = tiles;
+    n->blankrow = blankrow;
+  }else{
+    fbbytes = sizeof(*n->fb) * n->leny * n->lenx;
+    cell* fb = calloc(n->leny * n->lenx, sizeof(*fb));
+    if(fb == NULL){
+      return -1;
+    }
+    for(int t = 0 ; t < tilecount ; ++t){
+      if(n->tiles[t]){
+        memcpy(fb + fbcellidx(t * NCPLANE_TILE_ROWS, n->lenx, 0), n->tiles[t],
+               sizeof(*fb) * ncplane_tile_rows(n, t) * n->lenx);
+      }
+    }
+    free_tiles(n->tiles, tilecount, n->blankrow);
+    n->tiles = NULL;
+    n->blankrow = NULL;
+    n->fb = fb;
+  }
+  n->nc->stats.fbbytes -= n->fbbytes;
+  n->nc->stats.fbbytes += fbbytes;
+  n->fbbytes = fbbytes;
+  return 0;
 }
 
 void ncplane_home(ncplane* n){
@@ -426,7 +584,8 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
   const int placey = n->absy - nc->margin_t;
   const int placex = n->absx - nc->margin_l;
   ncplane* newn = ncplane_create(n->nc, n->boundto, dimy, dimx,
-                                 placey, placex, opaque, n->name);
+                                 placey, placex, opaque, n->name,
+                                 ncplane_sparse_p(n));
   if(newn){
     if(egcpool_dup(&newn->pool, &n->pool)){
       ncplane_destroy(newn);
@@ -438,14 +597,67 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
       }
       newn->attrword = attr;
       newn->channels = chan;
-      memmove(newn->fb, n->fb, sizeof(*n->fb) * dimx * dimy);
+      if(n->fb){
+        memmove(newn->fb, n->fb, sizeof(*n->fb) * dimx * dimy);
+      }else{
+        for(int t = 0 ; t < ncplane_tilecount(n) ; ++t){
+          if(n->tiles[t]){
+            cell* tile = ncplane_tile_alloc(newn, t);
+            if(tile == NULL){
+              ncplane_destroy(newn);
+              return NULL;
+            }
+            memcpy(tile, n->tiles[t],
+                   sizeof(*tile) * ncplane_tile_rows(n, t) * dimx);
+          }
+        }
+      }
+      // the framebuffer was copied verbatim, rows rotated by any scrolling
+      newn->logrow = n->logrow;
       // we dupd the egcpool, so just dup the goffset
       newn->basecell = n->basecell;
+      if(ncplane_traced(newn)){
+        trace_cells(newn, 0, 0, -1, -1);
+        trace_base(newn);
+      }
     }
   }
   return newn;
 }
 
+// rebuild the plane's egcpool with only the EGCs of its framebuffer and base
+// cell, packed into a pool sized anew for them. this reclaims both released
+// slots and the EGCs of cells dropped by a resize. cells loaded against the
+// plane, but not written to it, are invalidated. on failure, the old pool is
+// retained.
+int ncplane_compact(ncplane* n){
+  size_t need = egcpool_compacted_bytes(&n->pool, &n->basecell);
+  for(int chunk = 0 ; chunk < ncplane_chunkcount(n) ; ++chunk){
+    int cells;
+    const cell* c = ncplane_chunk(n, chunk, &cells);
+    for(int i = 0 ; c && i < cells ; ++i){
+      need += egcpool_compacted_bytes(&n->pool, &c[i]);
+    }
+  }
+  egcpool pool;
+  egcpool_init(&pool);
+  if(need && egcpool_grow(&pool, need)){
+    return -1;
+  }
+  for(int chunk = 0 ; chunk < ncplane_chunkcount(n) ; ++chunk){
+    int cells;
+    cell* c = ncplane_chunk(n, chunk, &cells);
+    for(int i = 0 ; c && i < cells ; ++i){
+      egcpool_move(&pool, &n->pool, &c[i]);
+    }
+  }
+  egcpool_move(&pool, &n->pool, &n->basecell);
+  egcpool_dump(&n->pool);
+  n->pool = pool;
+  ++n->nc->stats.egcpool_compactions;
+  return 0;
+}
+
 // can be used on stdplane, unlike ncplane_resize() which prohibits it.
 int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
                             int keeplenx, int yoff, int xoff, int ylen, int xlen){
@@ -477,52 +689,55 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
   loginfo(n->nc, "%dx%d @ %d/%d → %d/%d @ %d/%d (keeping %dx%d from %d/%d)\n", rows, cols, n->absy, n->absx, ylen, xlen, n->absy + keepy + yoff, n->absx + keepx + xoff, keepleny, keeplenx, keepy, keepx);
   // we're good to resize. we'll need alloc up a new framebuffer, and copy in
   // those elements we're retaining, zeroing out the rest. alternatively, if
-  // we've shrunk, we will be filling the new structure.
-  int keptarea = keepleny * keeplenx;
-  int newarea = ylen * xlen;
-  size_t fbsize = sizeof(cell) * newarea;
-  cell* fb = malloc(fbsize);
-  if(fb == NULL){
-    return -1;
-  }
-  // update the cursor, if it would otherwise be off-plane
-  if(n->y >= ylen){
-    n->y = ylen - 1;
-  }
-  if(n->x >= xlen){
-    n->x = xlen - 1;
-  }
-  cell* preserved = n->fb;
-  n->nc->stats.fbbytes -= sizeof(*preserved) * (rows * cols);
-  n->nc->stats.fbbytes += fbsize;
-  n->fb = fb;
-  const int oldabsy = n->absy;
-  // go ahead and move. we can no longer fail at this point. but don't yet
-  // resize, because n->len[xy] are used in fbcellidx() in the loop below. we
-  // don't use ncplane_move_yx(), because we want to planebinding-invariant.
-  n->absy += keepy + yoff;
-  n->absx += keepx + xoff;
-//fprintf(stderr, "absx: %d keepx: %d xoff: %d\n", n->absx, keepx, xoff);
-  if(keptarea == 0){ // keep nothing, resize/move only
-    // if we're keeping nothing, dump the old egcspool. otherwise, we go ahead
-    // and keep it. perhaps we ought compact it?
-    memset(fb, 0, sizeof(*fb) * newarea);
-    egcpool_dump(&n->pool);
-    n->lenx = xlen;
-    n->leny = ylen;
-    free(preserved);
-    return 0;
+  // we've shrunk, we will be filling the new structure. this is all done
+  // before the plane is touched, so that we can yet fail cleanly. a sparse
+  // plane gets new tiles only for those of its rows which retain anything
+  // from tiles which were present.
+  cell* fb = NULL;
+  cell** tiles = NULL;
+  cell* blankrow = NULL;
+  size_t fbbytes;
+  const int tilecount = (ylen + NCPLANE_TILE_ROWS - 1) / NCPLANE_TILE_ROWS;
+  if(n->fb){
+    fbbytes = sizeof(*fb) * ylen * xlen;
+    if((fb = malloc(fbbytes)) == NULL){
+      return -1;
+    }
+  }else{
+    tiles = calloc(tilecount, sizeof(*tiles));
+    blankrow = calloc(xlen, sizeof(*blankrow));
+    if(tiles == NULL || blankrow == NULL){
+      free(tiles);
+      free(blankrow);
+      return -1;
+    }
+    fbbytes = sizeof(*tiles) * tilecount + sizeof(*blankrow) * xlen;
   }
   // we currently have maxy rows of maxx cells each. we will be keeping rows
   // keepy..keepy + keepleny - 1 and columns keepx..keepx + keeplenx - 1.
   // anything else is zerod out. itery is the row we're writing *to*, and we
   // must write to each (and every cell in each).
+  const int ydelta = keepy + yoff;
   for(int itery = 0 ; itery < ylen ; ++itery){
-    int truey = itery + n->absy;
-    int sourceoffy = truey - oldabsy;
+    const int sourceoffy = itery + ydelta;
 //fprintf(stderr, "sourceoffy: %d keepy: %d ylen: %d\n", sourceoffy, keepy, ylen);
+    const bool kept = sourceoffy >= keepy && sourceoffy < keepy + keepleny;
+    if(fb == NULL){
+      const cell* source;
+      if(!kept || (source = ncplane_row(n, sourceoffy)) == n->blankrow){
+        continue; // remains blank
+      }
+      const int t = itery / NCPLANE_TILE_ROWS;
+      if(tiles[t] == NULL && !alloc_tile(tiles, t, ylen, xlen, &fbbytes)){
+        free_tiles(tiles, tilecount, blankrow);
+        return -1;
+      }
+      cell* row = tiles[t] + fbcellidx(itery % NCPLANE_TILE_ROWS, xlen, 0);
+      memcpy(row + (xoff < 0 ? -xoff : 0), source + keepx, sizeof(*row) * keeplenx);
+      continue;
+    }
     // if we have nothing copied to this line, zero it out in one go
-    if(sourceoffy < keepy || sourceoffy >= keepy + keepleny){
+    if(!kept){
 //fprintf(stderr, "writing 0s to line %d of %d\n", itery, ylen);
       memset(fb + (itery * xlen), 0, sizeof(*fb) * xlen);
     }else{
@@ -534,9 +749,8 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
         copyoff += -xoff;
         copied += -xoff;
       }
-      const int sourceidx = nfbcellidx(n, sourceoffy, keepx);
-//fprintf(stderr, "copying line %d (%d) to %d (%d)\n", sourceoffy, sourceidx, copyoff / xlen, copyoff);
-      memcpy(fb + copyoff, preserved + sourceidx, sizeof(*fb) * keeplenx);
+//fprintf(stderr, "copying line %d to %d (%d)\n", sourceoffy, copyoff / xlen, copyoff);
+      memcpy(fb + copyoff, ncplane_row(n, sourceoffy) + keepx, sizeof(*fb) * keeplenx);
       copyoff += keeplenx;
       copied += keeplenx;
       if(xlen > copied){
@@ -544,14 +758,41 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
       }
     }
   }
+  // update the cursor, if it would otherwise be off-plane
+  if(n->y >= ylen){
+    n->y = ylen - 1;
+  }
+  if(n->x >= xlen){
+    n->x = xlen - 1;
+  }
+  ncplane_dirty_geometry(n);
+  n->nc->stats.fbbytes -= n->fbbytes;
+  n->nc->stats.fbbytes += fbbytes;
+  free(n->fb);
+  free_tiles(n->tiles, ncplane_tilecount(n), n->blankrow);
+  n->fb = fb;
+  n->tiles = tiles;
+  n->blankrow = blankrow;
+  n->fbbytes = fbbytes;
+  // we don't use ncplane_move_yx(), because we want to planebinding-invariant.
+  n->absy += ydelta;
+  n->absx += keepx + xoff;
+//fprintf(stderr, "absx: %d keepx: %d xoff: %d\n", n->absx, keepx, xoff);
   n->lenx = xlen;
   n->leny = ylen;
-  free(preserved);
+  n->logrow = 0; // the new framebuffer's rows are in logical order
+  ncplane_dirty(n);
+  // drop the EGCs of cells which didn't survive. failure to compact leaves
+  // the old pool, which remains valid, so the resize still succeeds.
+  ncplane_compact(n);
   return 0;
 }
 
 int ncplane_resize(ncplane* n, int keepy, int keepx, int keepleny,
                    int keeplenx, int yoff, int xoff, int ylen, int xlen){
+  if(ncplane_traced(n)){
+    trace_resize(n, keepy, keepx, keepleny, keeplenx, yoff, xoff, ylen, xlen);
+  }
   if(n == n->nc->stdplane){
 //fprintf(stderr, "Can't resize standard plane\n");
     return -1;
@@ -564,6 +805,9 @@ int ncplane_destroy(ncplane* ncp){
   if(ncp == NULL){
     return 0;
   }
+  if(ncplane_traced(ncp)){
+    trace_destroy(ncp);
+  }
   if(ncp->nc->stdplane == ncp){
     logerror(ncp->nc, "Won't destroy standard plane\n");
     return -1;
@@ -608,10 +852,12 @@ make_nonblocking(FILE* fp){
 static void
 reset_stats(ncstats* stats){
   uint64_t fbbytes = stats->fbbytes;
+  uint64_t arenabytes = stats->arenabytes;
   memset(stats, 0, sizeof(*stats));
   stats->render_min_ns = 1ull << 62u;
   stats->render_min_bytes = 1ull << 62u;
   stats->fbbytes = fbbytes;
+  stats->arenabytes = arenabytes;
 }
 
 // add the current stats to the cumulative stashed stats, and reset them
@@ -641,17 +887,60 @@ stash_stats(notcurses* nc){
   nc->stashstats.bgemissions += nc->stats.bgemissions;
   nc->stashstats.defaultelisions += nc->stats.defaultelisions;
   nc->stashstats.defaultemissions += nc->stats.defaultemissions;
-  // fbbytes aren't stashed
+  nc->stashstats.cellsculled += nc->stats.cellsculled;
+  nc->stashstats.frames_dropped += nc->stats.frames_dropped;
+  nc->stashstats.renders_coalesced += nc->stats.renders_coalesced;
+  tty_writer_stats(nc, &nc->stats, true);
+  nc->stashstats.paint_ns += nc->stats.paint_ns;
+  nc->stashstats.postpaint_ns += nc->stats.postpaint_ns;
+  nc->stashstats.raster_ns += nc->stats.raster_ns;
+  nc->stashstats.write_ns += nc->stats.write_ns;
+  for(int i = 0 ; i < NCSTATS_BUCKETS ; ++i){
+    nc->stashstats.paint_hist[i] += nc->stats.paint_hist[i];
+    nc->stashstats.postpaint_hist[i] += nc->stats.postpaint_hist[i];
+    nc->stashstats.raster_hist[i] += nc->stats.raster_hist[i];
+    nc->stashstats.write_hist[i] += nc->stats.write_hist[i];
+  }
+  nc->stashstats.motion_bytes += nc->stats.motion_bytes;
+  nc->stashstats.style_bytes += nc->stats.style_bytes;
+  nc->stashstats.rgb_bytes += nc->stats.rgb_bytes;
+  nc->stashstats.palette_bytes += nc->stats.palette_bytes;
+  nc->stashstats.default_bytes += nc->stats.default_bytes;
+  nc->stashstats.glyph_bytes += nc->stats.glyph_bytes;
+  nc->stashstats.palprog_bytes += nc->stats.palprog_bytes;
+  nc->stashstats.sync_bytes += nc->stats.sync_bytes;
+  nc->stashstats.hwscrolls += nc->stats.hwscrolls;
+  nc->stashstats.egcpool_compactions += nc->stats.egcpool_compactions;
+  // fbbytes, arenabytes, queuedbytes, and the egcpool stats aren't stashed
   reset_stats(&nc->stats);
 }
 
+// egcpool usage isn't tracked as it changes, but summed over the planes
+static void
+egcpool_stats(const notcurses* nc, ncstats* stats){
+  stats->egcpool_bytes = 0;
+  stats->egcpool_max_bytes = 0;
+  stats->egcpool_used = 0;
+  stats->egcpool_free = 0;
+  for(const ncplane* p = nc->top ; p ; p = p->below){
+    stats->egcpool_bytes += p->pool.poolsize;
+    if(stats->egcpool_max_bytes < (uint64_t)p->pool.poolsize){
+      stats->egcpool_max_bytes = p->pool.poolsize;
+    }
+    stats->egcpool_used += p->pool.poolused;
+    stats->egcpool_free += p->pool.poolfree;
+  }
+}
+
 void notcurses_stats(const notcurses* nc, ncstats* stats){
   memcpy(stats, &nc->stats, sizeof(*stats));
+  tty_writer_stats(nc, stats, false);
+  egcpool_stats(nc, stats);
 }
 
 void notcurses_reset_stats(notcurses* nc, ncstats* stats){
   if(stats){
-    memcpy(stats, &nc->stats, sizeof(*stats));
+    notcurses_stats(nc, stats);
   }
   stash_stats(nc);
 }
@@ -678,15 +967,27 @@ int ffmpeg_log_level(ncloglevel_e level){
 #endif
 }
 
+// set the foreground of 'fp' to palette index 'pal'. the palette escapes are
+// staged in an fbuf, and written with stdio, so they stay ordered with the
+// surrounding (buffered) banner text.
+static void
+banner_fg_palindex(const notcurses* nc, FILE* fp, unsigned pal){
+  fbuf f = {};
+  if(term_fg_palindex(nc, &f, pal) == 0){
+    fbuf_flush(&f, fp);
+  }
+  fbuf_free(&f);
+}
+
 // unless the suppress_banner flag was set, print some version information and
 // (if applicable) warnings to stdout. we are not yet on the alternate screen.
 static void
 init_banner(const notcurses* nc){
   if(!nc->suppress_banner){
     char prefixbuf[BPREFIXSTRLEN + 1];
-    term_fg_palindex(nc, stdout, nc->tcache.colors <= 256 ? 50 % nc->tcache.colors : 0x20e080);
+    banner_fg_palindex(nc, stdout, nc->tcache.colors <= 256 ? 50 % nc->tcache.colors : 0x20e080);
     printf("\n notcurses %s by nick black et al", notcurses_version());
-    term_fg_palindex(nc, stdout, nc->tcache.colors <= 256 ? 12 % nc->tcache.colors : 0x2080e0);
+    banner_fg_palindex(nc, stdout, nc->tcache.colors <= 256 ? 12 % nc->tcache.colors : 0x2080e0);
     printf("\n  %d rows, %d columns (%sB), %d colors (%s)\n"
            "  compiled with gcc-%s\n"
            "  terminfo from %s\n",
@@ -703,12 +1004,12 @@ init_banner(const notcurses* nc){
 #ifdef USE_OIIO
     printf("  openimageio %s\n", oiio_version());
 #else
-    term_fg_palindex(nc, stderr, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
+    banner_fg_palindex(nc, stderr, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
     fprintf(stderr, "\n Warning! Notcurses was built without multimedia support.\n");
 #endif
 #endif
     fflush(stdout);
-    term_fg_palindex(nc, stderr, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
+    banner_fg_palindex(nc, stderr, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
     if(!nc->tcache.RGBflag){ // FIXME
       fprintf(stderr, "\n Warning! Colors subject to https://github.com/dankamongmen/notcurses/issues/4");
       fprintf(stderr, "\n  Specify a (correct) TrueColor TERM, or COLORTERM=24bit.\n");
@@ -794,7 +1095,7 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
     fprintf(stderr, "Provided an illegal negative margin, refusing to start\n");
     return NULL;
   }
-  if(opts->flags > (NCOPTION_NO_ALTERNATE_SCREEN << 1u)){
+  if(opts->flags >= (NCOPTION_COMPACT_EGCPOOLS << 1u)){
     fprintf(stderr, "Provided an illegal Notcurses option, refusing to start\n");
     return NULL;
   }
@@ -815,7 +1116,8 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
     free(ret);
     return NULL;
   }
-  if(outfp == NULL){
+  const bool headless = opts->flags & NCOPTION_HEADLESS;
+  if(outfp == NULL && !headless){
     outfp = stdout;
   }
   ret->margin_t = opts->margin_t;
@@ -824,21 +1126,34 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
   ret->margin_r = opts->margin_r;
   ret->stats.fbbytes = 0;
   ret->stashstats.fbbytes = 0;
+  ret->stats.arenabytes = 0;
+  ret->stashstats.arenabytes = 0;
   reset_stats(&ret->stats);
   reset_stats(&ret->stashstats);
-  ret->ttyfp = outfp;
+  ret->ttyfp = headless ? NULL : outfp;
   ret->renderfp = opts->renderfp;
+  ret->vscreen = NULL;
+  ret->trace = NULL;
   ret->inputescapes = NULL;
-  ret->ttyinfp = stdin; // FIXME
+  // a headless context reads no input, and leaves stdin as it found it
+  ret->ttyinfp = headless ? NULL : stdin; // FIXME
   memset(&ret->rstate, 0, sizeof(ret->rstate));
   memset(&ret->palette_damage, 0, sizeof(ret->palette_damage));
   memset(&ret->palette, 0, sizeof(ret->palette));
   ret->lastframe = NULL;
+  ret->dirtyrows = NULL;
+  memset(&ret->hwscroll, 0, sizeof(ret->hwscroll));
   ret->lfdimy = 0;
   ret->lfdimx = 0;
   ret->libsixel = false;
+  ret->rworkers = NULL;
+  ret->writer = NULL;
+  ret->asyncwrite = opts->flags & NCOPTION_ASYNC_WRITE;
+  ret->syncupdates = opts->flags & NCOPTION_SYNC_UPDATES;
+  ret->compactpools = opts->flags & NCOPTION_COMPACT_EGCPOOLS;
+  memset(&ret->arena, 0, sizeof(ret->arena));
   egcpool_init(&ret->pool);
-  if(make_nonblocking(ret->ttyinfp)){
+  if(ret->ttyinfp && make_nonblocking(ret->ttyinfp)){
     free(ret);
     return NULL;
   }
@@ -851,7 +1166,7 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
     free(ret);
     return NULL;
   }
-  ret->ttyfd = get_tty_fd(ret, ret->ttyfp);
+  ret->ttyfd = headless ? -1 : get_tty_fd(ret, ret->ttyfp);
   is_linux_console(ret, !!(opts->flags & NCOPTION_NO_FONT_CHANGES));
   notcurses_mouse_disable(ret);
   if(ret->ttyfd >= 0){
@@ -878,13 +1193,20 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
       }
     }
   }
-  if(setup_signals(ret,
-                   (opts->flags & NCOPTION_NO_QUIT_SIGHANDLERS),
-                   (opts->flags & NCOPTION_NO_WINCH_SIGHANDLER))){
-    goto err;
+  // a headless context has no terminal to restore, nor one to be resized, and
+  // mustn't claim the process-wide signal handlers from any other context
+  if(!headless){
+    if(setup_signals(ret, opts->flags & NCOPTION_NO_QUIT_SIGHANDLERS,
+                     opts->flags & NCOPTION_NO_WINCH_SIGHANDLER)){
+      goto err;
+    }
+  }
+  const char* termtype = opts->termtype;
+  if(headless && termtype == NULL && getenv("TERM") == NULL){
+    termtype = "xterm-256color";
   }
   int termerr;
-  if(setupterm(opts->termtype, ret->ttyfd, &termerr) != OK){
+  if(setupterm(termtype, ret->ttyfd, &termerr) != OK){
     fprintf(stderr, "Terminfo error %d (see terminfo(3ncurses))\n", termerr);
     goto err;
   }
@@ -906,9 +1228,21 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
             longname_term ? longname_term : "?");
   }
   ret->truecols = dimx;
+  ret->truerows = dimy;
+  if(headless){
+    if((ret->vscreen = malloc(sizeof(*ret->vscreen))) == NULL){
+      goto err;
+    }
+    if(vscreen_init(ret->vscreen, dimy, dimx)){
+      free(ret->vscreen);
+      ret->vscreen = NULL;
+      goto err;
+    }
+  }
   if(interrogate_terminfo(&ret->tcache)){
     goto err;
   }
+  paramcache_init(&ret->pcache, &ret->tcache);
   if(prep_special_keys(ret)){
     goto err;
   }
@@ -936,16 +1270,38 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
       }
     }
   }
-  if((ret->rstate.mstreamfp = open_memstream(&ret->rstate.mstream, &ret->rstate.mstrsize)) == NULL){
-    free_plane(ret->top);
-    goto err;
-  }
   ret->rstate.x = ret->rstate.y = -1;
+  if(opts->flags & NCOPTION_PARALLEL_RENDER){
+    if(render_workers_start(ret)){
+      free_plane(ret->top);
+      goto err;
+    }
+  }
+  if(opts->flags & NCOPTION_ASYNC_WRITE){
+    if(tty_writer_start(ret)){
+      render_workers_stop(ret);
+      free_plane(ret->top);
+      goto err;
+    }
+  }
+  // record operations on planes for notcurses_replay(), if asked to
+  const char* tracefile = getenv("NOTCURSES_TRACE");
+  if(tracefile && *tracefile){
+    if(trace_start(ret, tracefile)){
+      tty_writer_stop(ret);
+      render_workers_stop(ret);
+      free_plane(ret->top);
+      goto err;
+    }
+  }
   init_banner(ret);
   // flush on the switch to alternate screen, lest initial output be swept away
   if(ret->ttyfd >= 0){
     if(ret->tcache.smcup){
       if(tty_emit("smcup", ret->tcache.smcup, ret->ttyfd)){
+        trace_stop(ret);
+        tty_writer_stop(ret);
+        render_workers_stop(ret);
         free_plane(ret->top);
         goto err;
       }
@@ -963,7 +1319,14 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
 err:
   // FIXME looks like we have some memory leaks on this error path?
   tcsetattr(ret->ttyfd, TCSANOW, &ret->tpreserved);
-  drop_signals(ret);
+  if(!headless){
+    drop_signals(ret);
+  }
+  trace_stop(ret);
+  if(ret->vscreen){
+    vscreen_free(ret->vscreen);
+    free(ret->vscreen);
+  }
   free(ret);
   return NULL;
 }
@@ -984,21 +1347,29 @@ void notcurses_drop_planes(notcurses* nc){
 int notcurses_stop(notcurses* nc){
   int ret = 0;
   if(nc){
+    // drain any frames still queued before writing anything of our own
+    ret |= tty_writer_stop(nc);
+    ret |= trace_stop(nc);
     ret |= notcurses_stop_minimal(nc);
     while(nc->top){
       ncplane* p = nc->top->below;
       free_plane(nc->top);
       nc->top = p;
     }
-    if(nc->rstate.mstreamfp){
-      fclose(nc->rstate.mstreamfp);
-    }
     if(nc->ttyfd >= 0){
       ret |= close(nc->ttyfd);
     }
+    render_workers_stop(nc);
+    render_arena_free(&nc->arena);
+    if(nc->vscreen){
+      vscreen_free(nc->vscreen);
+      free(nc->vscreen);
+    }
     egcpool_dump(&nc->pool);
+    free(nc->dirtyrows);
     free(nc->lastframe);
-    free(nc->rstate.mstream);
+    fbuf_free(&nc->rstate.f);
+    paramcache_free(&nc->pcache);
     input_free_esctrie(&nc->inputescapes);
     stash_stats(nc);
     if(!nc->suppress_banner){
@@ -1045,6 +1416,42 @@ int notcurses_stop(notcurses* nc){
                 nc->stashstats.cellemissions, nc->stashstats.cellelisions,
                 (nc->stashstats.cellemissions + nc->stashstats.cellelisions) == 0 ? 0 :
                 (nc->stashstats.cellelisions * 100.0) / (nc->stashstats.cellemissions + nc->stashstats.cellelisions));
+        fprintf(stderr, "Occluded cells culled: %ju\n", nc->stashstats.cellsculled);
+        if(nc->stashstats.render_bytes){
+          const uint64_t total = nc->stashstats.render_bytes;
+          fprintf(stderr, "Bytes motion/style/rgb/pal/default/glyph/palprog/sync: %.1f%% %.1f%% %.1f%% %.1f%% %.1f%% %.1f%% %.1f%% %.1f%%\n",
+                  nc->stashstats.motion_bytes * 100.0 / total,
+                  nc->stashstats.style_bytes * 100.0 / total,
+                  nc->stashstats.rgb_bytes * 100.0 / total,
+                  nc->stashstats.palette_bytes * 100.0 / total,
+                  nc->stashstats.default_bytes * 100.0 / total,
+                  nc->stashstats.glyph_bytes * 100.0 / total,
+                  nc->stashstats.palprog_bytes * 100.0 / total,
+                  nc->stashstats.sync_bytes * 100.0 / total);
+        }
+        if(nc->stashstats.renders){
+          const uint64_t* hists[] = {
+            nc->stashstats.paint_hist, nc->stashstats.postpaint_hist,
+            nc->stashstats.raster_hist, nc->stashstats.write_hist,
+          };
+          char p50[4][BPREFIXSTRLEN + 1];
+          char p99[4][BPREFIXSTRLEN + 1];
+          for(int i = 0 ; i < 4 ; ++i){
+            qprefix(ncstats_percentile(hists[i], 0.5), NANOSECS_IN_SEC, p50[i], 0);
+            qprefix(ncstats_percentile(hists[i], 0.99), NANOSECS_IN_SEC, p99[i], 0);
+          }
+          fprintf(stderr, "Paint/post/raster/write p50: %ss %ss %ss %ss p99: %ss %ss %ss %ss\n",
+                  p50[0], p50[1], p50[2], p50[3], p99[0], p99[1], p99[2], p99[3]);
+        }
+        if(nc->stashstats.frames_dropped){
+          fprintf(stderr, "Unwritten frames dropped: %ju\n", nc->stashstats.frames_dropped);
+        }
+        if(nc->stashstats.hwscrolls){
+          fprintf(stderr, "Rows scrolled by the terminal: %ju\n", nc->stashstats.hwscrolls);
+        }
+        if(nc->stashstats.renders_coalesced){
+          fprintf(stderr, "Renders coalesced: %ju\n", nc->stashstats.renders_coalesced);
+        }
       }
     }
     del_curterm(cur_term);
@@ -1134,11 +1541,21 @@ int ncplane_set_bg_palindex(ncplane* n, int idx){
 }
 
 int ncplane_set_base_cell(ncplane* ncp, const cell* c){
-  return cell_duplicate(ncp, &ncp->basecell, c);
+  ncplane_dirty(ncp);
+  int ret = cell_duplicate(ncp, &ncp->basecell, c);
+  if(ncplane_traced(ncp)){
+    trace_base(ncp);
+  }
+  return ret;
 }
 
 int ncplane_set_base(ncplane* ncp, const char* egc, uint32_t attrword, uint64_t channels){
-  return cell_prime(ncp, &ncp->basecell, egc, attrword, channels);
+  ncplane_dirty(ncp);
+  int ret = cell_prime(ncp, &ncp->basecell, egc, attrword, channels);
+  if(ncplane_traced(ncp)){
+    trace_base(ncp);
+  }
+  return ret;
 }
 
 int ncplane_base(ncplane* ncp, cell* c){
@@ -1146,15 +1563,28 @@ int ncplane_base(ncplane* ncp, cell* c){
 }
 
 const char* cell_extended_gcluster(const ncplane* n, const cell* c){
-  return extended_gcluster(n, c);
+  if(cell_simple_p(c)){
+    // simple cells can't be NUL-terminated in place. rotate through a few
+    // buffers, so that callers can compare a couple of EGCs.
+    static __thread char egcs[4][CELL_INLINE_BYTES + 1];
+    static __thread unsigned next;
+    char* egc = egcs[next++ % (sizeof(egcs) / sizeof(*egcs))];
+    cell_simple_egc(c, egc);
+    return egc;
+  }
+  return egcpool_extended_gcluster(&n->pool, c);
 }
 
 // 'n' ends up above 'above'
 int ncplane_move_above(ncplane* restrict n, ncplane* restrict above){
+  if(ncplane_traced(n)){
+    trace_above(n, above);
+  }
   if(n == above){
     return -1;
   }
   if(n->below != above){
+    ncplane_dirty(n);
     // splice out 'n'
     if(n->below){
       n->below->above = n->above;
@@ -1179,10 +1609,14 @@ int ncplane_move_above(ncplane* restrict n, ncplane* restrict above){
 
 // 'n' ends up below 'below'
 int ncplane_move_below(ncplane* restrict n, ncplane* restrict below){
+  if(ncplane_traced(n)){
+    trace_below(n, below);
+  }
   if(n == below){
     return -1;
   }
   if(n->above != below){
+    ncplane_dirty(n);
     if(n->below){
       n->below->above = n->above;
     }else{
@@ -1205,7 +1639,11 @@ int ncplane_move_below(ncplane* restrict n, ncplane* restrict below){
 }
 
 void ncplane_move_top(ncplane* n){
+  if(ncplane_traced(n)){
+    trace_top(n);
+  }
   if(n->above){
+    ncplane_dirty(n);
     if( (n->above->below = n->below) ){
       n->below->above = n->above;
     }else{
@@ -1220,7 +1658,11 @@ void ncplane_move_top(ncplane* n){
 }
 
 void ncplane_move_bottom(ncplane* n){
+  if(ncplane_traced(n)){
+    trace_bottom(n);
+  }
   if(n->below){
+    ncplane_dirty(n);
     if( (n->below->above = n->above) ){
       n->above->below = n->below;
     }else{
@@ -1254,18 +1696,23 @@ static inline void
 scroll_down(ncplane* n){
   n->x = 0;
   if(n->y == n->leny - 1){
+    ncplane_dirty(n); // every logical row has changed
+    ++n->scrolls;     // but the renderer might get by with a hardware scroll
     n->logrow = (n->logrow + 1) % n->leny;
-    cell* row = n->fb + nfbcellidx(n, n->y, 0);
-    for(int clearx = 0 ; clearx < n->lenx ; ++clearx){
-      cell_release(n, &row[clearx]);
+    cell* row = ncplane_row_present(n, n->y);
+    if(row){ // a sparse plane's missing rows are already blank
+      for(int clearx = 0 ; clearx < n->lenx ; ++clearx){
+        cell_release(n, &row[clearx]);
+      }
+      memset(row, 0, sizeof(*row) * n->lenx);
     }
-    memset(row, 0, sizeof(*row) * n->lenx);
   }else{
     ++n->y;
   }
 }
 
-int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
+static int
+putc_yx(ncplane* n, int y, int x, const cell* c){
   // if scrolling is enabled, check *before ncplane_cursor_move_yx()* whether
   // we're past the end of the line, and move to the next line if so.
   bool wide = cell_double_wide_p(c);
@@ -1288,13 +1735,18 @@ int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
   // that cell as wide). Any character placed atop one half of a wide character
   // obliterates the other half. Note that a wide char can thus obliterate two
   // wide chars, totalling four columns.
-  cell* targ = ncplane_cell_ref_yx(n, n->y, n->x);
+  cell* row = ncplane_row_writable(n, n->y);
+  if(row == NULL){
+    return -1;
+  }
+  ncplane_dirty_rows(n, n->y, 1);
+  cell* targ = &row[n->x];
   if(n->x > 0){
     if(cell_double_wide_p(targ)){ // replaced cell is half of a wide char
       if(targ->gcluster == 0){ // we're the right half
-        cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x - 1)]);
+        cell_obliterate(n, &row[n->x - 1]);
       }else{
-        cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 1)]);
+        cell_obliterate(n, &row[n->x + 1]);
       }
     }
   }
@@ -1305,10 +1757,10 @@ int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
   if(wide){ // must set our right wide, and check for further damage
     ++cols;
     if(n->x < n->lenx - 1){ // check to our right
-      cell* candidate = &n->fb[nfbcellidx(n, n->y, n->x + 1)];
+      cell* candidate = &row[n->x + 1];
       if(n->x < n->lenx - 2){
         if(cell_wide_left_p(candidate)){
-          cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 2)]);
+          cell_obliterate(n, &row[n->x + 2]);
         }
       }
       cell_obliterate(n, candidate);
@@ -1320,6 +1772,19 @@ int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
   return cols;
 }
 
+// every put passes through here or ncplane_putegc_yx(), and is recorded
+// there when tracing. the replay's cursor then moves just as ours does.
+int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
+  if(!ncplane_traced(n)){
+    return putc_yx(n, y, x, c);
+  }
+  trace_putc(n, y, x, c);
+  int ret = putc_yx(n, y, x, c);
+  n->tracey = n->y;
+  n->tracex = n->x;
+  return ret;
+}
+
 static inline int
 cell_load_direct(ncplane* n, cell* c, const char* gcluster, int bytes, int cols){
   if(bytes < 0 || cols < 0){
@@ -1350,11 +1815,15 @@ cell_load_direct(ncplane* n, cell* c, const char* gcluster, int bytes, int cols)
   }else{
     c->channels |= CELL_NOBACKGROUND_MASK;
   }
+  if(egc_inlinable_p(gcluster, bytes)){
+    c->gcluster = egc_inline(gcluster, bytes);
+    return bytes;
+  }
   int eoffset = egcpool_stash(&n->pool, gcluster, bytes);
   if(eoffset < 0){
     return -1;
   }
-  c->gcluster = eoffset + 0x80;
+  c->gcluster = egcpool_gcluster(eoffset);
   return bytes;
 }
 
@@ -1364,7 +1833,8 @@ int cell_load(ncplane* n, cell* c, const char* gcluster){
   return cell_load_direct(n, c, gcluster, bytes, cols);
 }
 
-int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes){
+static int
+putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes){
   int cols;
   int bytes = utf8_egc_len(gclust, &cols);
   if(bytes < 0){
@@ -1396,13 +1866,18 @@ int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes)
   // that cell as wide). Any character placed atop one half of a wide character
   // obliterates the other half. Note that a wide char can thus obliterate two
   // wide chars, totalling four columns.
-  cell* targ = ncplane_cell_ref_yx(n, n->y, n->x);
+  cell* row = ncplane_row_writable(n, n->y);
+  if(row == NULL){
+    return -1;
+  }
+  ncplane_dirty_rows(n, n->y, 1);
+  cell* targ = &row[n->x];
   if(n->x > 0){
     if(cell_double_wide_p(targ)){ // replaced cell is half of a wide char
       if(targ->gcluster == 0){ // we're the right half
-        cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x - 1)]);
+        cell_obliterate(n, &row[n->x - 1]);
       }else{
-        cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 1)]);
+        cell_obliterate(n, &row[n->x + 1]);
       }
     }
   }
@@ -1417,10 +1892,10 @@ int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes)
   targ->channels = channels;
   if(wide){ // must set our right wide, and check for further damage
     if(n->x < n->lenx - 1){ // check to our right
-      cell* candidate = &n->fb[nfbcellidx(n, n->y, n->x + 1)];
+      cell* candidate = &row[n->x + 1];
       if(n->x < n->lenx - 2){
         if(cell_wide_left_p(candidate)){
-          cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 2)]);
+          cell_obliterate(n, &row[n->x + 2]);
         }
       }
       cell_obliterate(n, candidate);
@@ -1433,10 +1908,275 @@ int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes)
   return cols;
 }
 
+int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes){
+  if(!ncplane_traced(n)){
+    return putegc_yx(n, y, x, gclust, sbytes);
+  }
+  int cols;
+  int bytes = utf8_egc_len(gclust, &cols);
+  if(bytes < 0){
+    return -1;
+  }
+  trace_putegc(n, y, x, gclust, bytes);
+  int ret = putegc_yx(n, y, x, gclust, sbytes);
+  n->tracey = n->y;
+  n->tracex = n->x;
+  return ret;
+}
+
+// resolve the origin and check the geometry of a block of cells to be moved
+// between a plane and a caller's array. -1 for 'y' or 'x' means the cursor's
+// current coordinate. the block must lie entirely within the plane.
+static int
+cell_block_check(const ncplane* n, int* y, int* x, int leny, int lenx, int stride){
+  if(*y == -1){
+    *y = n->y;
+  }
+  if(*x == -1){
+    *x = n->x;
+  }
+  if(leny <= 0 || lenx <= 0 || stride < lenx){
+    logerror(n->nc, "Invalid block geometry %dx%d (stride %d)\n", leny, lenx, stride);
+    return -1;
+  }
+  if(*y < 0 || *x < 0 || *y + leny > n->leny || *x + lenx > n->lenx){
+    logerror(n->nc, "Block %dx%d at %d/%d exceeds plane %dx%d\n",
+             leny, lenx, *y, *x, n->leny, n->lenx);
+    return -1;
+  }
+  return 0;
+}
+
+// we're about to overwrite columns [x, x + lenx) of 'row'. obliterate the
+// other halves of any wide glyphs split by the block's edges.
+static void
+cell_block_split(ncplane* n, cell* row, int x, int lenx){
+  if(x > 0 && cell_wide_right_p(&row[x])){
+    cell_obliterate(n, &row[x - 1]);
+  }
+  int last = x + lenx - 1;
+  if(last < n->lenx - 1 && cell_wide_left_p(&row[last])){
+    cell_obliterate(n, &row[last + 1]);
+  }
+}
+
+// the columns [x, x + lenx) of 'row' have been written. if the last of them
+// is the left half of a wide glyph, claim the column to its right, as
+// ncplane_putc_yx() would.
+static void
+cell_block_claim(ncplane* n, cell* row, int x, int lenx){
+  int last = x + lenx - 1;
+  if(last < n->lenx - 1 && cell_wide_left_p(&row[last])){
+    cell* candidate = &row[last + 1];
+    if(last < n->lenx - 2 && cell_wide_left_p(candidate)){
+      cell_obliterate(n, &row[last + 2]);
+    }
+    cell_obliterate(n, candidate);
+    cell_set_wide(candidate);
+    candidate->channels = row[last].channels;
+    candidate->attrword = row[last].attrword;
+  }
+}
+
+// cells written to the framebuffer in blocks are recorded as snapshots of the
+// rows they touched (including any wide glyphs obliterated beyond them).
+static inline void
+cell_block_trace(ncplane* n, int y, int leny){
+  if(ncplane_traced(n)){
+    trace_cells(n, y, 0, leny, -1);
+  }
+}
+
+int ncplane_put_cells(ncplane* n, int y, int x, int leny, int lenx,
+                      const ncplane* src, const cell* cells, int stride){
+  if(cell_block_check(n, &y, &x, leny, lenx, stride)){
+    return -1;
+  }
+  // size up the pooled EGCs, so that the pool need be grown at most once
+  size_t pooled = 0;
+  for(int yy = 0 ; yy < leny ; ++yy){
+    const cell* c = cells + yy * stride;
+    for(int xx = 0 ; xx < lenx ; ++xx){
+      if(!cell_simple_p(&c[xx])){
+        if(src == NULL){
+          logerror(n->nc, "Complex cell without a source plane\n");
+          return -1;
+        }
+        pooled += egcpool_slot_bytes(strlen(extended_gcluster(src, &c[xx])) + 1);
+      }
+    }
+  }
+  // this is only a hint. should it fail, stashing might yet find space.
+  egcpool_reserve(&n->pool, pooled);
+  ncplane_dirty_rows(n, y, leny);
+  for(int yy = 0 ; yy < leny ; ++yy){
+    cell* row = ncplane_row_writable(n, y + yy);
+    if(row == NULL){
+      cell_block_trace(n, y, leny);
+      return -1;
+    }
+    const cell* c = cells + yy * stride;
+    cell_block_split(n, row, x, lenx);
+    for(int xx = 0 ; xx < lenx ; ++xx){
+      if(cell_duplicate_far(&n->pool, &row[x + xx], src, &c[xx]) < 0){
+        logerror(n->nc, "Failed duplicating cell\n");
+        cell_block_trace(n, y, leny);
+        return -1;
+      }
+    }
+    cell_block_claim(n, row, x, lenx);
+  }
+  cell_block_trace(n, y, leny);
+  return leny * lenx;
+}
+
+// an entry of the table passed to ncplane_put_egcs(), measured
+typedef struct egcentry {
+  const char* egc;
+  int bytes;
+  int cols;
+  bool pooled;         // too long (or otherwise unfit) to be held inline
+  uint32_t gcluster;   // the inline gcluster, or 0 if it must be pooled
+} egcentry;
+
+int ncplane_put_egcs(ncplane* n, int y, int x, int leny, int lenx,
+                     const char* const* egcs, int egccount,
+                     const uint32_t* indices, const cell* styles, int stride){
+  if(cell_block_check(n, &y, &x, leny, lenx, stride)){
+    return -1;
+  }
+  if(egccount <= 0){
+    return -1;
+  }
+  // measure each distinct EGC once, up front
+  egcentry* table = malloc(sizeof(*table) * egccount);
+  if(table == NULL){
+    return -1;
+  }
+  for(int i = 0 ; i < egccount ; ++i){
+    egcentry* e = &table[i];
+    e->egc = egcs[i];
+    e->bytes = utf8_egc_len(e->egc, &e->cols);
+    if(e->bytes < 0 || e->egc[e->bytes] || e->cols < 0){
+      logerror(n->nc, "Table entry %d is not a single EGC\n", i);
+      free(table);
+      return -1;
+    }
+    e->pooled = !egc_inlinable_p(e->egc, e->bytes);
+    e->gcluster = e->pooled ? 0 : egc_inline(e->egc, e->bytes);
+  }
+  size_t pooled = 0;
+  for(int yy = 0 ; yy < leny ; ++yy){
+    const uint32_t* idx = indices + yy * stride;
+    for(int xx = 0 ; xx < lenx ; ++xx){
+      if(idx[xx] >= (uint32_t)egccount){
+        logerror(n->nc, "Index %u exceeds table of %d\n", idx[xx], egccount);
+        free(table);
+        return -1;
+      }
+      if(table[idx[xx]].pooled){
+        pooled += egcpool_slot_bytes(table[idx[xx]].bytes + 1);
+      }
+    }
+  }
+  // this is only a hint. should it fail, stashing might yet find space.
+  egcpool_reserve(&n->pool, pooled);
+  ncplane_dirty_rows(n, y, leny);
+  int ret = leny * lenx;
+  for(int yy = 0 ; yy < leny && ret > 0 ; ++yy){
+    cell* row = ncplane_row_writable(n, y + yy);
+    if(row == NULL){
+      ret = -1;
+      break;
+    }
+    const uint32_t* idx = indices + yy * stride;
+    cell_block_split(n, row, x, lenx);
+    for(int xx = 0 ; xx < lenx ; ++xx){
+      const egcentry* e = &table[idx[xx]];
+      cell* targ = &row[x + xx];
+      pool_release(&n->pool, targ);
+      if(e->pooled){
+        int eoffset = egcpool_stash(&n->pool, e->egc, e->bytes);
+        if(eoffset < 0){
+          targ->gcluster = 0;
+          ret = -1;
+          break;
+        }
+        targ->gcluster = egcpool_gcluster(eoffset);
+      }else{
+        targ->gcluster = e->gcluster;
+      }
+      if(styles){
+        targ->attrword = styles[yy * stride + xx].attrword;
+        targ->channels = styles[yy * stride + xx].channels & ~CELL_WIDEASIAN_MASK;
+      }else{
+        targ->attrword = n->attrword;
+        targ->channels = n->channels & ~CELL_WIDEASIAN_MASK;
+      }
+      // a wide EGC claims the next column of the block as its right half;
+      // that column's index is ignored.
+      if(e->cols > 1){
+        targ->channels |= CELL_WIDEASIAN_MASK;
+        if(xx < lenx - 1){
+          cell* right = &row[x + ++xx];
+          cell_obliterate(n, right);
+          cell_set_wide(right);
+          right->channels = targ->channels;
+          right->attrword = targ->attrword;
+        }
+      }
+    }
+    cell_block_claim(n, row, x, lenx);
+  }
+  free(table);
+  cell_block_trace(n, y, leny);
+  return ret;
+}
+
+int ncplane_get_cells(ncplane* n, int y, int x, int leny, int lenx,
+                      cell* cells, int stride){
+  if(cell_block_check(n, &y, &x, leny, lenx, stride)){
+    return -1;
+  }
+  size_t pooled = 0;
+  for(int yy = 0 ; yy < leny ; ++yy){
+    const cell* row = ncplane_row(n, y + yy) + x;
+    for(int xx = 0 ; xx < lenx ; ++xx){
+      if(!cell_simple_p(&row[xx])){
+        pooled += egcpool_slot_bytes(strlen(extended_gcluster(n, &row[xx])) + 1);
+      }
+    }
+  }
+  // this is only a hint. should it fail, stashing might yet find space.
+  egcpool_reserve(&n->pool, pooled);
+  for(int yy = 0 ; yy < leny ; ++yy){
+    cell* c = cells + yy * stride;
+    for(int xx = 0 ; xx < lenx ; ++xx){
+      // the pool might move as we stash, so look the source up anew each time
+      const cell* fbc = &ncplane_row(n, y + yy)[x + xx];
+      c[xx].gcluster = 0; // we don't release whatever was here
+      if(cell_duplicate_far(&n->pool, &c[xx], n, fbc) < 0){
+        logerror(n->nc, "Failed duplicating cell\n");
+        while(xx--){
+          cell_release(n, &c[xx]);
+        }
+        while(yy--){
+          c -= stride;
+          for(xx = 0 ; xx < lenx ; ++xx){
+            cell_release(n, &c[xx]);
+          }
+        }
+        return -1;
+      }
+    }
+  }
+  return leny * lenx;
+}
+
 int ncplane_putsimple_stainable(ncplane* n, char c){
   uint64_t channels = n->channels;
   uint32_t attrword = n->attrword;
-  const cell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* targ = &ncplane_row(n, n->y)[n->x];
   n->channels = targ->channels;
   n->attrword = targ->attrword;
   int ret = ncplane_putsimple(n, c);
@@ -1448,7 +2188,7 @@ int ncplane_putsimple_stainable(ncplane* n, char c){
 int ncplane_putwegc_stainable(ncplane* n, const wchar_t* gclust, int* sbytes){
   uint64_t channels = n->channels;
   uint32_t attrword = n->attrword;
-  const cell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* targ = &ncplane_row(n, n->y)[n->x];
   n->channels = targ->channels;
   n->attrword = targ->attrword;
   int ret = ncplane_putwegc(n, gclust, sbytes);
@@ -1460,7 +2200,7 @@ int ncplane_putwegc_stainable(ncplane* n, const wchar_t* gclust, int* sbytes){
 int ncplane_putegc_stainable(ncplane* n, const char* gclust, int* sbytes){
   uint64_t channels = n->channels;
   uint32_t attrword = n->attrword;
-  const cell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* targ = &ncplane_row(n, n->y)[n->x];
   n->channels = targ->channels;
   n->attrword = targ->attrword;
   int ret = ncplane_putegc(n, gclust, sbytes);
@@ -1473,7 +2213,7 @@ int ncplane_cursor_at(const ncplane* n, cell* c, char** gclust){
   if(n->y == n->leny && n->x == n->lenx){
     return -1;
   }
-  const cell* src = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* src = &ncplane_row(n, n->y)[n->x];
   memcpy(c, src, sizeof(*src));
   *gclust = NULL;
   if(!cell_simple_p(src)){
@@ -1656,14 +2396,13 @@ static bool
 overlong_word(const char* text, int dimx){
   size_t width = 0;
   while(*text && !iswordbreak(*text)){
-    mbstate_t mbstate = {};
-    wchar_t w;
-    size_t consumed = mbrtowc(&w, text, MB_CUR_MAX, &mbstate);
-    if(consumed == (size_t)-2 || consumed == (size_t)-1){
+    uint32_t w;
+    int consumed = utf8_decode(text, &w);
+    if(consumed < 0){
       return false;
     }
     text += consumed;
-    size_t wide = wcwidth(w);
+    int wide = ucs_width(w);
     if(wide > 0){
       width += wide;
     }
@@ -1691,7 +2430,6 @@ int ncplane_puttext(ncplane* n, int y, ncalign_e align, const char* text, size_t
     const char* breaker = NULL; // where the last wordbreaker starts
     int breakercol = 0; // column of the last wordbreaker
     // figure how much text to output on this line
-    mbstate_t mbstate = {};
     int width;
     // let it go all the way through to dimx. on that last hit of dimx, we
     // might catch a space, in which case we want breaker updated. if it's
@@ -1699,9 +2437,28 @@ int ncplane_puttext(ncplane* n, int y, ncalign_e align, const char* text, size_t
     // FIXME what ought be done with \n or multiple spaces?
     while(*text && x <= dimx){
 //fprintf(stderr, "laying out [%s] at %d <= %d, %zu\n", linestart, x, dimx, text - linestart);
-      wchar_t w;
-      size_t consumed = mbrtowc(&w, text, MB_CUR_MAX, &mbstate);
-      if(consumed == (size_t)-2 || consumed == (size_t)-1){
+      // printable ASCII occupies a column per byte, and space is the only
+      // wordbreaker among it, so such runs can be consumed wholesale
+      if(*text != ' '){
+        size_t run = utf8_ascii_run(text);
+        if(run){
+          const char* space = memchr(text, ' ', run);
+          if(space){
+            run = space - text;
+          }
+          if(run > (size_t)(dimx - x)){
+            run = dimx - x;
+          }
+          if(run){
+            x += run;
+            text += run;
+            continue;
+          }
+        }
+      }
+      uint32_t w;
+      int consumed = utf8_decode(text, &w);
+      if(consumed < 0){
         logerror(n->nc, "Invalid UTF-8 after %zu bytes\n", text - beginning);
         if(bytes){
           *bytes = text - beginning;
@@ -1719,7 +2476,7 @@ int ncplane_puttext(ncplane* n, int y, ncalign_e align, const char* text, size_t
           breakercol = x;
         }
       }
-      width = wcwidth(w);
+      width = ucs_width(w);
 //fprintf(stderr, "have char %lc (%d) (%zu)\n", w, width, text - linestart);
       if(width < 0){
         width = 0;
@@ -1980,6 +2737,7 @@ int ncplane_box(ncplane* n, const cell* ul, const cell* ur,
 static void
 move_bound_planes(ncplane* n, int dy, int dx){
   while(n){
+    ncplane_dirty_geometry(n);
     n->absy += dy;
     n->absx += dx;
     move_bound_planes(n->blist, dy, dx);
@@ -1988,6 +2746,9 @@ move_bound_planes(ncplane* n, int dy, int dx){
 }
 
 int ncplane_move_yx(ncplane* n, int y, int x){
+  if(ncplane_traced(n)){
+    trace_move(n, y, x);
+  }
   if(n == n->nc->stdplane){
     return -1;
   }
@@ -1999,6 +2760,7 @@ int ncplane_move_yx(ncplane* n, int y, int x){
     dy = (n->nc->stdplane->absy + y) - n->absy;
     dx = (n->nc->stdplane->absx + x) - n->absx;
   }
+  ncplane_dirty_geometry(n);
   n->absx += dx;
   n->absy += dy;
   move_bound_planes(n->blist, dy, dx);
@@ -2023,24 +2785,33 @@ void ncplane_yx(const ncplane* n, int* y, int* x){
 }
 
 void ncplane_erase(ncplane* n){
-  // we must preserve the background, but a pure cell_duplicate() would be
-  // wiped out by the egcpool_dump(). do a duplication (to get the attrword
-  // and channels), and then reload.
-  char* egc = cell_strdup(n, &n->basecell);
-  memset(n->fb, 0, sizeof(*n->fb) * n->lenx * n->leny);
-  egcpool_dump(&n->pool);
-  egcpool_init(&n->pool);
-  // we need to zero out the EGC before handing this off to cell_load, but
-  // we don't want to lose the channels/attributes, so explicit gcluster load.
-  n->basecell.gcluster = 0;
-  cell_load(n, &n->basecell, egc);
-  free(egc);
+  if(ncplane_traced(n)){
+    trace_erase(n);
+  }
+  ncplane_dirty(n);
+  if(n->fb){
+    memset(n->fb, 0, sizeof(*n->fb) * n->lenx * n->leny);
+  }else{ // a sparse plane gives up all its tiles
+    for(int t = 0 ; t < ncplane_tilecount(n) ; ++t){
+      if(n->tiles[t]){
+        const size_t bytes = sizeof(cell) * ncplane_tile_rows(n, t) * n->lenx;
+        n->nc->stats.fbbytes -= bytes;
+        n->fbbytes -= bytes;
+        free(n->tiles[t]);
+        n->tiles[t] = NULL;
+      }
+    }
+  }
+  // only the base cell's EGC survives. should we fail to compact, the old
+  // pool remains valid, if bloated.
+  ncplane_compact(n);
   n->y = n->x = 0;
 }
 
 void notcurses_cursor_enable(notcurses* nc){
   if(nc->ttyfd >= 0){
     if(nc->tcache.cnorm){
+      notcurses_render_wait(nc);
       tty_emit("cnorm", nc->tcache.cnorm, nc->ttyfd);
     }
   }
@@ -2049,6 +2820,7 @@ void notcurses_cursor_enable(notcurses* nc){
 void notcurses_cursor_disable(notcurses* nc){
   if(nc->ttyfd >= 0){
     if(nc->tcache.civis){
+      notcurses_render_wait(nc);
       tty_emit("civis", nc->tcache.civis, nc->ttyfd);
     }
   }
@@ -2179,6 +2951,9 @@ const notcurses* ncplane_notcurses_const(const ncplane* n){
 }
 
 ncplane* ncplane_reparent(ncplane* n, ncplane* newparent){
+  if(ncplane_traced(n)){
+    trace_reparent(n, newparent);
+  }
   if(n == n->nc->stdplane){
     return NULL; // can't reparent standard plane
   }
@@ -2205,6 +2980,9 @@ ncplane* ncplane_reparent(ncplane* n, ncplane* newparent){
 }
 
 bool ncplane_set_scrolling(ncplane* n, bool scrollp){
+  if(ncplane_traced(n)){
+    trace_scrolling(n, scrollp);
+  }
   bool old = n->scrolling;
   n->scrolling = scrollp;
   return old;
@@ -2275,6 +3053,9 @@ int notcurses_lex_margins(const char* op, notcurses_options* opts){
 }
 
 int notcurses_inputready_fd(notcurses* n){
+  if(n->ttyinfp == NULL){
+    return -1;
+  }
   return fileno(n->ttyinfp);
 }
 
@@ -2447,25 +3228,7 @@ void nclog(const char* fmt, ...){
 }
 
 int ncplane_putstr_yx(struct ncplane* n, int y, int x, const char* gclusters){
-  int ret = 0;
-  // FIXME speed up this blissfully naive solution
-  while(*gclusters){
-    int wcs;
-    int cols = ncplane_putegc_yx(n, y, x, gclusters, &wcs);
-    if(cols < 0){
-      return -ret;
-    }
-    if(wcs == 0){
-      break;
-    }
-    // after the first iteration, just let the cursor code control where we
-    // print, so that scrolling is taken into account
-    y = -1;
-    x = -1;
-    gclusters += wcs;
-    ret += wcs;
-  }
-  return ret;
+  return ncplane_putnstr_yx(n, y, x, SIZE_MAX, gclusters);
 }
 
 int ncplane_putstr_stainable(struct ncplane* n, const char* gclusters){
@@ -2493,18 +3256,86 @@ int ncplane_putnstr_aligned(struct ncplane* n, int y, ncalign_e align, size_t s,
   return ret;
 }
 
+// the number of bytes at the start of 's' which are EGCs of printable ASCII.
+// this is the printable run, less its last character should a non-ASCII code
+// point (which might combine with it) follow.
+static inline size_t
+ascii_egc_run(const char* s){
+  size_t run = utf8_ascii_run(s);
+  if(run && (unsigned char)s[run] >= 0x80){
+    --run;
+  }
+  return run;
+}
+
+// write up to 'len' bytes of printable ASCII from 's' directly into the
+// framebuffer, stopping at the end of the cursor's row. the result is that of
+// as many ncplane_putegc_yx() calls, including obliteration of any wide glyphs
+// partially overwritten, but the cursor is checked and moved only once, and
+// no EGCs need be measured or loaded. returns the number of bytes written.
+static int
+putascii_yx(ncplane* n, int y, int x, const char* s, size_t len){
+  if(x == -1 && y == -1 && n->x >= n->lenx){
+    if(!n->scrolling){
+      logerror(n->nc, "No room to output [%.*s]\n", (int)len, s);
+      return -1;
+    }
+    scroll_down(n);
+  }
+  if(ncplane_cursor_move_yx(n, y, x)){
+    return -1;
+  }
+  int count = n->lenx - n->x;
+  if((size_t)count > len){
+    count = len;
+  }
+  cell* row = ncplane_row_writable(n, n->y);
+  if(row == NULL){
+    return -1;
+  }
+  ncplane_dirty_rows(n, n->y, 1);
+  const uint64_t channels = n->channels & ~CELL_WIDEASIAN_MASK;
+  for(int i = 0 ; i < count ; ++i){
+    cell* targ = &row[n->x];
+    if(n->x > 0 && cell_double_wide_p(targ)){ // replaced cell is half of a wide char
+      if(targ->gcluster == 0){ // we're the right half
+        cell_obliterate(n, &row[n->x - 1]);
+      }else{
+        cell_obliterate(n, &row[n->x + 1]);
+      }
+    }
+    cell_release(n, targ);
+    targ->gcluster = (unsigned char)s[i];
+    targ->attrword = n->attrword;
+    targ->channels = channels;
+    ++n->x;
+  }
+  return count;
+}
+
 int ncplane_putnstr_yx(struct ncplane* n, int y, int x, size_t s, const char* gclusters){
   int ret = 0;
 //fprintf(stderr, "PUT %zu at %d/%d [%.*s]\n", s, y, x, (int)s, gclusters);
-  // FIXME speed up this blissfully naive solution
   while((size_t)ret < s && *gclusters){
     int wcs;
-    int cols = ncplane_putegc_yx(n, y, x, gclusters, &wcs);
-    if(cols < 0){
-      return -ret;
-    }
-    if(wcs == 0){
-      break;
+    // runs of printable ASCII are written a row at a time. traced planes
+    // take the long way, so that each EGC is recorded.
+    size_t run = ncplane_traced(n) ? 0 : ascii_egc_run(gclusters);
+    if(run){
+      if(run > s - ret){
+        run = s - ret;
+      }
+      if((wcs = putascii_yx(n, y, x, gclusters, run)) < 0){
+        return -ret;
+      }
+    }else{
+      int cols = ncplane_putegc_yx(n, y, x, gclusters, &wcs);
+      if(cols < 0){
+        return -ret;
+      }
+      if(wcs == 0){
+        break;
+      }
     }
     // after the first iteration, just let the cursor code control where we
     // print, so that scrolling is taken into account
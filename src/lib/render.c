@@ -21,10 +21,14 @@ notcurses_resize(notcurses* n, int* restrict rows, int* restrict cols){
   int oldcols = n->stdplane->lenx;
   *rows = oldrows;
   *cols = oldcols;
-  if(update_term_dimensions(n->ttyfd, rows, cols)){
+  if(n->vscreen){
+    *rows = n->vscreen->dimy;
+    *cols = n->vscreen->dimx;
+  }else if(update_term_dimensions(n->ttyfd, rows, cols)){
     return -1;
   }
   n->truecols = *cols;
+  n->truerows = *rows;
   *rows -= n->margin_t + n->margin_b;
   if(*rows <= 0){
     *rows = 1;
@@ -42,10 +46,23 @@ notcurses_resize(notcurses* n, int* restrict rows, int* restrict cols){
       return -1;
     }
     n->lastframe = fb;
+    bool* dirtyrows = realloc(n->dirtyrows, sizeof(*dirtyrows) * n->lfdimy);
+    if(dirtyrows == NULL){
+      return -1;
+    }
+    n->dirtyrows = dirtyrows;
     // FIXME more memset()tery than we need, both wasting work and wrecking
     // damage detection for the upcoming render
     memset(n->lastframe, 0, size);
+    memset(n->dirtyrows, true, sizeof(*n->dirtyrows) * n->lfdimy);
     egcpool_dump(&n->pool);
+    if(n->rworkers){
+      renderworkers* rw = n->rworkers;
+      for(unsigned b = 0 ; b < rw->bands ; ++b){
+        egcpool_dump(&rw->pools[b]);
+      }
+      rw->bandrows = (n->lfdimy + rw->bands - 1) / rw->bands;
+    }
   }
   if(*rows == oldrows && *cols == oldcols){
     return 0; // no change
@@ -64,14 +81,13 @@ notcurses_resize(notcurses* n, int* restrict rows, int* restrict cols){
   return 0;
 }
 
-static int
-blocking_write(int fd, const char* buf, size_t buflen){
+int blocking_write(int fd, const char* buf, size_t buflen){
 //fprintf(stderr, "writing %zu to %d...\n", buflen, fd);
   size_t written = 0;
   while(written < buflen){
     ssize_t w = write(fd, buf + written, buflen - written);
     if(w < 0){
-      if(errno != EAGAIN && errno != EWOULDBLOCK){
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
         return -1;
       }
     }else{
@@ -176,23 +192,119 @@ cell_locked_p(const cell* p){
   return 0;
 }
 
-// Extracellular state for a cell during the render process. This array is
-// passed along to rasterization, which uses only the 'damaged' bools.
+// Extracellular blending state for a cell during the render process. The
+// plane supplying each cell's EGC and the damage map live in their own arrays
+// of the renderarena; only the damage map is passed along to rasterization.
 struct crender {
-  ncplane *p;
   unsigned fgblends;
   unsigned bgblends;
-  bool damaged;       // also used in rasterization
-  // if CELL_ALPHA_HIGHCONTRAST is in play, we apply the HSV flip once the
-  // background is locked in. set highcontrast to indicate this.
-  bool highcontrast;
   // we'll need recalculate the foreground relative to the solved background,
   // and then reapply any foreground shading from above the highcontrast
   // declaration. save the foreground state when we go highcontrast.
   unsigned hcfgblends; // number of foreground blends prior to HIGHCONTRAST
   uint32_t hcfg;       // foreground channel prior to HIGHCONTRAST
+  // if CELL_ALPHA_HIGHCONTRAST is in play, we apply the HSV flip once the
+  // background is locked in. set highcontrast to indicate this.
+  bool highcontrast;
 };
 
+// The damage map has a bit per cell, set if the cell differs from lastframe.
+// Each row starts on a fresh word, so that disjoint rows never share a word
+// (allowing bands to be painted concurrently), and so that a row can be
+// checked for damage a word at a time.
+static inline size_t
+damage_rowwords(int dimx){
+  return (dimx + 63) / 64;
+}
+
+static inline void
+damage_set(uint64_t* damage, int dimx, int y, int x){
+  damage[y * damage_rowwords(dimx) + x / 64] |= (1ull << (x % 64));
+}
+
+static inline bool
+damage_p(const uint64_t* damage, int dimx, int y, int x){
+  return damage[y * damage_rowwords(dimx) + x / 64] & (1ull << (x % 64));
+}
+
+// Find the first column of [x, dimx) whose bit in the row's damage words
+// 'rowdamage' is 'set', or dimx if there is none. Words with no bits of
+// interest (i.e. 64 cells at a time) are passed over with a single test.
+static inline int
+damage_next(const uint64_t* rowdamage, int x, int dimx, bool set){
+  while(x < dimx){
+    uint64_t w = rowdamage[x / 64];
+    if(!set){
+      w = ~w;
+    }
+    w &= ~0ull << (x % 64);
+    if(w){
+      x = (x / 64) * 64 + __builtin_ctzll(w);
+      return x < dimx ? x : dimx;
+    }
+    x = (x / 64 + 1) * 64;
+  }
+  return dimx;
+}
+
+// Ensure the render arena can solve a dimy x dimx area, growing it if
+// necessary. The arena never shrinks; its contents are not preserved.
+static int
+arena_reserve(notcurses* nc, int dimy, int dimx){
+  renderarena* ra = &nc->arena;
+  const size_t cells = (size_t)dimy * dimx;
+  const size_t words = dimy * damage_rowwords(dimx);
+  if(cells > ra->cells){
+    cell* fb = malloc(sizeof(*fb) * cells);
+    ncplane** planes = malloc(sizeof(*planes) * cells);
+    struct crender* rvec = malloc(sizeof(*rvec) * cells);
+    if(fb == NULL || planes == NULL || rvec == NULL){
+      free(fb);
+      free(planes);
+      free(rvec);
+      return -1;
+    }
+    free(ra->fb);
+    free(ra->planes);
+    free(ra->rvec);
+    ra->fb = fb;
+    ra->planes = planes;
+    ra->rvec = rvec;
+    ra->cells = cells;
+  }
+  if(words > ra->damagewords){
+    uint64_t* damage = malloc(sizeof(*damage) * words);
+    if(damage == NULL){
+      return -1;
+    }
+    free(ra->damage);
+    ra->damage = damage;
+    ra->damagewords = words;
+  }
+  if((size_t)dimy > ra->rows){
+    int* rowlocked = malloc(sizeof(*rowlocked) * dimy);
+    if(rowlocked == NULL){
+      return -1;
+    }
+    free(ra->rowlocked);
+    ra->rowlocked = rowlocked;
+    ra->rows = dimy;
+  }
+  nc->stats.arenabytes = ra->cells * (sizeof(*ra->fb) + sizeof(*ra->planes) + sizeof(*ra->rvec))
+                         + ra->damagewords * sizeof(*ra->damage)
+                         + ra->rows * sizeof(*ra->rowlocked);
+  return 0;
+}
+
+void render_arena_free(renderarena* ra){
+  free(ra->fb);
+  free(ra->planes);
+  free(ra->rvec);
+  free(ra->damage);
+  free(ra->rowlocked);
+  memset(ra, 0, sizeof(*ra));
+}
+
 // Emit fchannel with RGB changed to contrast effectively against bchannel.
 static uint32_t
 highcontrast(uint32_t bchannel){
@@ -251,13 +363,15 @@ lock_in_highcontrast(cell* targc, struct crender* crender){
 // ultimately 'lastframe' (we can't always write directly into 'lastframe',
 // because we need build state to solve certain cells, and need compare their
 // solved result to the last frame). Whenever a cell is locked in, it is
-// compared against the last frame. If it is different, the 'rvec' bitmap is
-// updated with a 1. 'pool' is typically nc->pool, but should be whatever's
-// backing fb.
+// compared against the last frame. If it is different, the arena's damage map
+// is updated with a 1. 'pool' is typically nc->pool, but should be whatever's
+// backing lastframe. Only destination rows [dstfirsty, dstleny) are painted.
+// Rows which higher planes have entirely locked in are skipped, and their
+// cells are added to 'culled'.
 static int
-paint(ncplane* p, cell* lastframe, struct crender* rvec,
-      cell* fb, egcpool* pool, int dstleny, int dstlenx,
-      int dstabsy, int dstabsx, int lfdimx){
+paint(ncplane* p, cell* lastframe, renderarena* ra, egcpool* pool,
+      int dstfirsty, int dstleny, int dstlenx,
+      int dstabsy, int dstabsx, int lfdimx, uint64_t* culled){
   int y, x, dimy, dimx, offy, offx;
   ncplane_dim_yx(p, &dimy, &dimx);
   offy = p->absy - dstabsy;
@@ -265,8 +379,8 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
 //fprintf(stderr, "PLANE %p %d %d %d %d %d %d\n", p, dimy, dimx, offy, offx, dstleny, dstlenx);
   // skip content above or to the left of the physical screen
   int starty, startx;
-  if(offy < 0){
-    starty = -offy;
+  if(offy < dstfirsty){
+    starty = dstfirsty - offy;
   }else{
     starty = 0;
   }
@@ -275,23 +389,36 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
   }else{
     startx = 0;
   }
+  // the number of our columns which land on the physical screen
+  int visx = (offx + dimx > dstlenx ? dstlenx - offx : dimx) - startx;
+  if(visx < 0){
+    visx = 0;
+  }
   for(y = starty ; y < dimy ; ++y){
     const int absy = y + offy;
     // once we've passed the physical screen's bottom, we're done
     if(absy >= dstleny){
       break;
     }
+    // is this row occluded entirely by opaque cells from above?
+    if(ra->rowlocked[absy] >= dstlenx){
+      *culled += visx;
+      continue;
+    }
+    // a sparse plane's missing rows read as blank, and thus as the base cell
+    const cell* prow = ncplane_row(p, y);
     for(x = startx ; x < dimx ; ++x){
       const int absx = x + offx;
       if(absx >= dstlenx){
         break;
       }
-      cell* targc = &fb[fbcellidx(absy, dstlenx, absx)];
+      const int idx = fbcellidx(absy, dstlenx, absx);
+      cell* targc = &ra->fb[idx];
       if(cell_locked_p(targc)){
         continue;
       }
-      struct crender* crender = &rvec[fbcellidx(absy, dstlenx, absx)];
-      const cell* vis = &p->fb[nfbcellidx(p, y, x)];
+      struct crender* crender = &ra->rvec[idx];
+      const cell* vis = &prow[x];
       // if we never loaded any content into the cell (or obliterated it by
       // writing in a zero), use the plane's base cell.
       if(vis->gcluster == 0 && !cell_wide_right_p(vis)){
@@ -302,7 +429,7 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
       // been set to transparent. if that foreground color is transparent, we
       // still use a character we find here, but its color will come entirely
       // from cells underneath us.
-      if(!crender->p){
+      if(!ra->planes[idx]){
         // if the following is true, we're a real glyph, and not the right-hand
         // side of a wide glyph (or the null codepoint).
         if( (targc->gcluster = vis->gcluster) ){ // index copy only
@@ -320,7 +447,7 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
               cell_set_wide(targc);
             }
           }
-          crender->p = p;
+          ra->planes[idx] = p;
           targc->attrword = vis->attrword;
         }else if(cell_wide_left_p(vis)){
           cell_set_wide(targc);
@@ -332,7 +459,7 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
       // If it's transparent, it has no effect. Otherwise, update the
       // background channel and balpha.
       // Evaluate the background first, in case we have HIGHCONTRAST fg text.
-      vis = &p->fb[nfbcellidx(p, y, x)];
+      vis = &prow[x];
       if(cell_bg_default_p(vis)){
         vis = &p->basecell;
       }
@@ -344,7 +471,7 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
         cell_blend_bchannel(targc, cell_bchannel(vis), &crender->bgblends);
       }
 
-      vis = &p->fb[nfbcellidx(p, y, x)];
+      vis = &prow[x];
       if(cell_fg_default_p(vis)){
         vis = &p->basecell;
       }
@@ -370,28 +497,32 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
       // have we locked this coordinate in as a result of this plane (cells
       // which were already locked in were skipped at the top of the loop)?
       if(cell_locked_p(targc)){
+        ++ra->rowlocked[absy];
         lock_in_highcontrast(targc, crender);
         cell* prevcell = &lastframe[fbcellidx(absy, lfdimx, absx)];
 /*if(cell_simple_p(targc)){
 fprintf(stderr, "WROTE %u [%c] to %d/%d (%d/%d)\n", targc->gcluster, targc->gcluster, y, x, absy, absx);
 }else{
-fprintf(stderr, "WROTE %u [%s] to %d/%d (%d/%d)\n", targc->gcluster, extended_gcluster(crender->p, targc), y, x, absy, absx);
+fprintf(stderr, "WROTE %u [%s] to %d/%d (%d/%d)\n", targc->gcluster, extended_gcluster(ra->planes[idx], targc), y, x, absy, absx);
 }*/
-        if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc)){
-          crender->damaged = true;
-          if(cell_wide_left_p(targc)){
-            ncplane* tmpp = crender->p;
-            ++crender;
-            crender->p = tmpp;
-            ++x;
-            ++prevcell;
-            ++targc;
-            targc->gcluster = 0;
-            targc->channels = targc[-1].channels;
-            targc->attrword = targc[-1].attrword;
-            if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc)){
-              crender->damaged = true;
-            }
+        if(cellcmp_and_dupfar(pool, prevcell, ra->planes[idx], targc)){
+          damage_set(ra->damage, dstlenx, absy, absx);
+        }
+        // the right half belongs to the wide glyph whether or not it changed;
+        // otherwise, a lower plane's glyph would show through it
+        if(cell_wide_left_p(targc)){
+          ra->planes[idx + 1] = ra->planes[idx];
+          ++x;
+          ++prevcell;
+          ++targc;
+          if(!cell_locked_p(targc)){
+            ++ra->rowlocked[absy];
+          }
+          targc->gcluster = 0;
+          targc->channels = targc[-1].channels;
+          targc->attrword = targc[-1].attrword;
+          if(cellcmp_and_dupfar(pool, prevcell, ra->planes[idx + 1], targc)){
+            damage_set(ra->damage, dstlenx, absy, absx + 1);
           }
         }
       }
@@ -415,18 +546,32 @@ init_fb(cell* fb, int dimy, int dimx){
   }
 }
 
+// prepare rows [firsty, lasty) of the arena for a dimx-wide paint
 static void
-postpaint(cell* fb, cell* lastframe, int dimy, int dimx,
-          struct crender* rvec, egcpool* pool){
-  for(int y = 0 ; y < dimy ; ++y){
+arena_clear_rows(renderarena* ra, int firsty, int lasty, int dimx){
+  const int idx = fbcellidx(firsty, dimx, 0);
+  const int cells = (lasty - firsty) * dimx;
+  init_fb(&ra->fb[idx], lasty - firsty, dimx);
+  memset(&ra->planes[idx], 0, sizeof(*ra->planes) * cells);
+  memset(&ra->rvec[idx], 0, sizeof(*ra->rvec) * cells);
+  memset(&ra->damage[firsty * damage_rowwords(dimx)], 0,
+         sizeof(*ra->damage) * (lasty - firsty) * damage_rowwords(dimx));
+  memset(&ra->rowlocked[firsty], 0, sizeof(*ra->rowlocked) * (lasty - firsty));
+}
+
+static void
+postpaint(renderarena* ra, cell* lastframe, int firsty, int dimy, int dimx,
+          egcpool* pool){
+  for(int y = firsty ; y < dimy ; ++y){
     for(int x = 0 ; x < dimx ; ++x){
-      cell* targc = &fb[fbcellidx(y, dimx, x)];
+      const int idx = fbcellidx(y, dimx, x);
+      cell* targc = &ra->fb[idx];
       if(!cell_locked_p(targc)){
-        struct crender* crender = &rvec[fbcellidx(y, dimx, x)];
+        struct crender* crender = &ra->rvec[idx];
         lock_in_highcontrast(targc, crender);
-        cell* prevcell = &lastframe[fbcellidx(y, dimx, x)];
-        if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc)){
-          crender->damaged = true;
+        cell* prevcell = &lastframe[idx];
+        if(cellcmp_and_dupfar(pool, prevcell, ra->planes[idx], targc)){
+          damage_set(ra->damage, dimx, y, x);
         }
       }
     }
@@ -442,74 +587,71 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst){
   }
   int dimy, dimx;
   ncplane_dim_yx(dst, &dimy, &dimx);
-  cell* tmpfb = malloc(sizeof(*tmpfb) * dimy * dimx);
+  if(arena_reserve(nc, dimy, dimx)){
+    return -1;
+  }
+  renderarena* ra = &nc->arena;
   cell* rendfb = malloc(sizeof(*rendfb) * dimy * dimx);
-  const size_t crenderlen = sizeof(struct crender) * dimy * dimx;
-  struct crender* rvec = malloc(crenderlen);
-  memset(rvec, 0, crenderlen);
-  init_fb(tmpfb, dimy, dimx);
+  if(rendfb == NULL){
+    return -1;
+  }
+  arena_clear_rows(ra, 0, dimy, dimx);
   init_fb(rendfb, dimy, dimx);
-  if(paint(src, rendfb, rvec, tmpfb, &dst->pool, dst->leny, dst->lenx,
-           dst->absy, dst->absx, dst->lenx)){
-    free(rvec);
+  uint64_t culled = 0; // merges don't contribute to render stats
+  if(paint(src, rendfb, ra, &dst->pool, 0, dst->leny, dst->lenx,
+           dst->absy, dst->absx, dst->lenx, &culled)){
     free(rendfb);
-    free(tmpfb);
     return -1;
   }
-  if(paint(dst, rendfb, rvec, tmpfb, &dst->pool, dst->leny, dst->lenx,
-           dst->absy, dst->absx, dst->lenx)){
-    free(rvec);
+  if(paint(dst, rendfb, ra, &dst->pool, 0, dst->leny, dst->lenx,
+           dst->absy, dst->absx, dst->lenx, &culled)){
+    free(rendfb);
+    return -1;
+  }
+  postpaint(ra, rendfb, 0, dimy, dimx, &dst->pool);
+  // a sparse destination takes the (dense) result, and is then tiled anew
+  const bool sparse = ncplane_sparse_p(dst);
+  if(sparse && ncplane_set_sparse(dst, false)){
     free(rendfb);
-    free(tmpfb);
     return -1;
   }
-  postpaint(tmpfb, rendfb, dimy, dimx, rvec, &dst->pool);
   free(dst->fb);
   dst->fb = rendfb;
-  free(tmpfb);
-  free(rvec);
-  return 0;
-}
-
-static inline int
-ncfputs(const char* ext, FILE* out){
-  int r;
-#ifdef __USE_GNU
-  r = fputs_unlocked(ext, out);
-#else
-  r = fputs(ext, out);
-#endif
-  return r;
-}
-
-static inline int
-ncfputc(char c, FILE* out){
-#ifdef __USE_GNU
-  return fputc_unlocked(c, out);
-#else
-  return fputc(c, out);
-#endif
+  dst->logrow = 0; // rendfb's rows are in logical order
+  int ret = 0;
+  if(sparse){
+    ret = ncplane_set_sparse(dst, true);
+  }
+  if(ncplane_traced(dst)){
+    trace_cells(dst, 0, 0, -1, -1);
+  }
+  return ret;
 }
 
-// write the cell's UTF-8 extended grapheme cluster to the provided FILE*.
+// write the cell's UTF-8 extended grapheme cluster to the provided fbuf.
 static int
-term_putc(FILE* out, const egcpool* e, const cell* c){
+term_putc(fbuf* out, const egcpool* e, const cell* c){
   if(cell_simple_p(c)){
-    if(c->gcluster == 0 || iscntrl(c->gcluster)){
+    if(!cell_ascii_p(c)){
+      char egc[CELL_INLINE_BYTES + 1];
+      if(fbuf_putn(out, egc, cell_simple_egc(c, egc))){
+        return -1;
+      }
+    }else if(c->gcluster == 0 || iscntrl(c->gcluster)){
 // fprintf(stderr, "[ ]\n");
-      if(ncfputc(' ', out) == EOF){
+      if(fbuf_putc(out, ' ')){
         return -1;
       }
     }else{
 //fprintf(stderr, "[%c]\n", c->gcluster);
-      if(ncfputc(c->gcluster, out) == EOF){
+      if(fbuf_putc(out, c->gcluster)){
         return -1;
       }
     }
   }else{
     const char* ext = egcpool_extended_gcluster(e, c);
 // fprintf(stderr, "[%s]\n", ext);
-    if(ncfputs(ext, out) == EOF){
+    if(fbuf_puts(out, ext)){
       return -1;
     }
   }
@@ -519,7 +661,7 @@ term_putc(FILE* out, const egcpool* e, const cell* c){
 // check the current and target style bitmasks against the specified 'stylebit'.
 // if they are different, and we have the necessary capability, write the
 // applicable terminfo entry to 'out'. returns -1 only on a true error.
-int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
+int term_setstyle(fbuf* out, unsigned cur, unsigned targ, unsigned stylebit,
                   const char* ton, const char* toff){
   int ret = 0;
   unsigned curon = cur & stylebit;
@@ -527,11 +669,11 @@ int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
   if(curon != targon){
     if(targon){
       if(ton){
-        ret = term_emit("ton", ton, out, false);
+        ret = fbuf_emit(out, ton);
       }
     }else{
       if(toff){ // how did this happen? we can turn it on, but not off?
-        ret = term_emit("toff", toff, out, false);
+        ret = fbuf_emit(out, toff);
       }
     }
   }
@@ -543,7 +685,7 @@ int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
 
 // write any escape sequences necessary to set the desired style
 static inline int
-term_setstyles(FILE* out, uint32_t* curattr, const cell* c, bool* normalized,
+term_setstyles(fbuf* out, uint32_t* curattr, const cell* c, bool* normalized,
                const char* sgr0, const char* sgr, const char* italics,
                const char* italoff){
   *normalized = false;
@@ -558,18 +700,17 @@ term_setstyles(FILE* out, uint32_t* curattr, const cell* c, bool* normalized,
     *normalized = true; // FIXME this is pretty conservative
     // if everything's 0, emit the shorter sgr0
     if(sgr0 && ((cellattr & NCSTYLE_MASK) == 0)){
-      if(term_emit("sgr0", sgr0, out, false) < 0){
+      if(fbuf_emit(out, sgr0) < 0){
         ret = -1;
       }
-    }else if(term_emit("sgr", tiparm(sgr, cellattr & NCSTYLE_STANDOUT,
-                                     cellattr & NCSTYLE_UNDERLINE,
-                                     cellattr & NCSTYLE_REVERSE,
-                                     cellattr & NCSTYLE_BLINK,
-                                     cellattr & NCSTYLE_DIM,
-                                     cellattr & NCSTYLE_BOLD,
-                                     cellattr & NCSTYLE_INVIS,
-                                     cellattr & NCSTYLE_PROTECT, 0),
-                                     out, false) < 0){
+    }else if(fbuf_emit(out, tiparm(sgr, cellattr & NCSTYLE_STANDOUT,
+                                   cellattr & NCSTYLE_UNDERLINE,
+                                   cellattr & NCSTYLE_REVERSE,
+                                   cellattr & NCSTYLE_BLINK,
+                                   cellattr & NCSTYLE_DIM,
+                                   cellattr & NCSTYLE_BOLD,
+                                   cellattr & NCSTYLE_INVIS,
+                                   cellattr & NCSTYLE_PROTECT, 0)) < 0){
       ret = -1;
     }
   }
@@ -599,15 +740,15 @@ static const char* NUMBERS[] = {
 "241", "242", "243", "244", "245", "246", "247", "248", "249", "250", "251", "252", "253", "254", "255", };
 
 static inline int
-term_esc_rgb(FILE* out, bool foreground, unsigned r, unsigned g, unsigned b){
+term_esc_rgb(fbuf* out, bool foreground, unsigned r, unsigned g, unsigned b){
   // The correct way to do this is using tiparm+tputs, but doing so (at least
   // as of terminfo 6.1.20191019) both emits ~3% more bytes for a run of 'rgb'
   // and gives rise to some corrupted cells (possibly due to special handling of
   // values < 256; I'm not at this time sure). So we just cons up our own.
   /*if(esc == 4){
-    return term_emit("setab", tiparm(nc->setab, (int)((r << 16u) | (g << 8u) | b)), out, false);
+    return fbuf_emit(out, tiparm(nc->setab, (int)((r << 16u) | (g << 8u) | b)));
   }else if(esc == 3){
-    return term_emit("setaf", tiparm(nc->setaf, (int)((r << 16u) | (g << 8u) | b)), out, false);
+    return fbuf_emit(out, tiparm(nc->setaf, (int)((r << 16u) | (g << 8u) | b)));
   }else{
     return -1;
   }*/
@@ -643,69 +784,67 @@ term_esc_rgb(FILE* out, bool foreground, unsigned r, unsigned g, unsigned b){
     ++s;
   }
   rgbbuf[offset++] = 'm';
-  rgbbuf[offset] = '\0';
-  if(ncfputs(rgbbuf, out) == EOF){
-    return -1;
-  }
-  return 0;
+  return fbuf_putn(out, rgbbuf, offset);
 }
 
 static inline int
-term_bg_rgb8(bool RGBflag, const char* setab, int colors, FILE* out,
-             unsigned r, unsigned g, unsigned b){
+term_bg_rgb8(const tinfo* ti, fbuf* out, unsigned r, unsigned g, unsigned b){
   // We typically want to use tputs() and tiperm() to acquire and write the
   // escapes, as these take into account terminal-specific delays, padding,
   // etc. For the case of DirectColor, there is no suitable terminfo entry, but
   // we're also in that case working with hopefully more robust terminals.
   // If it doesn't work, eh, it doesn't work. Fuck the world; save yourself.
-  if(RGBflag){
+  if(ti->RGBflag){
     return term_esc_rgb(out, false, r, g, b);
   }else{
-    if(setab == NULL){
+    if(ti->setab == NULL){
       return 0;
     }
     // For 256-color indexed mode, start constructing a palette based off
     // the inputs *if we can change the palette*. If more than 256 are used on
     // a single screen, start... combining close ones? For 8-color mode, simple
     // interpolation. I have no idea what to do for 88 colors. FIXME
-    if(colors >= 256){
-      return term_emit("setab", tiparm(setab, rgb_quantize_256(r, g, b)), out, false);
-    }else if(colors >= 8){
-      return term_emit("setab", tiparm(setab, rgb_quantize_8(r, g, b)), out, false);
+    if(ti->colors >= 256){
+      return term_emit_param(out, ti->setab, &ti->setabt, &ti->setabs,
+                             rgb_quantize_256(r, g, b));
+    }else if(ti->colors >= 8){
+      return term_emit_param(out, ti->setab, &ti->setabt, &ti->setabs,
+                             rgb_quantize_8(r, g, b));
     }
   }
   return 0;
 }
 
 static inline int
-term_fg_rgb8(bool RGBflag, const char* setaf, int colors, FILE* out,
-             unsigned r, unsigned g, unsigned b){
+term_fg_rgb8(const tinfo* ti, fbuf* out, unsigned r, unsigned g, unsigned b){
   // We typically want to use tputs() and tiperm() to acquire and write the
   // escapes, as these take into account terminal-specific delays, padding,
   // etc. For the case of DirectColor, there is no suitable terminfo entry, but
   // we're also in that case working with hopefully more robust terminals.
   // If it doesn't work, eh, it doesn't work. Fuck the world; save yourself.
-  if(RGBflag){
+  if(ti->RGBflag){
     return term_esc_rgb(out, true, r, g, b);
   }else{
-    if(setaf == NULL){
+    if(ti->setaf == NULL){
       return 0;
     }
     // For 256-color indexed mode, start constructing a palette based off
     // the inputs *if we can change the palette*. If more than 256 are used on
     // a single screen, start... combining close ones? For 8-color mode, simple
     // interpolation. I have no idea what to do for 88 colors. FIXME
-    if(colors >= 256){
-      return term_emit("setaf", tiparm(setaf, rgb_quantize_256(r, g, b)), out, false);
-    }else if(colors >= 8){
-      return term_emit("setaf", tiparm(setaf, rgb_quantize_8(r, g, b)), out, false);
+    if(ti->colors >= 256){
+      return term_emit_param(out, ti->setaf, &ti->setaft, &ti->setafs,
+                             rgb_quantize_256(r, g, b));
+    }else if(ti->colors >= 8){
+      return term_emit_param(out, ti->setaf, &ti->setaft, &ti->setafs,
+                             rgb_quantize_8(r, g, b));
     }
   }
   return 0;
 }
 
 static inline int
-update_palette(notcurses* nc, FILE* out){
+update_palette(notcurses* nc, fbuf* out){
   if(nc->tcache.CCCflag){
     for(size_t damageidx = 0 ; damageidx < sizeof(nc->palette.chans) / sizeof(*nc->palette.chans) ; ++damageidx){
       unsigned r, g, b;
@@ -716,7 +855,14 @@ update_palette(notcurses* nc, FILE* out){
         r = r * 1000 / 255;
         g = g * 1000 / 255;
         b = b * 1000 / 255;
-        term_emit("initc", tiparm(nc->tcache.initc, damageidx, r, g, b), out, false);
+        const size_t used = out->used;
+        if(nc->tcache.initct.valid){
+          const int p[4] = { (int)damageidx, (int)r, (int)g, (int)b };
+          estemplate_emit(out, &nc->tcache.initct, p);
+        }else{
+          fbuf_emit(out, tiparm(nc->tcache.initc, damageidx, r, g, b));
+        }
+        nc->stats.palprog_bytes += out->used - used;
         nc->palette_damage[damageidx] = false;
       }
     }
@@ -724,35 +870,332 @@ update_palette(notcurses* nc, FILE* out){
   return 0;
 }
 
-// sync the cursor to the specified location with as little overhead as
-// possible (with nothing, if already at the right location).
-// FIXME fall back to synthesized moves in the absence of capabilities (i.e.
-// textronix lacks cup; fake it with horiz+vert moves)
+void paramcache_init(paramcache* pc, const tinfo* ti){
+  memset(pc, 0, sizeof(*pc));
+  pc->cuf.cap = ti->cuf;
+  pc->cub.cap = ti->cub;
+  pc->cuu.cap = ti->cuu;
+  pc->cud.cap = ti->cud;
+  pc->hpa.cap = ti->hpa;
+  pc->vpa.cap = ti->vpa;
+  pc->ech.cap = ti->ech;
+  pc->rep.cap = ti->rep;
+  pc->rep.repeat = true;
+  pc->cuf.tmpl = ti->cuft.valid ? &ti->cuft : NULL;
+  pc->cub.tmpl = ti->cubt.valid ? &ti->cubt : NULL;
+  pc->cuu.tmpl = ti->cuut.valid ? &ti->cuut : NULL;
+  pc->cud.tmpl = ti->cudt.valid ? &ti->cudt : NULL;
+  pc->hpa.tmpl = ti->hpat.valid ? &ti->hpat : NULL;
+  pc->vpa.tmpl = ti->vpat.valid ? &ti->vpat : NULL;
+  pc->ech.tmpl = ti->echt.valid ? &ti->echt : NULL;
+  pc->rep.tmpl = ti->rept.valid ? &ti->rept : NULL;
+}
+
+void paramcache_free(paramcache* pc){
+  free(pc->cuf.entries);
+  free(pc->cub.entries);
+  free(pc->cuu.entries);
+  free(pc->cud.entries);
+  free(pc->hpa.entries);
+  free(pc->vpa.entries);
+  free(pc->ech.entries);
+  free(pc->rep.entries);
+  memset(pc, 0, sizeof(*pc));
+}
+
+// Look up (expanding and caching, if necessary) the escape for parameter 'n'.
+// Returns NULL if the capability is unavailable. Expansions too long to cache
+// are returned from the escache's scratch space (or tiparm()'s static buffer),
+// and are only valid until the next expansion.
+static const char*
+escache_get(escache* ec, int n, int* len){
+  if(ec == NULL || ec->cap == NULL || n < 0){
+    return NULL;
+  }
+  if(n >= ec->count){
+    int count = ec->count ? ec->count : 128;
+    while(count <= n){
+      count *= 2;
+    }
+    esentry* tmp = realloc(ec->entries, sizeof(*tmp) * count);
+    if(tmp == NULL){
+      return NULL;
+    }
+    memset(tmp + ec->count, 0, sizeof(*tmp) * (count - ec->count));
+    ec->entries = tmp;
+    ec->count = count;
+  }
+  esentry* e = &ec->entries[n];
+  if(e->len == 0 || e->len == UCHAR_MAX){
+    // rep is expanded as the repetition of a space, which is then stripped
+    const char* seq;
+    if(ec->tmpl){
+      const int p[2] = { ec->repeat ? ' ' : n, n + 1 };
+      ec->scratch[estemplate_expand(ec->tmpl, ec->scratch, p)] = '\0';
+      seq = ec->scratch;
+    }else if(ec->repeat){
+      seq = tiparm(ec->cap, ' ', n + 1);
+    }else{
+      seq = tiparm(ec->cap, n);
+    }
+    if(seq == NULL){
+      return NULL;
+    }
+    if(ec->repeat){
+      // if rep doesn't lead with its character, we can't separate the two
+      if(*seq != ' '){
+        ec->cap = NULL;
+        return NULL;
+      }
+      ++seq;
+    }
+    size_t slen = strlen(seq);
+    if(slen > sizeof(e->seq) || slen == 0){
+      e->len = UCHAR_MAX;
+      *len = slen;
+      return seq;
+    }
+    memcpy(e->seq, seq, slen);
+    e->len = slen;
+  }
+  *len = e->len;
+  return e->seq;
+}
+
+// cost in bytes of the escape for parameter 'n', or INT_MAX if unavailable
 static inline int
-stage_cursor(notcurses* nc, FILE* out, int y, int x){
-  int ret = 0;
-  if(nc->rstate.y == y){ // only need move x
-    const int xdiff = x - nc->rstate.x;
-    if(xdiff > 0){
-      if(nc->tcache.cuf && nc->tcache.cuf1){
-        if(xdiff == 1){
-          ret = term_emit("cuf1", tiparm(nc->tcache.cuf1), out, false);
-        }else{
-          ret = term_emit("cuf", tiparm(nc->tcache.cuf, xdiff), out, false);
+escache_cost(escache* ec, int n){
+  int len;
+  if(escache_get(ec, n, &len) == NULL){
+    return INT_MAX;
+  }
+  return len;
+}
+
+static inline int
+escache_emit(fbuf* out, escache* ec, int n){
+  int len;
+  const char* seq = escache_get(ec, n, &len);
+  if(seq == NULL){
+    return -1;
+  }
+  return fbuf_putn(out, seq, len);
+}
+
+// A relative or absolute motion along one axis: repeat the one-cell escape
+// 'count' times, or use the parameterized escape with argument 'param', or
+// nothing at all (for no motion).
+typedef struct axismove {
+  int cost;           // bytes, INT_MAX if impossible
+  const char* single; // one-cell escape, repeated 'count' times
+  int count;
+  escache* ec;        // parameterized escape, used with 'param'
+  int param;
+} axismove;
+
+static inline int
+axismove_emit(fbuf* out, const axismove* m){
+  if(m->ec){
+    return escache_emit(out, m->ec, m->param);
+  }
+  for(int i = 0 ; i < m->count ; ++i){
+    if(fbuf_emit(out, m->single)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// relative motion of 'n' (> 0) cells using either the one-cell escape
+// 'single' repeated, or the parameterized 'ec', whichever is shorter.
+static void
+plan_relative(axismove* m, const char* single, escache* ec, int n){
+  m->cost = INT_MAX;
+  m->ec = NULL;
+  m->single = NULL;
+  m->count = 0;
+  int pcost = escache_cost(ec, n);
+  if(single){
+    size_t slen = strlen(single);
+    if(slen && (size_t)n * slen < (size_t)pcost){
+      m->cost = n * slen;
+      m->single = single;
+      m->count = n;
+      return;
+    }
+  }
+  if(pcost < INT_MAX){
+    m->cost = pcost;
+    m->ec = ec;
+    m->param = n;
+  }
+}
+
+// the cheapest motion along one axis from 'from' to 'to' using relative
+// escapes (in the 'fwd' or 'back' direction), or the absolute 'abs'.
+static void
+plan_axis(axismove* m, int from, int to, const char* fwd1, escache* fwd,
+          const char* back1, escache* back, escache* abs){
+  if(from == to){
+    m->cost = 0;
+    m->ec = NULL;
+    m->single = NULL;
+    m->count = 0;
+    return;
+  }
+  if(to > from){
+    plan_relative(m, fwd1, fwd, to - from);
+  }else{
+    plan_relative(m, back1, back, from - to);
+  }
+  int acost = escache_cost(abs, to);
+  if(acost < m->cost){
+    m->cost = acost;
+    m->ec = abs;
+    m->param = to;
+    m->single = NULL;
+    m->count = 0;
+  }
+}
+
+static int
+rasterize_cell(notcurses* nc, fbuf* out, const egcpool* pool, const cell* srccell);
+
+// Try to move the cursor forward along the current row by rewriting the
+// glyphs it would pass over, as they already stand in lastframe (and thus on
+// the screen). This only pays off for short gaps, but those are common when
+// updating a row sparsely. Fails (with nothing emitted, and no state changed)
+// unless it takes fewer than 'budget' bytes.
+static bool
+rewrite_gap(notcurses* nc, fbuf* out, int y, int x, int budget){
+  const int innery = y - nc->stdplane->absy;
+  const int fromx = nc->rstate.x - nc->stdplane->absx;
+  const int tox = x - nc->stdplane->absx;
+  if(innery < 0 || innery >= nc->lfdimy || fromx < 0 || tox > nc->lfdimx){
+    return false;
+  }
+  const size_t used = out->used;
+  renderstate rstate = nc->rstate;
+  ncstats stats = nc->stats;
+  const cell* rowcells = &nc->lastframe[innery * nc->lfdimx];
+  const egcpool* pool = lastframe_pool(nc, innery);
+  int innerx = fromx;
+  while(innerx < tox && out->used - used < (size_t)budget){
+    const cell* c = &rowcells[innerx];
+    if(rasterize_cell(nc, out, pool, c)){
+      break;
+    }
+    innerx += cell_wide_left_p(c) ? 2 : 1;
+  }
+  if(innerx != tox || out->used - used >= (size_t)budget){
+    out->used = used;
+    rstate.f = nc->rstate.f;
+    nc->rstate = rstate;
+    nc->stats = stats;
+    return false;
+  }
+  // these glyphs were written only to move the cursor, and stage_cursor()
+  // counts them as motion; undo rasterize_cell()'s accounting of them.
+  nc->stats.style_bytes = stats.style_bytes;
+  nc->stats.rgb_bytes = stats.rgb_bytes;
+  nc->stats.palette_bytes = stats.palette_bytes;
+  nc->stats.default_bytes = stats.default_bytes;
+  nc->stats.glyph_bytes = stats.glyph_bytes;
+  return true;
+}
+
+// Sync the cursor to the specified location, using the fewest bytes we can
+// (none, if it's already there). We consider cup; vertical motion (cuu, cud,
+// or vpa) combined with horizontal motion (cub, cuf, their one-cell forms,
+// hpa, or a carriage return plus forward motion); and rewriting the glyphs
+// between the cursor and its destination. The parameterized escapes are
+// expanded once, and cached thereafter. Relative motion requires knowing where
+// the cursor is, and that it's not awaiting an automatic margin wrap.
+static int
+cursor_motion(notcurses* nc, fbuf* out, int y, int x){
+  const int cy = nc->rstate.y;
+  const int cx = nc->rstate.x;
+  if(cy == y && cx == x){
+    return 0; // no move needed
+  }
+  paramcache* pc = &nc->pcache;
+  int best = INT_MAX;
+  axismove vert, horiz;
+  bool usecr = false;
+  if(cy >= 0 && cx >= 0 && cx < nc->truecols){
+    plan_axis(&vert, cy, y, NULL, &pc->cud, NULL, &pc->cuu, &pc->vpa);
+    plan_axis(&horiz, cx, x, nc->tcache.cuf1, &pc->cuf,
+              nc->tcache.cub1, &pc->cub, &pc->hpa);
+    if(x < cx && nc->tcache.cr){
+      axismove fromcr;
+      plan_axis(&fromcr, 0, x, nc->tcache.cuf1, &pc->cuf, NULL, NULL, &pc->hpa);
+      if(fromcr.cost < INT_MAX){
+        int crcost = strlen(nc->tcache.cr) + fromcr.cost;
+        if(crcost < horiz.cost){
+          horiz = fromcr;
+          horiz.cost = crcost;
+          usecr = true;
+        }
+      }
+    }
+    if(vert.cost < INT_MAX && horiz.cost < INT_MAX){
+      best = vert.cost + horiz.cost;
+    }
+    // every rewritten glyph costs at least a byte, so only short gaps qualify
+    if(cy == y && x > cx && x - cx < best){
+      if(rewrite_gap(nc, out, y, x, best)){
+        return 0;
+      }
+    }
+  }
+  // the shortest cup is three bytes; don't bother with it if we can't win
+  if(best > 3){
+    char cupbuf[ESTEMPLATE_MAXLEN];
+    const char* cup;
+    size_t cuplen = 0;
+    if(y == 0 && x == 0 && nc->tcache.home){
+      cup = nc->tcache.home;
+    }else if(nc->tcache.cupt.valid){
+      const int p[2] = { y, x };
+      cuplen = estemplate_expand(&nc->tcache.cupt, cupbuf, p);
+      cup = cupbuf;
+    }else{
+      cup = tiparm(nc->tcache.cup, y, x);
+    }
+    if(cup){
+      if(cuplen == 0){
+        cuplen = strlen(cup);
+      }
+      if(cuplen < (size_t)best){
+        if(fbuf_putn(out, cup, cuplen)){
+          return -1;
         }
         nc->rstate.x = x;
-        return ret;
+        nc->rstate.y = y;
+        return 0;
       }
-    }else if(xdiff == 0){
-      return 0; // no move needed
     }
-    // cub1/cub tend to be destructive in my experiments :/
   }
-  ret = term_emit("cup", tiparm(nc->tcache.cup, y, x), out, false);
-  if(ret == 0){
-    nc->rstate.x = x;
-    nc->rstate.y = y;
+  if(best == INT_MAX){
+    return -1;
+  }
+  if(usecr && fbuf_emit(out, nc->tcache.cr)){
+    return -1;
   }
+  if(axismove_emit(out, &vert) || axismove_emit(out, &horiz)){
+    return -1;
+  }
+  nc->rstate.x = x;
+  nc->rstate.y = y;
+  return 0;
+}
+
+// cursor_motion(), with everything it writes counted as motion
+static int
+stage_cursor(notcurses* nc, fbuf* out, int y, int x){
+  const size_t used = out->used;
+  int ret = cursor_motion(nc, out, y, x);
+  nc->stats.motion_bytes += out->used - used;
   return ret;
 }
 
@@ -761,7 +1204,88 @@ stage_cursor(notcurses* nc, FILE* out, int y, int x){
 // FIXME do this at cell prep time and set a bit in the channels
 static inline bool
 cell_noforeground_p(const cell* c){
-  return cell_simple_p(c) && (c->gcluster == ' ' || !isprint(c->gcluster));
+  return cell_ascii_p(c) && (c->gcluster == ' ' || !isprint(c->gcluster));
+}
+
+// SGR parameters can be combined into a single escape, but not every terminal
+// accepts arbitrarily many of them (st, for instance, stops at 16).
+#define SGR_MAXPARAMS 16
+
+// Merge adjacent SGR escapes written to 'out' since 'mark', so that a cell's
+// style, foreground, and background changes cost one CSI rather than three:
+// "\e[1m\e[38;2;1;2;3m" becomes "\e[1;38;2;1;2;3m". Empty parameter lists
+// (i.e. sgr0's "\e[m") are written as an explicit 0 when merged. Anything
+// which isn't an SGR is left in place, and separates those around it. Merging
+// never lengthens the output (it usually saves two bytes per merge), so this
+// is done in place.
+static void
+sgr_coalesce(fbuf* out, size_t mark){
+  char* s = out->buf + mark;
+  const size_t len = out->used - mark;
+  size_t r = 0, w = 0;
+  bool open = false;  // have we an SGR lacking its terminating 'm'?
+  size_t pstart = 0;  // offset of the open SGR's parameters
+  int params = 0;     // parameters in the open SGR
+  while(r < len){
+    const size_t slen = sgr_len(s + r, len - r);
+    if(slen == 0){
+      if(open){
+        s[w++] = 'm';
+        open = false;
+      }
+      s[w++] = s[r++];
+      continue;
+    }
+    const char* p = s + r + 2;
+    const size_t plen = slen - 3;
+    int n = 1;
+    for(size_t i = 0 ; i < plen ; ++i){
+      n += p[i] == ';' || p[i] == ':';
+    }
+    if(open && params + n <= SGR_MAXPARAMS){
+      if(w == pstart){
+        s[w++] = '0';
+      }
+      s[w++] = ';';
+      if(plen == 0){
+        s[w++] = '0';
+      }else{
+        memmove(s + w, p, plen);
+        w += plen;
+      }
+      params += n;
+    }else{
+      if(open){
+        s[w++] = 'm';
+      }
+      memmove(s + w, s + r, slen - 1);
+      pstart = w + 2;
+      w += slen - 1;
+      open = true;
+      params = n;
+    }
+    r += slen;
+  }
+  if(open){
+    s[w++] = 'm';
+  }
+  out->used = mark + w;
+}
+
+// Charge whatever was written to 'out' since '*prev' to the byte count 'cat',
+// first merging it into the cell's SGRs (written since 'mark'), so that each
+// escape is charged only what it adds to the merged whole.
+static inline void
+account_escape(const notcurses* nc, fbuf* out, size_t mark, size_t* prev,
+               uint64_t* cat){
+  if(out->used == *prev){
+    return;
+  }
+  if(nc->tcache.sgrmerge && out->used - mark > 3){
+    sgr_coalesce(out, mark);
+  }
+  *cat += out->used - *prev;
+  *prev = out->used;
 }
 
 // Producing the frame requires three steps:
@@ -769,182 +1293,433 @@ cell_noforeground_p(const cell* c){
 //  * rasterize -- build up a UTF-8/ASCII stream of escapes and EGCs
 //  * refresh -- write the stream to the emulator
 
+// Emit a single cell, which the cursor must already be positioned atop, along
+// with whatever style and color changes it requires. The cursor is advanced
+// past it (by two columns for a wide glyph).
+static int
+rasterize_cell(notcurses* nc, fbuf* out, const egcpool* pool, const cell* srccell){
+  int ret = 0;
+  unsigned r, g, b, br, bg, bb, palfg, palbg;
+  const size_t mark = out->used;
+  size_t prev = mark;
+  // set the style. this can change the color back to the default; if it
+  // does, we need update our elision possibilities.
+  bool normalized;
+  ret |= term_setstyles(out, &nc->rstate.curattr, srccell, &normalized,
+                        nc->tcache.sgr0, nc->tcache.sgr,
+                        nc->tcache.italics, nc->tcache.italoff);
+  account_escape(nc, out, mark, &prev, &nc->stats.style_bytes);
+  if(normalized){
+    nc->rstate.defaultelidable = true;
+    nc->rstate.bgelidable = false;
+    nc->rstate.fgelidable = false;
+    nc->rstate.bgpalelidable = false;
+    nc->rstate.fgpalelidable = false;
+  }
+  // we allow these to be set distinctly, but terminfo only supports using
+  // them both via the 'op' capability. unless we want to generate the 'op'
+  // escapes ourselves, if either is set to default, we first send op, and
+  // then a turnon for whichever aren't default.
+
+  // if our cell has a default foreground *or* background, we can elide the
+  // default set iff one of:
+  //  * we are a partial glyph, and the previous was default on both, or
+  //  * we are a no-foreground glyph, and the previous was default background, or
+  //  * we are a no-background glyph, and the previous was default foreground
+  // without RGB, we quantize to the palette
+  uint64_t* rgbcat = nc->tcache.RGBflag ? &nc->stats.rgb_bytes : &nc->stats.palette_bytes;
+  bool noforeground = cell_noforeground_p(srccell);
+  bool nobackground = cell_nobackground_p(srccell);
+  if((!noforeground && cell_fg_default_p(srccell)) || (!nobackground && cell_bg_default_p(srccell))){
+    if(!nc->rstate.defaultelidable){
+      ++nc->stats.defaultemissions;
+      if(nc->tcache.op){
+        ret |= fbuf_emit(out, nc->tcache.op);
+        account_escape(nc, out, mark, &prev, &nc->stats.default_bytes);
+      }
+    }else{
+      ++nc->stats.defaultelisions;
+    }
+    // if either is not default, this will get turned off
+    nc->rstate.defaultelidable = true;
+    nc->rstate.fgelidable = false;
+    nc->rstate.bgelidable = false;
+    nc->rstate.fgpalelidable = false;
+    nc->rstate.bgpalelidable = false;
+  }
+  // if our cell has a non-default foreground, we can elide the non-default
+  // foreground set iff either:
+  //  * the previous was non-default, and matches what we have now, or
+  //  * we are a no-foreground glyph (iswspace() is true)
+  if(noforeground){
+    ++nc->stats.fgelisions;
+  }else if(cell_fg_palindex_p(srccell)){ // palette-indexed foreground
+    palfg = cell_fg_palindex(srccell);
+    // we overload lastr for the palette index; both are 8 bits
+    if(nc->rstate.fgpalelidable && nc->rstate.lastr == palfg){
+      ++nc->stats.fgelisions;
+    }else{
+      ret |= term_fg_palindex(nc, out, palfg);
+      account_escape(nc, out, mark, &prev, &nc->stats.palette_bytes);
+      ++nc->stats.fgemissions;
+      nc->rstate.fgpalelidable = true;
+    }
+    nc->rstate.lastr = palfg;
+    nc->rstate.defaultelidable = false;
+    nc->rstate.fgelidable = false;
+  }else if(!cell_fg_default_p(srccell)){ // rgb foreground
+    cell_fg_rgb(srccell, &r, &g, &b);
+    if(nc->rstate.fgelidable && nc->rstate.lastr == r && nc->rstate.lastg == g && nc->rstate.lastb == b){
+      ++nc->stats.fgelisions;
+    }else{
+      ret |= term_fg_rgb8(&nc->tcache, out, r, g, b);
+      account_escape(nc, out, mark, &prev, rgbcat);
+      ++nc->stats.fgemissions;
+      nc->rstate.fgelidable = true;
+    }
+    nc->rstate.lastr = r; nc->rstate.lastg = g; nc->rstate.lastb = b;
+    nc->rstate.defaultelidable = false;
+    nc->rstate.fgpalelidable = false;
+  }
+  if(nobackground){
+    ++nc->stats.bgelisions;
+  }else if(cell_bg_palindex_p(srccell)){ // palette-indexed background
+    palbg = cell_bg_palindex(srccell);
+    if(nc->rstate.bgpalelidable && nc->rstate.lastbr == palbg){
+      ++nc->stats.bgelisions;
+    }else{
+      ret |= term_bg_palindex(nc, out, palbg);
+      account_escape(nc, out, mark, &prev, &nc->stats.palette_bytes);
+      ++nc->stats.bgemissions;
+      nc->rstate.bgpalelidable = true;
+    }
+    nc->rstate.lastr = palbg;
+    nc->rstate.defaultelidable = false;
+    nc->rstate.bgelidable = false;
+  }else if(!cell_bg_default_p(srccell)){ // rgb background
+    cell_bg_rgb(srccell, &br, &bg, &bb);
+    if(nc->rstate.bgelidable && nc->rstate.lastbr == br && nc->rstate.lastbg == bg && nc->rstate.lastbb == bb){
+      ++nc->stats.bgelisions;
+    }else{
+      ret |= term_bg_rgb8(&nc->tcache, out, br, bg, bb);
+      account_escape(nc, out, mark, &prev, rgbcat);
+      ++nc->stats.bgemissions;
+      nc->rstate.bgelidable = true;
+    }
+    nc->rstate.lastbr = br; nc->rstate.lastbg = bg; nc->rstate.lastbb = bb;
+    nc->rstate.defaultelidable = false;
+    nc->rstate.bgpalelidable = false;
+  }
+/*if(cell_simple_p(srccell)){
+fprintf(stderr, "RAST %u [%c] to %d/%d\n", srccell->gcluster, srccell->gcluster, nc->rstate.y, nc->rstate.x);
+}else{
+fprintf(stderr, "RAST %u [%s] to %d/%d\n", srccell->gcluster, egcpool_extended_gcluster(pool, srccell), nc->rstate.y, nc->rstate.x);
+}*/
+  if(term_putc(out, pool, srccell)){
+    return -1;
+  }
+  nc->stats.glyph_bytes += out->used - prev;
+  nc->rstate.x += cell_wide_left_p(srccell) ? 2 : 1;
+  // if the terminal's own motion carried us down to the next line, we need
+  // update our concept of the cursor's true y
+  /*if(nc->rstate.x >= nc->truecols){
+    ++nc->rstate.y; // FIXME not if on last line, right?
+    nc->rstate.x = 0;
+  }*/
+  return ret < 0 ? -1 : 0;
+}
+
+// A wide glyph covers the column following it, and that column is never
+// emitted on its own, whatever lastframe holds there (it does not maintain the
+// right halves of wide glyphs). Is column 'x' of the row thus covered, given
+// that a glyph began at column 'anchor' (<= x)?
+static inline bool
+wide_covered_p(const cell* rowcells, int anchor, int x){
+  int a = x;
+  while(a > anchor && cell_wide_left_p(&rowcells[a - 1])){
+    --a;
+  }
+  return (x - a) % 2;
+}
+
+// Would this cell be emitted as a blank (a space, with no styling)?
+static inline bool
+cell_blank_p(const cell* c){
+  return cell_ascii_p(c) && (c->gcluster == 0 || c->gcluster == ' ' || iscntrl(c->gcluster))
+         && cell_styles(c) == 0;
+}
+
+// Is the EGC of this single-column cell a single code point, and thus
+// repeatable by rep? Writes its length in bytes to 'len'.
+static inline bool
+cell_repeatable_p(const egcpool* pool, const cell* c, int* len){
+  if(cell_ascii_p(c)){
+    *len = 1;
+    return true;
+  }
+  char simple[CELL_INLINE_BYTES + 1];
+  const char* egc = simple;
+  if(cell_simple_p(c)){
+    cell_simple_egc(c, simple);
+  }else{
+    egc = egcpool_extended_gcluster(pool, c);
+  }
+  // decode as UTF-8 regardless of locale; mbrtowc() would be limited to
+  // MB_CUR_MAX bytes, which is 1 in the C locale
+  uint32_t cp;
+  int r = utf8_decode(egc, &cp);
+  if(r <= 0 || egc[r]){ // only a single codepoint can be repeated
+    return false;
+  }
+  *len = r;
+  return true;
+}
+
+static inline bool
+cells_identical_p(const egcpool* pool, const cell* c1, const cell* c2){
+  if(c1->attrword != c2->attrword || c1->channels != c2->channels){
+    return false;
+  }
+  if(cell_simple_p(c1) || cell_simple_p(c2)){
+    return c1->gcluster == c2->gcluster;
+  }
+  return !strcmp(egcpool_extended_gcluster(pool, c1),
+                 egcpool_extended_gcluster(pool, c2));
+}
+
+// Having just emitted the single-column cell at 'x' (whose style and colors
+// are thus in effect), emit as many identical cells following it as we can,
+// up through 'runend', with a single escape: el if they're blanks running to
+// the end of the line, ech if they're blanks and we can then move past them
+// cheaply enough, or rep. Blanks can only be erased if the erasure will take
+// on their background: the terminal must have bce, or they must use the
+// default background. Returns the number of cells emitted, which will be 0
+// if no escape beats writing the cells out, or -1 on error.
+static int
+rasterize_repeats(notcurses* nc, fbuf* out, const egcpool* pool,
+                  const cell* rowcells, int x, int runend, int y){
+  const cell* c = &rowcells[x];
+  int k = 0;
+  while(x + 1 + k < runend && cells_identical_p(pool, c, &rowcells[x + 1 + k])){
+    ++k;
+  }
+  if(k < 2){
+    return 0;
+  }
+  // writing them out would cost k times the EGC's bytes, the style and colors
+  // all being elided
+  int glen;
+  if(!cell_repeatable_p(pool, c, &glen)){
+    return 0;
+  }
+  paramcache* pc = &nc->pcache;
+  const int absx = nc->stdplane->absx;
+  if(cell_blank_p(c) && (nc->tcache.BCEflag || cell_bg_default_p(c))){
+    const int dimx = nc->stdplane->lenx;
+    if(x + 1 + k == dimx && absx + dimx == nc->truecols && nc->tcache.cleareol){
+      if(strlen(nc->tcache.cleareol) < (size_t)k){
+        if(fbuf_emit(out, nc->tcache.cleareol)){
+          return -1;
+        }
+        nc->stats.glyph_bytes += strlen(nc->tcache.cleareol);
+        return k;
+      }
+    }
+    int ecost = escache_cost(&pc->ech, k);
+    int mcost = 0;
+    if(x + 1 + k < runend){ // we'll need to move past them
+      mcost = escache_cost(&pc->cuf, k);
+      int hcost = escache_cost(&pc->hpa, absx + x + 1 + k);
+      if(hcost < mcost){
+        mcost = hcost;
+      }
+    }
+    if(ecost < INT_MAX && mcost < INT_MAX && ecost + mcost < k){
+      if(escache_emit(out, &pc->ech, k)){
+        return -1;
+      }
+      nc->stats.glyph_bytes += ecost;
+      if(x + 1 + k < runend){
+        if(stage_cursor(nc, out, y, absx + x + 1 + k)){
+          return -1;
+        }
+      }
+      return k;
+    }
+  }
+  const int rcost = escache_cost(&pc->rep, k);
+  if(rcost < k * glen){
+    if(escache_emit(out, &pc->rep, k)){
+      return -1;
+    }
+    nc->stats.glyph_bytes += rcost;
+    nc->rstate.x += k;
+    return k;
+  }
+  return 0;
+}
+
+// Perform the hardware scroll planned by plan_hwscroll(): restrict the
+// scrolling region to the rows being shifted, scroll it from its bottom row
+// with ind (or indn, if shorter), and restore the full scrolling region.
+// Changing the region homes the cursor.
+static int
+rasterize_hwscroll(notcurses* nc, fbuf* out){
+  const hwscroll* hs = &nc->hwscroll;
+  const int absy = nc->stdplane->absy;
+  const size_t used = out->used;
+  int ret = fbuf_emit(out, tiparm(nc->tcache.csr, absy + hs->top, absy + hs->bottom));
+  nc->rstate.x = nc->rstate.y = -1;
+  ret |= cursor_motion(nc, out, absy + hs->bottom, 0);
+  const char* indn = nc->tcache.indn ? tiparm(nc->tcache.indn, hs->rows) : NULL;
+  if(indn && (!nc->tcache.ind || strlen(indn) < hs->rows * strlen(nc->tcache.ind))){
+    ret |= fbuf_emit(out, indn);
+  }else{
+    for(int i = 0 ; i < hs->rows ; ++i){
+      ret |= fbuf_emit(out, nc->tcache.ind);
+    }
+  }
+  ret |= fbuf_emit(out, tiparm(nc->tcache.csr, 0, nc->truerows - 1));
+  nc->rstate.x = nc->rstate.y = -1;
+  nc->stats.motion_bytes += out->used - used;
+  nc->stats.hwscrolls += hs->rows;
+  nc->hwscroll.rows = 0;
+  return ret;
+}
+
 // Takes a rendered frame (a flat framebuffer, where each cell has the desired
 // EGC, attribute, and channels), which has been written to nc->lastframe, and
-// spits out an optimal sequence of terminal-appropriate escapes and EGCs. There
-// should be an rvec entry for each cell, but only the 'damaged' field is used.
-// lastframe has *not yet been written to the screen*, i.e. it's only about to
-// *become* the last frame rasterized.
+// spits out an optimal sequence of terminal-appropriate escapes and EGCs. Only
+// cells set in the 'damage' map are emitted; if 'damage' is NULL, every cell
+// is emitted. lastframe has *not yet been written to the screen*, i.e. it's
+// only about to *become* the last frame rasterized. Any hardware scroll
+// already applied to lastframe is performed first. With NCOPTION_SYNC_UPDATES,
+// a nonempty frame is bracketed as a synchronized update.
 static int
-notcurses_rasterize(notcurses* nc, const struct crender* rvec, FILE* out){
+notcurses_rasterize(notcurses* nc, const uint64_t* damage, fbuf* out){
   int ret = 0;
-  int y, x;
-  fseeko(out, 0, SEEK_SET);
-  // we only need to emit a coordinate if it was damaged. the damagemap is a
-  // bit per coordinate, one per struct crender.
+  fbuf_reset(out);
+  if(nc->syncupdates){
+    ret |= fbuf_puts(out, nc->tcache.bsu);
+  }
+  const size_t bsulen = out->used;
+  if(nc->hwscroll.rows){
+    ret |= rasterize_hwscroll(nc, out);
+  }
+  // we only need to emit a coordinate if it was damaged. the damage map is a
+  // bit per coordinate, and each row begins on a fresh word, so we can discard
+  // undamaged rows (and 64-cell stretches of rows) a word at a time, and find
+  // runs of damage with bit scans. the cursor is positioned once per run.
   // don't write a clearscreen. we only update things that have been changed.
-  // we explicitly move the cursor at the beginning of each output line, so no
-  // need to home it expliticly.
+  // we explicitly move the cursor at the beginning of each run, so no need to
+  // home it explicitly.
   update_palette(nc, out);
-  for(y = nc->stdplane->absy ; y < nc->stdplane->leny + nc->stdplane->absy ; ++y){
-    const int innery = y - nc->stdplane->absy;
-    for(x = nc->stdplane->absx ; x < nc->stdplane->lenx + nc->stdplane->absx ; ++x){
-      const int innerx = x - nc->stdplane->absx;
-      const size_t damageidx = innery * nc->lfdimx + innerx;
-      unsigned r, g, b, br, bg, bb, palfg, palbg;
-      const cell* srccell = &nc->lastframe[damageidx];
-//      cell c;
-//      memcpy(c, srccell, sizeof(*c)); // unsafe copy of gcluster
-//fprintf(stderr, "COPYING: %d from %p\n", c->gcluster, &nc->pool);
-//      const char* egc = pool_egc_copy(&nc->pool, srccell);
-//      c->gcluster = 0; // otherwise cell_release() will blow up
-      if(!rvec[damageidx].damaged){
-        // no need to emit a cell; what we rendered appears to already be
-        // here. no updates are performed to elision state nor lastframe.
-        ++nc->stats.cellelisions;
-        if(cell_wide_left_p(srccell)){
-          ++x;
-        }
-      }else{
-        ++nc->stats.cellemissions;
-        ret |= stage_cursor(nc, out, y, x);
-        // set the style. this can change the color back to the default; if it
-        // does, we need update our elision possibilities.
-        bool normalized;
-        ret |= term_setstyles(out, &nc->rstate.curattr, srccell, &normalized,
-                              nc->tcache.sgr0, nc->tcache.sgr,
-                              nc->tcache.italics, nc->tcache.italoff);
-        if(normalized){
-          nc->rstate.defaultelidable = true;
-          nc->rstate.bgelidable = false;
-          nc->rstate.fgelidable = false;
-          nc->rstate.bgpalelidable = false;
-          nc->rstate.fgpalelidable = false;
-        }
-        // we allow these to be set distinctly, but terminfo only supports using
-        // them both via the 'op' capability. unless we want to generate the 'op'
-        // escapes ourselves, if either is set to default, we first send op, and
-        // then a turnon for whichever aren't default.
-
-        // if our cell has a default foreground *or* background, we can elide the
-        // default set iff one of:
-        //  * we are a partial glyph, and the previous was default on both, or
-        //  * we are a no-foreground glyph, and the previous was default background, or
-        //  * we are a no-background glyph, and the previous was default foreground
-        bool noforeground = cell_noforeground_p(srccell);
-        bool nobackground = cell_nobackground_p(srccell);
-        if((!noforeground && cell_fg_default_p(srccell)) || (!nobackground && cell_bg_default_p(srccell))){
-          if(!nc->rstate.defaultelidable){
-            ++nc->stats.defaultemissions;
-            if(nc->tcache.op){
-              ret |= term_emit("op", nc->tcache.op, out, false);
-            }
-          }else{
-            ++nc->stats.defaultelisions;
-          }
-          // if either is not default, this will get turned off
-          nc->rstate.defaultelidable = true;
-          nc->rstate.fgelidable = false;
-          nc->rstate.bgelidable = false;
-          nc->rstate.fgpalelidable = false;
-          nc->rstate.bgpalelidable = false;
-        }
-        // if our cell has a non-default foreground, we can elide the non-default
-        // foreground set iff either:
-        //  * the previous was non-default, and matches what we have now, or
-        //  * we are a no-foreground glyph (iswspace() is true)
-        if(noforeground){
-          ++nc->stats.fgelisions;
-        }else if(cell_fg_palindex_p(srccell)){ // palette-indexed foreground
-          palfg = cell_fg_palindex(srccell);
-          // we overload lastr for the palette index; both are 8 bits
-          if(nc->rstate.fgpalelidable && nc->rstate.lastr == palfg){
-            ++nc->stats.fgelisions;
-          }else{
-            ret |= term_fg_palindex(nc, out, palfg);
-            ++nc->stats.fgemissions;
-            nc->rstate.fgpalelidable = true;
-          }
-          nc->rstate.lastr = palfg;
-          nc->rstate.defaultelidable = false;
-          nc->rstate.fgelidable = false;
-        }else if(!cell_fg_default_p(srccell)){ // rgb foreground
-          cell_fg_rgb(srccell, &r, &g, &b);
-          if(nc->rstate.fgelidable && nc->rstate.lastr == r && nc->rstate.lastg == g && nc->rstate.lastb == b){
-            ++nc->stats.fgelisions;
-          }else{
-            ret |= term_fg_rgb8(nc->tcache.RGBflag, nc->tcache.setaf, nc->tcache.colors, out, r, g, b);
-            ++nc->stats.fgemissions;
-            nc->rstate.fgelidable = true;
-          }
-          nc->rstate.lastr = r; nc->rstate.lastg = g; nc->rstate.lastb = b;
-          nc->rstate.defaultelidable = false;
-          nc->rstate.fgpalelidable = false;
+  const int dimx = nc->stdplane->lenx;
+  const size_t rowwords = damage_rowwords(nc->lfdimx);
+  for(int innery = 0 ; innery < nc->stdplane->leny ; ++innery){
+    const int y = innery + nc->stdplane->absy;
+    const egcpool* pool = lastframe_pool(nc, innery);
+    const cell* rowcells = &nc->lastframe[innery * nc->lfdimx];
+    int emitted = 0;
+    int innerx = 0; // first column not yet covered by an emitted cell
+    int runstart = 0;
+    while(runstart < dimx){
+      int runend = dimx;
+      if(damage){
+        runstart = damage_next(damage + innery * rowwords, runstart, dimx, true);
+        if(runstart >= dimx){
+          break;
         }
-        if(nobackground){
-          ++nc->stats.bgelisions;
-        }else if(cell_bg_palindex_p(srccell)){ // palette-indexed background
-          palbg = cell_bg_palindex(srccell);
-          if(nc->rstate.bgpalelidable && nc->rstate.lastbr == palbg){
-            ++nc->stats.bgelisions;
-          }else{
-            ret |= term_bg_palindex(nc, out, palbg);
-            ++nc->stats.bgemissions;
-            nc->rstate.bgpalelidable = true;
-          }
-          nc->rstate.lastr = palbg;
-          nc->rstate.defaultelidable = false;
-          nc->rstate.bgelidable = false;
-        }else if(!cell_bg_default_p(srccell)){ // rgb background
-          cell_bg_rgb(srccell, &br, &bg, &bb);
-          if(nc->rstate.bgelidable && nc->rstate.lastbr == br && nc->rstate.lastbg == bg && nc->rstate.lastbb == bb){
-            ++nc->stats.bgelisions;
-          }else{
-            ret |= term_bg_rgb8(nc->tcache.RGBflag, nc->tcache.setab, nc->tcache.colors, out, br, bg, bb);
-            ++nc->stats.bgemissions;
-            nc->rstate.bgelidable = true;
-          }
-          nc->rstate.lastbr = br; nc->rstate.lastbg = bg; nc->rstate.lastbb = bb;
-          nc->rstate.defaultelidable = false;
-          nc->rstate.bgpalelidable = false;
-        }
-/*if(cell_simple_p(srccell)){
-fprintf(stderr, "RAST %u [%c] to %d/%d\n", srccell->gcluster, srccell->gcluster, y, x);
-}else{
-fprintf(stderr, "RAST %u [%s] to %d/%d\n", srccell->gcluster, egcpool_extended_gcluster(&nc->pool, srccell), y, x);
-}*/
-        if(term_putc(out, &nc->pool, srccell) == 0){
-          ++nc->rstate.x;
+        runend = damage_next(damage + innery * rowwords, runstart, dimx, false);
+      }
+      // a wide glyph emitted at the end of the previous run might have
+      // covered the start of this one, as might an undamaged one.
+      if(runstart < innerx){
+        runstart = innerx;
+      }else if(wide_covered_p(rowcells, innerx, runstart)){
+        ++runstart;
+      }
+      if(runstart < runend){
+        ret |= stage_cursor(nc, out, y, runstart + nc->stdplane->absx);
+        for(innerx = runstart ; innerx < runend ; ){
+          const cell* srccell = &rowcells[innerx];
+          ret |= rasterize_cell(nc, out, pool, srccell);
+          ++emitted;
           if(cell_wide_left_p(srccell)){
-            ++nc->rstate.x;
-            ++x;
+            innerx += 2;
+          }else{
+            int repeats = rasterize_repeats(nc, out, pool, rowcells, innerx, runend, y);
+            if(repeats < 0){
+              ret = -1;
+              repeats = 0;
+            }
+            emitted += repeats;
+            innerx += 1 + repeats;
           }
-          // if the terminal's own motion carried us down to the next line,
-          // we need update our concept of the cursor's true y
-          /*if(nc->rstate.x >= nc->truecols){
-            ++nc->rstate.y; // FIXME not if on last line, right?
-            nc->rstate.x = 0;
-          }*/
-        }else{
-          ret = -1;
         }
       }
-//fprintf(stderr, "damageidx: %ld\n", damageidx);
+      runstart = runend;
     }
-  }
-  ret |= fflush(out);
-  //fflush(nc->ttyfp);
-  if(blocking_write(fileno(nc->ttyfp), nc->rstate.mstream, nc->rstate.mstrsize)){
-    ret = -1;
+    nc->stats.cellemissions += emitted;
+    // no need to emit undamaged cells; what we rendered appears to already
+    // be here. no updates are performed to elision state nor lastframe.
+    nc->stats.cellelisions += dimx - emitted;
   }
 //fprintf(stderr, "%lu/%lu %lu/%lu %lu/%lu %d\n", nc->stats.defaultelisions, nc->stats.defaultemissions, nc->stats.fgelisions, nc->stats.fgemissions, nc->stats.bgelisions, nc->stats.bgemissions, ret);
-  if(nc->renderfp){
-    fprintf(nc->renderfp, "%s\n", nc->rstate.mstream);
+  if(nc->syncupdates){
+    if(out->used == bsulen){
+      fbuf_reset(out); // nothing changed; don't bother the terminal
+    }else{
+      ret |= fbuf_puts(out, nc->tcache.esu);
+      nc->stats.sync_bytes += strlen(nc->tcache.bsu) + strlen(nc->tcache.esu);
+    }
   }
   if(ret < 0){
     return ret;
   }
-  return nc->rstate.mstrsize;
+  return out->used;
+}
+
+// Rasterize a rendered frame into nc->rstate.f, recording the time taken.
+static int
+rasterize_frame(notcurses* nc, const uint64_t* damage){
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  int bytes = notcurses_rasterize(nc, damage, &nc->rstate.f);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  if(bytes >= 0){
+    stats_phase(&nc->stats.raster_ns, nc->stats.raster_hist,
+                timespec_to_ns(&t1) - timespec_to_ns(&t0));
+  }
+  return bytes;
+}
+
+// Write a rasterized frame to the terminal (or the headless virtual
+// terminal), and to the debugging renderfp if one was provided.
+static int
+notcurses_write_frame(notcurses* nc, const fbuf* f){
+  int ret = 0;
+  if(nc->vscreen){
+    ret = vscreen_write(nc->vscreen, f->buf, f->used);
+  }else if(blocking_write(fileno(nc->ttyfp), f->buf, f->used)){
+    ret = -1;
+  }
+  if(nc->renderfp){
+    if(f->used){
+      fwrite(f->buf, 1, f->used, nc->renderfp);
+    }
+    fputc('\n', nc->renderfp);
+  }
+  return ret;
+}
+
+// emit a capability outside of any frame
+static int
+nc_emit(notcurses* nc, const char* name, const char* seq, bool flush){
+  if(nc->vscreen){
+    return vscreen_write(nc->vscreen, seq, strlen(seq));
+  }
+  return term_emit(name, seq, nc->ttyfp, flush);
 }
 
 // get the cursor to the upper-left corner by one means or another. will clear
@@ -953,11 +1728,11 @@ static int
 home_cursor(notcurses* nc, bool flush){
   int ret = -1;
   if(nc->tcache.home){
-    ret = term_emit("home", nc->tcache.home, nc->ttyfp, flush);
+    ret = nc_emit(nc, "home", nc->tcache.home, flush);
   }else if(nc->tcache.cup){
-    ret = term_emit("cup", tiparm(nc->tcache.cup, 1, 1), nc->ttyfp, flush);
+    ret = nc_emit(nc, "cup", tiparm(nc->tcache.cup, 1, 1), flush);
   }else if(nc->tcache.clearscr){
-    ret = term_emit("clear", nc->tcache.clearscr, nc->ttyfp, flush);
+    ret = nc_emit(nc, "clear", nc->tcache.clearscr, flush);
   }
   if(ret >= 0){
     nc->rstate.x = 0;
@@ -973,108 +1748,668 @@ int notcurses_refresh(notcurses* nc, int* restrict dimy, int* restrict dimx){
   if(nc->lfdimx == 0 || nc->lfdimy == 0){
     return 0;
   }
-  if(home_cursor(nc, true)){
+  if(notcurses_render_wait(nc)){
     return -1;
   }
-  const int count = (nc->lfdimx > nc->stdplane->lenx ? nc->lfdimx : nc->stdplane->lenx) *
-                    (nc->lfdimy > nc->stdplane->leny ? nc->lfdimy : nc->stdplane->leny);
-  struct crender* rvec = malloc(count * sizeof(*rvec));
-  if(rvec == NULL){
+  if(home_cursor(nc, true)){
     return -1;
   }
-  memset(rvec, 0, count * sizeof(*rvec));
-  for(int i = 0 ; i < count ; ++i){
-    rvec[i].damaged = true;
-  }
-  int ret = notcurses_rasterize(nc, rvec, nc->rstate.mstreamfp);
-  free(rvec);
-  if(ret < 0){
+  if(notcurses_rasterize(nc, NULL, &nc->rstate.f) < 0){
     return -1;
   }
-  return 0;
+  return notcurses_write_frame(nc, &nc->rstate.f);
 }
 
+// The frame written to 'fp' never reaches the terminal, so it is rasterized
+// into a scratch fbuf, and everything rasterization updates (the presentation
+// state, palette damage, any planned scroll, and the stats) is restored after.
 int notcurses_render_to_file(struct notcurses* nc, FILE* fp){
   if(nc->lfdimx == 0 || nc->lfdimy == 0){
     return 0;
   }
-  char* rastered = NULL;
-  size_t rastbytes = 0;
-  FILE* out = open_memstream(&rastered, &rastbytes);
-  if(out == NULL){
+  const renderstate rstate = nc->rstate;
+  const hwscroll hs = nc->hwscroll;
+  bool palette_damage[NCPALETTESIZE];
+  memcpy(palette_damage, nc->palette_damage, sizeof(palette_damage));
+  const ncstats stats = nc->stats;
+  fbuf f = {};
+  int ret = -1;
+  if(notcurses_rasterize(nc, NULL, &f) >= 0){
+    ret = fbuf_flush(&f, fp);
+  }
+  fbuf_free(&f);
+  nc->rstate = rstate;
+  nc->hwscroll = hs;
+  memcpy(nc->palette_damage, palette_damage, sizeof(palette_damage));
+  nc->stats = stats;
+  return ret;
+}
+
+
+// Solve rows [firsty, lasty) of the rendering area, walking down the z-axis
+// through every plane, and then diff them against lastframe. 'pool' must back
+// those rows of lastframe. No state outside of those rows is touched, so
+// disjoint ranges can be solved concurrently. Occluded cells are added to
+// 'culled', and time spent in postpaint() to 'postpaintns'.
+static int
+paint_rows(notcurses* nc, egcpool* pool, int firsty, int lasty,
+           uint64_t* culled, uint64_t* postpaintns){
+  const int dimx = nc->stdplane->lenx;
+  arena_clear_rows(&nc->arena, firsty, lasty, dimx);
+  ncplane* p = nc->top;
+  while(p){
+    if(paint(p, nc->lastframe, &nc->arena, pool, firsty, lasty, dimx,
+             nc->stdplane->absy, nc->stdplane->absx, nc->lfdimx, culled)){
+      return -1;
+    }
+    p = p->below;
+  }
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  postpaint(&nc->arena, nc->lastframe, firsty, lasty, dimx, pool);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  *postpaintns += timespec_to_ns(&t1) - timespec_to_ns(&t0);
+  return 0;
+}
+
+// Paint each maximal run of dirty rows within [firsty, lasty). Clean rows are
+// left untouched, both in lastframe and the damage map.
+static int
+paint_dirty_rows(notcurses* nc, egcpool* pool, int firsty, int lasty,
+                 uint64_t* culled, uint64_t* postpaintns){
+  int y = firsty;
+  while(y < lasty){
+    while(y < lasty && !nc->dirtyrows[y]){
+      ++y;
+    }
+    const int runstart = y;
+    while(y < lasty && nc->dirtyrows[y]){
+      ++y;
+    }
+    if(runstart < y){
+      if(paint_rows(nc, pool, runstart, y, culled, postpaintns)){
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+// Fold each plane's changed rows into the rendering area's dirty rows, and
+// mark the planes clean.
+static void
+collect_dirty_rows(notcurses* nc){
+  for(ncplane* p = nc->top ; p ; p = p->below){
+    if(p->dirtyy0 < p->dirtyy1){
+      notcurses_dirty_rows(nc, p->absy + p->dirtyy0, p->dirtyy1 - p->dirtyy0);
+    }
+    ncplane_clean(p);
+  }
+}
+
+// Shift rows [top, bottom] of lastframe up by 'rows', as a hardware scroll of
+// those rows will shift them on the terminal. Glyphs scrolled off the top are
+// released. When painting in parallel, a row can move to a band with another
+// pool, and its EGCs must be moved along with it. The rows exposed at the
+// bottom are zeroed; their contents are unknown until redrawn.
+static void
+lastframe_scroll(notcurses* nc, int top, int bottom, int rows){
+  const int dimx = nc->lfdimx;
+  for(int y = top ; y < top + rows ; ++y){
+    egcpool* pool = lastframe_pool(nc, y);
+    for(int x = 0 ; x < dimx ; ++x){
+      pool_release(pool, &nc->lastframe[y * dimx + x]);
+    }
+  }
+  for(int y = top ; y + rows <= bottom ; ++y){
+    cell* dst = &nc->lastframe[y * dimx];
+    cell* src = &nc->lastframe[(y + rows) * dimx];
+    egcpool* dstpool = lastframe_pool(nc, y);
+    egcpool* srcpool = lastframe_pool(nc, y + rows);
+    memcpy(dst, src, sizeof(*dst) * dimx);
+    if(dstpool != srcpool){
+      for(int x = 0 ; x < dimx ; ++x){
+        if(!cell_simple_p(&src[x])){
+          const char* egc = egcpool_extended_gcluster(srcpool, &src[x]);
+          int eoffset = egcpool_stash(dstpool, egc, strlen(egc));
+          if(eoffset < 0){
+            cell_init(&dst[x]);
+          }else{
+            dst[x].gcluster = egcpool_gcluster(eoffset);
+          }
+          pool_release(srcpool, &src[x]);
+        }
+      }
+    }
+  }
+  memset(&nc->lastframe[(bottom + 1 - rows) * dimx], 0,
+         sizeof(*nc->lastframe) * rows * dimx);
+}
+
+// If a full-width plane has scrolled since the last render (and nothing else
+// has changed its geometry), the rows it covers can be shifted by the terminal
+// itself, rather than redrawn. We shift them in lastframe just as the terminal
+// will, and mark them dirty. Diffing then finds only what changed otherwise
+// (e.g. planes above the scrolling one, which didn't move), plus the rows
+// exposed at the bottom, which must always be redrawn. Only the topmost such
+// plane is scrolled. Scrolling is skipped while the writer holds a queued
+// frame, as that frame might yet be dropped, and its damage carried forward.
+static void
+plan_hwscroll(notcurses* nc){
+  if(nc->hwscroll.rows || nc->lastframe == NULL || nc->tcache.csr == NULL ||
+     (nc->tcache.ind == NULL && nc->tcache.indn == NULL)){
+    return;
+  }
+  // the terminal scrolls entire rows, margins included
+  if(nc->lfdimx != nc->truecols){
+    return;
+  }
+  const ncplane* stdn = nc->stdplane;
+  if(nc->writer){
+    ttywriter* w = nc->writer;
+    pthread_mutex_lock(&w->lock);
+    const bool queued = w->queued.used;
+    pthread_mutex_unlock(&w->lock);
+    if(queued){
+      return;
+    }
+  }
+  for(const ncplane* p = nc->top ; p ; p = p->below){
+    if(p->scrolls == 0 || p->absx > stdn->absx ||
+       p->absx + p->lenx < stdn->absx + nc->lfdimx){
+      continue;
+    }
+    int top = p->absy - stdn->absy;
+    int bottom = top + p->leny - 1;
+    if(top < 0){
+      top = 0;
+    }
+    if(bottom >= nc->lfdimy){
+      bottom = nc->lfdimy - 1;
+    }
+    if(p->scrolls <= bottom - top){
+      lastframe_scroll(nc, top, bottom, p->scrolls);
+      notcurses_dirty_rows(nc, stdn->absy + top, bottom - top + 1);
+      nc->hwscroll.top = top;
+      nc->hwscroll.bottom = bottom;
+      nc->hwscroll.rows = p->scrolls;
+      return;
+    }
+  }
+}
+
+// Claim and paint bands until none remain in this generation. Must be called
+// with rw->lock held, which is dropped while painting, and held on return.
+static void
+paint_bands_locked(notcurses* nc, renderworkers* rw){
+  const int dimy = nc->stdplane->leny;
+  unsigned band;
+  while((band = rw->nextband) < rw->bands){
+    ++rw->nextband;
+    const int firsty = band * rw->bandrows;
+    int lasty = firsty + rw->bandrows;
+    if(lasty > dimy){
+      lasty = dimy;
+    }
+    pthread_mutex_unlock(&rw->lock);
+    int r = 0;
+    uint64_t culled = 0;
+    uint64_t postpaintns = 0;
+    if(firsty < lasty){
+      r = paint_dirty_rows(nc, &rw->pools[band], firsty, lasty, &culled,
+                           &postpaintns);
+    }
+    pthread_mutex_lock(&rw->lock);
+    if(r){
+      rw->failed = true;
+    }
+    rw->culled += culled;
+    if(postpaintns > rw->postpaintns){
+      rw->postpaintns = postpaintns;
+    }
+    if(--rw->pending == 0){
+      pthread_cond_signal(&rw->donecond);
+    }
+  }
+}
+
+static void*
+render_worker(void* vnc){
+  notcurses* nc = vnc;
+  renderworkers* rw = nc->rworkers;
+  uint64_t seen = 0;
+  pthread_mutex_lock(&rw->lock);
+  while(true){
+    while(!rw->shutdown && rw->generation == seen){
+      pthread_cond_wait(&rw->cond, &rw->lock);
+    }
+    if(rw->shutdown){
+      break;
+    }
+    seen = rw->generation;
+    paint_bands_locked(nc, rw);
+  }
+  pthread_mutex_unlock(&rw->lock);
+  return NULL;
+}
+
+int render_workers_start(notcurses* nc){
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if(cpus <= 1){
+    loginfo(nc, "%ld processor(s) online, rendering serially\n", cpus);
+    return 0;
+  }
+  renderworkers* rw = malloc(sizeof(*rw));
+  if(rw == NULL){
     return -1;
   }
-  const int count = (nc->lfdimx > nc->stdplane->lenx ? nc->lfdimx : nc->stdplane->lenx) *
-                    (nc->lfdimy > nc->stdplane->leny ? nc->lfdimy : nc->stdplane->leny);
-  struct crender* rvec = malloc(count * sizeof(*rvec));
-  if(rvec == NULL){
-    fclose(out);
-    free(rastered);
+  memset(rw, 0, sizeof(*rw));
+  rw->bands = cpus;
+  rw->bandrows = 1;
+  rw->pools = malloc(sizeof(*rw->pools) * rw->bands);
+  rw->tids = malloc(sizeof(*rw->tids) * (rw->bands - 1));
+  if(rw->pools == NULL || rw->tids == NULL){
+    free(rw->pools);
+    free(rw->tids);
+    free(rw);
     return -1;
   }
-  memset(rvec, 0, count * sizeof(*rvec));
-  for(int i = 0 ; i < count ; ++i){
-    rvec[i].damaged = true;
+  for(unsigned b = 0 ; b < rw->bands ; ++b){
+    egcpool_init(&rw->pools[b]);
+  }
+  pthread_mutex_init(&rw->lock, NULL);
+  pthread_cond_init(&rw->cond, NULL);
+  pthread_cond_init(&rw->donecond, NULL);
+  nc->rworkers = rw;
+  for(unsigned t = 0 ; t < rw->bands - 1 ; ++t){
+    if(pthread_create(&rw->tids[t], NULL, render_worker, nc)){
+      logerror(nc, "Couldn't launch render worker %u/%u\n", t + 1, rw->bands - 1);
+      rw->bands = t + 1; // only join those we launched
+      render_workers_stop(nc);
+      return -1;
+    }
   }
-  int ret = notcurses_rasterize(nc, rvec, out);
-  free(rvec);
-  if(ret > 0){
-    if(fprintf(fp, "%s", rastered) == ret){
-      ret = 0;
+  loginfo(nc, "Painting with %u bands\n", rw->bands);
+  return 0;
+}
+
+void render_workers_stop(notcurses* nc){
+  renderworkers* rw = nc->rworkers;
+  if(rw == NULL){
+    return;
+  }
+  pthread_mutex_lock(&rw->lock);
+  rw->shutdown = true;
+  pthread_cond_broadcast(&rw->cond);
+  pthread_mutex_unlock(&rw->lock);
+  for(unsigned t = 0 ; t < rw->bands - 1 ; ++t){
+    pthread_join(rw->tids[t], NULL);
+  }
+  for(unsigned b = 0 ; b < rw->bands ; ++b){
+    egcpool_dump(&rw->pools[b]);
+  }
+  pthread_cond_destroy(&rw->donecond);
+  pthread_cond_destroy(&rw->cond);
+  pthread_mutex_destroy(&rw->lock);
+  free(rw->pools);
+  free(rw->tids);
+  free(rw);
+  nc->rworkers = NULL;
+}
+
+static void*
+tty_writer(void* vw){
+  ttywriter* w = vw;
+  pthread_mutex_lock(&w->lock);
+  while(true){
+    while(!w->shutdown && w->queued.used == 0){
+      pthread_cond_wait(&w->cond, &w->lock);
+    }
+    if(w->queued.used == 0){ // shutting down, and nothing remains to write
+      break;
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    // hold the frame until the next tick, unless we're draining. frames
+    // rendered meanwhile replace it (see notcurses_queue_frame()).
+    if(w->interval && !w->shutdown && w->lastwritens &&
+       timespec_to_ns(&t0) < w->lastwritens + w->interval){
+      struct timespec tick;
+      ns_to_timespec(w->lastwritens + w->interval, &tick);
+      pthread_cond_timedwait(&w->cond, &w->lock, &tick);
+      continue;
+    }
+    w->lastwritens = timespec_to_ns(&t0);
+    fbuf f = w->writing;
+    w->writing = w->queued;
+    w->queued = f;
+    w->busy = true;
+    pthread_mutex_unlock(&w->lock);
+    int r;
+    if(w->vscreen){
+      r = vscreen_write(w->vscreen, w->writing.buf, w->writing.used);
     }else{
-      ret = -1;
+      r = blocking_write(w->fd, w->writing.buf, w->writing.used);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    pthread_mutex_lock(&w->lock);
+    stats_phase(&w->write_ns, w->write_hist,
+                timespec_to_ns(&t1) - timespec_to_ns(&t0));
+    fbuf_reset(&w->writing);
+    if(r){
+      w->failed = true;
+    }
+    w->busy = false;
+    if(w->queued.used == 0){
+      pthread_cond_broadcast(&w->donecond);
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+  return NULL;
+}
+
+int tty_writer_start(notcurses* nc){
+  ttywriter* w = malloc(sizeof(*w));
+  if(w == NULL){
+    return -1;
+  }
+  memset(w, 0, sizeof(*w));
+  w->fd = nc->ttyfp ? fileno(nc->ttyfp) : -1;
+  w->vscreen = nc->vscreen;
+  w->qdimy = -1;
+  pthread_mutex_init(&w->lock, NULL);
+  // frames are held against the monotonic clock
+  pthread_condattr_t cattr;
+  pthread_condattr_init(&cattr);
+  pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+  pthread_cond_init(&w->cond, &cattr);
+  pthread_condattr_destroy(&cattr);
+  pthread_cond_init(&w->donecond, NULL);
+  if(pthread_create(&w->tid, NULL, tty_writer, w)){
+    logerror(nc, "Couldn't launch tty writer\n");
+    pthread_cond_destroy(&w->donecond);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+    return -1;
+  }
+  nc->writer = w;
+  return 0;
+}
+
+int tty_writer_stop(notcurses* nc){
+  ttywriter* w = nc->writer;
+  if(w == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&w->lock);
+  w->shutdown = true;
+  pthread_cond_signal(&w->cond);
+  pthread_mutex_unlock(&w->lock);
+  pthread_join(w->tid, NULL);
+  int ret = w->failed ? -1 : 0;
+  tty_writer_stats(nc, &nc->stats, true); // keep the final write timings
+  fbuf_free(&w->queued);
+  fbuf_free(&w->writing);
+  free(w->qdamage);
+  pthread_cond_destroy(&w->donecond);
+  pthread_cond_destroy(&w->cond);
+  pthread_mutex_destroy(&w->lock);
+  free(w);
+  nc->writer = NULL;
+  return ret;
+}
+
+void tty_writer_stats(const notcurses* nc, ncstats* stats, bool take){
+  ttywriter* w = nc->writer;
+  if(w == NULL){
+    stats->queuedbytes = 0;
+    return;
+  }
+  pthread_mutex_lock(&w->lock);
+  stats->queuedbytes = w->queued.used + w->writing.used;
+  stats->write_ns += w->write_ns;
+  for(int i = 0 ; i < NCSTATS_BUCKETS ; ++i){
+    stats->write_hist[i] += w->write_hist[i];
+  }
+  if(take){
+    w->write_ns = 0;
+    memset(w->write_hist, 0, sizeof(w->write_hist));
+  }
+  pthread_mutex_unlock(&w->lock);
+}
+
+int notcurses_render_wait(notcurses* nc){
+  ttywriter* w = nc->writer;
+  if(w == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&w->lock);
+  while(w->queued.used || w->busy){
+    pthread_cond_wait(&w->donecond, &w->lock);
+  }
+  int ret = w->failed ? -1 : 0;
+  w->failed = false;
+  pthread_mutex_unlock(&w->lock);
+  return ret;
+}
+
+int notcurses_set_maxfps(notcurses* nc, unsigned maxfps){
+  const uint64_t interval = maxfps ? NANOSECS_IN_SEC / maxfps : 0;
+  if(nc->writer == NULL){
+    if(interval == 0){
+      return 0;
+    }
+    // frames are paced by the writer, which holds each until its tick
+    if(tty_writer_start(nc)){
+      return -1;
+    }
+  }else if(interval == 0 && !nc->asyncwrite){
+    // the writer was only pacing; write out any held frame, and return to
+    // synchronous writes
+    return tty_writer_stop(nc);
+  }
+  ttywriter* w = nc->writer;
+  pthread_mutex_lock(&w->lock);
+  w->interval = interval;
+  pthread_cond_signal(&w->cond); // a held frame might now be due
+  pthread_mutex_unlock(&w->lock);
+  return 0;
+}
+
+// Rasterize the solved frame, and hand it to the asynchronous writer. If the
+// previous frame is still queued, the writer has fallen behind (or is holding
+// it until the next tick); that frame is dropped (or coalesced), and its
+// damage is rasterized anew along with this frame's (from the presentation
+// state preceding it), so no update is lost. A queued frame of different
+// geometry can't be dropped this way, and is instead extended.
+static int
+notcurses_queue_frame(notcurses* nc){
+  ttywriter* w = nc->writer;
+  const int dimy = nc->stdplane->leny;
+  const size_t words = damage_rowwords(nc->lfdimx) * dimy;
+  uint64_t* damage = nc->arena.damage;
+  pthread_mutex_lock(&w->lock);
+  if(w->queued.used && w->qdimy == dimy && w->qdimx == nc->lfdimx){
+    fbuf_reset(&w->queued);
+    fbuf f = nc->rstate.f;
+    nc->rstate = w->rstate;
+    nc->rstate.f = f;
+    for(size_t i = 0 ; i < sizeof(nc->palette_damage) / sizeof(*nc->palette_damage) ; ++i){
+      nc->palette_damage[i] |= w->palette_damage[i];
+    }
+    for(size_t i = 0 ; i < words ; ++i){
+      damage[i] |= w->qdamage[i];
+    }
+    // no scroll was planned for this frame while that one was queued, and
+    // lastframe reflects its scroll, which must thus be performed anew
+    nc->hwscroll = w->qscroll;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(w->interval && timespec_to_ns(&now) < w->lastwritens + w->interval){
+      ++nc->stats.renders_coalesced;
+    }else{
+      ++nc->stats.frames_dropped;
+    }
+  }else if(w->queued.used){
+    w->qdimy = -1; // the saved state no longer describes the queued frame
+  }
+  pthread_mutex_unlock(&w->lock);
+  // nothing but us ever fills the queue, so it remains empty (if it now is)
+  // while we rasterize. the saved state is only ever touched by us.
+  if(words > w->qdamagewords){
+    uint64_t* tmp = realloc(w->qdamage, sizeof(*tmp) * words);
+    if(tmp == NULL){
+      return -1;
     }
+    w->qdamage = tmp;
+    w->qdamagewords = words;
+  }
+  memcpy(w->qdamage, damage, sizeof(*damage) * words);
+  w->rstate = nc->rstate;
+  memset(&w->rstate.f, 0, sizeof(w->rstate.f));
+  memcpy(w->palette_damage, nc->palette_damage, sizeof(w->palette_damage));
+  w->qscroll = nc->hwscroll;
+  int bytes = rasterize_frame(nc, damage);
+  if(bytes < 0){
+    return -1;
+  }
+  if(nc->renderfp){
+    if(nc->rstate.f.used){
+      fwrite(nc->rstate.f.buf, 1, nc->rstate.f.used, nc->renderfp);
+    }
+    fputc('\n', nc->renderfp);
   }
-  fclose(out);
-  free(rastered);
+  if(bytes == 0){
+    return 0;
+  }
+  int ret = bytes;
+  pthread_mutex_lock(&w->lock);
+  if(w->queued.used){ // a frame of different geometry
+    if(fbuf_putn(&w->queued, nc->rstate.f.buf, nc->rstate.f.used)){
+      ret = -1;
+    }
+    w->qdimy = -1;
+  }else{
+    fbuf f = w->queued;
+    w->queued = nc->rstate.f;
+    nc->rstate.f = f;
+    w->qdimy = dimy;
+    w->qdimx = nc->lfdimx;
+  }
+  pthread_cond_signal(&w->cond);
+  pthread_mutex_unlock(&w->lock);
   return ret;
 }
 
+// Hand the frame to the parallel painters, pitch in, and wait for them all.
+static int
+paint_parallel(notcurses* nc, uint64_t* postpaintns){
+  renderworkers* rw = nc->rworkers;
+  pthread_mutex_lock(&rw->lock);
+  rw->nextband = 0;
+  rw->pending = rw->bands;
+  rw->failed = false;
+  rw->culled = 0;
+  rw->postpaintns = 0;
+  ++rw->generation;
+  pthread_cond_broadcast(&rw->cond);
+  paint_bands_locked(nc, rw);
+  while(rw->pending){
+    pthread_cond_wait(&rw->donecond, &rw->lock);
+  }
+  int ret = rw->failed ? -1 : 0;
+  nc->stats.cellsculled += rw->culled;
+  // bands are postpainted concurrently, so only the longest delays the frame
+  *postpaintns = rw->postpaintns;
+  pthread_mutex_unlock(&rw->lock);
+  return ret;
+}
 
-// We execute the painter's algorithm, starting from our topmost plane. The
-// damagevector should be all zeros on input. On success, it will reflect
-// which cells were changed. We solve for each coordinate's cell by walking
-// down the z-buffer, looking at intersections with ncplanes. This implies
-// locking down the EGC, the attributes, and the channels for each cell.
+// We execute the painter's algorithm, starting from our topmost plane, into
+// the render arena. On success, the arena's damage map will reflect which
+// cells were changed. We solve for each coordinate's cell by walking down the
+// z-buffer, looking at intersections with ncplanes. This implies locking down
+// the EGC, the attributes, and the channels for each cell. Only rows which
+// something touched since the last render are solved; the rest can't differ.
 static int
-notcurses_render_internal(notcurses* nc, struct crender* rvec){
+notcurses_render_internal(notcurses* nc){
+  if(nc->compactpools){
+    for(ncplane* p = nc->top ; p ; p = p->below){
+      if(egcpool_fragmented_p(&p->pool)){
+        ncplane_compact(p);
+      }
+    }
+  }
   int dimy, dimx;
   ncplane_dim_yx(nc->stdplane, &dimy, &dimx);
-  cell* fb = malloc(sizeof(*fb) * dimy * dimx);
-  init_fb(fb, dimy, dimx);
-  ncplane* p = nc->top;
-  while(p){
-    if(paint(p, nc->lastframe, rvec, fb, &nc->pool,
-             nc->stdplane->leny, nc->stdplane->lenx,
-             nc->stdplane->absy, nc->stdplane->absx, nc->lfdimx)){
-      free(fb);
-      return -1;
+  if(arena_reserve(nc, dimy, dimx)){
+    return -1;
+  }
+  plan_hwscroll(nc);
+  collect_dirty_rows(nc);
+  memset(nc->arena.damage, 0,
+         sizeof(*nc->arena.damage) * dimy * damage_rowwords(dimx));
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  uint64_t postpaintns = 0;
+  int ret;
+  if(nc->rworkers){
+    ret = paint_parallel(nc, &postpaintns);
+  }else{
+    ret = paint_dirty_rows(nc, &nc->pool, 0, dimy, &nc->stats.cellsculled,
+                           &postpaintns);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  if(ret == 0){
+    memset(nc->dirtyrows, false, sizeof(*nc->dirtyrows) * dimy);
+    // the rows exposed by a hardware scroll are redrawn in their entirety
+    const hwscroll* hs = &nc->hwscroll;
+    if(hs->rows){
+      const size_t rowwords = damage_rowwords(dimx);
+      memset(&nc->arena.damage[(hs->bottom + 1 - hs->rows) * rowwords], 0xff,
+             sizeof(*nc->arena.damage) * rowwords * hs->rows);
     }
-    p = p->below;
+    uint64_t paintns = timespec_to_ns(&t1) - timespec_to_ns(&t0);
+    paintns = paintns > postpaintns ? paintns - postpaintns : 0;
+    stats_phase(&nc->stats.paint_ns, nc->stats.paint_hist, paintns);
+    stats_phase(&nc->stats.postpaint_ns, nc->stats.postpaint_hist, postpaintns);
   }
-  postpaint(fb, nc->lastframe, dimy, dimx, rvec, &nc->pool);
-  free(fb);
-  return 0;
+  return ret;
 }
 
 int notcurses_render(notcurses* nc){
   struct timespec start, done;
-  int ret;
   clock_gettime(CLOCK_MONOTONIC, &start);
   int dimy, dimx;
   notcurses_resize(nc, &dimy, &dimx);
   int bytes = -1;
-  const size_t crenderlen = sizeof(struct crender) * nc->stdplane->leny * nc->stdplane->lenx;
-  struct crender* crender = malloc(crenderlen);
-  memset(crender, 0, crenderlen);
-  if(notcurses_render_internal(nc, crender) == 0){
-    bytes = notcurses_rasterize(nc, crender, nc->rstate.mstreamfp);
+  if(notcurses_render_internal(nc) == 0){
+    if(nc->writer){
+      bytes = notcurses_queue_frame(nc);
+    }else{
+      bytes = rasterize_frame(nc, nc->arena.damage);
+      if(bytes >= 0){
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if(notcurses_write_frame(nc, &nc->rstate.f)){
+          bytes = -1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        stats_phase(&nc->stats.write_ns, nc->stats.write_hist,
+                    timespec_to_ns(&t1) - timespec_to_ns(&t0));
+      }
+    }
   }
-  free(crender);
   clock_gettime(CLOCK_MONOTONIC, &done);
   update_render_stats(&done, &start, &nc->stats, bytes);
-  ret = bytes >= 0 ? 0 : -1;
-  return ret;
+  if(bytes < 0){
+    return -1;
+  }
+  if(nc->trace){
+    trace_render(nc);
+  }
+  return 0;
 }
 
 char* notcurses_at_yx(notcurses* nc, int yoff, int xoff, uint32_t* attrword, uint64_t* channels){
@@ -1089,19 +2424,18 @@ char* notcurses_at_yx(notcurses* nc, int yoff, int xoff, uint32_t* attrword, uin
         if(channels){
           *channels = srccell->channels;
         }
-//fprintf(stderr, "COPYING: %d from %p\n", srccell->gcluster, &nc->pool);
-        egc = pool_egc_copy(&nc->pool, srccell);
+        egc = pool_egc_copy(lastframe_pool(nc, yoff), srccell);
       }
     }
   }
   return egc;
 }
 
-int ncdirect_bg(ncdirect* nc, unsigned rgb){
+int ncdirect_bg_stage(ncdirect* nc, unsigned rgb){
   if(rgb > 0xffffffu){
     return -1;
   }
-  if(term_bg_rgb8(nc->tcache.RGBflag, nc->tcache.setab, nc->tcache.colors, nc->ttyfp,
+  if(term_bg_rgb8(&nc->tcache, &nc->f,
                   (rgb & 0xff0000u) >> 16u, (rgb & 0xff00u) >> 8u, rgb & 0xffu)){
     return -1;
   }
@@ -1110,11 +2444,11 @@ int ncdirect_bg(ncdirect* nc, unsigned rgb){
   return 0;
 }
 
-int ncdirect_fg(ncdirect* nc, unsigned rgb){
+int ncdirect_fg_stage(ncdirect* nc, unsigned rgb){
   if(rgb > 0xffffffu){
     return -1;
   }
-  if(term_fg_rgb8(nc->tcache.RGBflag, nc->tcache.setaf, nc->tcache.colors, nc->ttyfp,
+  if(term_fg_rgb8(&nc->tcache, &nc->f,
                   (rgb & 0xff0000u) >> 16u, (rgb & 0xff00u) >> 8u, rgb & 0xffu)){
     return -1;
   }
@@ -1122,3 +2456,19 @@ int ncdirect_fg(ncdirect* nc, unsigned rgb){
   nc->fgrgb = rgb;
   return 0;
 }
+
+int ncdirect_bg(ncdirect* nc, unsigned rgb){
+  if(ncdirect_bg_stage(nc, rgb)){
+    fbuf_reset(&nc->f);
+    return -1;
+  }
+  return fbuf_flush(&nc->f, nc->ttyfp);
+}
+
+int ncdirect_fg(ncdirect* nc, unsigned rgb){
+  if(ncdirect_fg_stage(nc, rgb)){
+    fbuf_reset(&nc->f);
+    return -1;
+  }
+  return fbuf_flush(&nc->f, nc->ttyfp);
+}
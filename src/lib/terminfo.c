@@ -43,6 +43,125 @@ int terminfostr(char** gseq, const char* name){
   return 0;
 }
 
+void estemplate_compile(estemplate* t, const char* cap){
+  memset(t, 0, sizeof(*t));
+  if(cap == NULL){
+    return;
+  }
+  // we need only model enough of the stack to support a parameter adjusted by
+  // a constant, i.e. "%p1%{1}%+%d". each entry is either a parameter (with its
+  // accumulated delta) or a constant.
+  struct {
+    bool isparam;
+    int param;
+    int val;
+  } stack[2];
+  int depth = 0;
+  int incr[2] = { 0, 0 }; // %i adds one to the first two parameters
+  size_t litused = 0;
+  int litrun = 0;
+  for(const char* c = cap ; *c ; ++c){
+    char lit = *c;
+    if(*c == '%'){
+      ++c;
+      if(*c == '%'){
+        lit = '%';
+      }else if(*c == 'i'){
+        incr[0] = incr[1] = 1;
+        continue;
+      }else if(*c == 'p' && c[1] >= '1' && c[1] <= '9'){
+        if(depth == 2){
+          return;
+        }
+        int param = *++c - '1';
+        stack[depth].isparam = true;
+        stack[depth].param = param;
+        stack[depth].val = param < 2 ? incr[param] : 0;
+        ++depth;
+        if(param + 1 > t->params){
+          t->params = param + 1;
+        }
+        continue;
+      }else if(*c == '{'){
+        if(depth == 2){
+          return;
+        }
+        char* end;
+        long val = strtol(c + 1, &end, 10);
+        if(*end != '}' || end == c + 1 || val > 1000 || val < -1000){
+          return;
+        }
+        stack[depth].isparam = false;
+        stack[depth].val = val;
+        ++depth;
+        c = end;
+        continue;
+      }else if(*c == '+' || *c == '-'){
+        if(depth != 2 || !stack[0].isparam || stack[1].isparam){
+          return;
+        }
+        stack[0].val += *c == '+' ? stack[1].val : -stack[1].val;
+        depth = 1;
+        continue;
+      }else if(*c == 'd' || *c == 'c'){
+        if(depth != 1 || !stack[0].isparam || t->slots == ESTEMPLATE_SLOTS ||
+           stack[0].val > SCHAR_MAX || stack[0].val < SCHAR_MIN){
+          return;
+        }
+        esslot* s = &t->slot[t->slots];
+        s->param = stack[0].param;
+        s->delta = stack[0].val;
+        s->chr = *c == 'c';
+        t->litlen[t->slots++] = litrun;
+        litrun = 0;
+        depth = 0;
+        continue;
+      }else{
+        return; // conditionals, other formats, etc.
+      }
+    }
+    if(litused == sizeof(t->lit)){
+      return;
+    }
+    t->lit[litused++] = lit;
+    ++litrun;
+  }
+  if(depth){
+    return;
+  }
+  t->litlen[t->slots] = litrun;
+  t->valid = true;
+}
+
+void estable_fill(estable* table, const char* cap, int count){
+  memset(table, 0, sizeof(*table));
+  if(cap == NULL){
+    return;
+  }
+  if(count > ESTABLE_ENTRIES){
+    count = ESTABLE_ENTRIES;
+  }
+  for(int i = 0 ; i < count ; ++i){
+    const char* seq = tiparm(cap, i);
+    if(seq){
+      size_t len = strlen(seq);
+      if(len && len <= sizeof(*table->seq)){
+        memcpy(table->seq[i], seq, len);
+        table->len[i] = len;
+      }
+    }
+  }
+}
+
+// compile 'cap', which we'll always supply with 'params' parameters
+static void
+compile_cap(estemplate* t, const char* cap, int params){
+  estemplate_compile(t, cap);
+  if(t->params > params){
+    t->valid = false;
+  }
+}
+
 int interrogate_terminfo(tinfo* ti){
   memset(ti, 0, sizeof(*ti));
   ti->RGBflag = query_rgb();
@@ -92,6 +211,22 @@ int interrogate_terminfo(tinfo* ti){
   terminfostr(&ti->clearscr, "clear");// clear screen, home cursor
   terminfostr(&ti->cleareol, "el");   // clear to end of line
   terminfostr(&ti->clearbol, "el1");  // clear to beginning of line
+  terminfostr(&ti->ech, "ech");       // erase N characters
+  terminfostr(&ti->rep, "rep");       // repeat a character N times
+  terminfostr(&ti->csr, "csr");       // change scrolling region
+  terminfostr(&ti->ind, "ind");       // scroll up one row
+  terminfostr(&ti->indn, "indn");     // scroll up N rows
+  ti->BCEflag = tigetflag("bce") == 1;
+  // if sgr0 is (or contains) an ECMA-48 SGR, assume that the other attribute
+  // escapes are too, and that adjacent ones can be merged into one
+  if(ti->sgr0){
+    for(const char* c = ti->sgr0 ; *c ; ++c){
+      if(sgr_len(c, strlen(c))){
+        ti->sgrmerge = true;
+        break;
+      }
+    }
+  }
   terminfostr(&ti->cuu, "cuu"); // move N up
   terminfostr(&ti->cud, "cud"); // move N down
   terminfostr(&ti->hpa, "hpa"); // set horizontal position
@@ -100,6 +235,7 @@ int interrogate_terminfo(tinfo* ti){
   terminfostr(&ti->cub, "cub"); // n non-destructive backspaces
   terminfostr(&ti->cuf1, "cuf1"); // non-destructive space
   terminfostr(&ti->cub1, "cub1"); // non-destructive backspace
+  terminfostr(&ti->cr, "cr");     // carriage return
   // Some terminals cannot combine certain styles with colors. Don't advertise
   // support for the style in that case.
   int nocolor_stylemask = tigetnum("ncv");
@@ -126,18 +262,51 @@ int interrogate_terminfo(tinfo* ti){
       ti->italics = NULL;
     }
   }
+  // synchronized updates are described by the extended "Sync" capability,
+  // taking 1 to begin and 2 to end an update. where it's missing, we use DEC
+  // private mode 2026, which is (harmlessly) ignored if unsupported.
+  strcpy(ti->bsu, "\x1b[?2026h");
+  strcpy(ti->esu, "\x1b[?2026l");
+  char* sync;
+  if(terminfostr(&sync, "Sync") == 0){
+    char bsu[sizeof(ti->bsu)];
+    const char* seq = tiparm(sync, 1);
+    if(seq && strlen(seq) < sizeof(bsu)){
+      strcpy(bsu, seq);
+      if((seq = tiparm(sync, 2)) && strlen(seq) < sizeof(ti->esu)){
+        strcpy(ti->bsu, bsu);
+        strcpy(ti->esu, seq);
+      }
+    }
+  }
   terminfostr(&ti->getm, "getm"); // get mouse events
   // Not all terminals support setting the fore/background independently
   terminfostr(&ti->setaf, "setaf"); // set forground color
   terminfostr(&ti->setab, "setab"); // set background color
   terminfostr(&ti->smkx, "smkx");   // enable keypad transmit
   terminfostr(&ti->rmkx, "rmkx");   // disable keypad transmit
-  // if the keypad neen't be explicitly enabled, smkx is not present
-  if(ti->smkx){
-    if(putp(tiparm(ti->smkx)) != OK){
-      fprintf(stderr, "Error entering keypad transmit mode\n");
-      return -1;
-    }
+  // precompile the parameterized capabilities we emit while rendering, so
+  // that tiparm() needn't interpret them each time.
+  compile_cap(&ti->cupt, ti->cup, 2);
+  compile_cap(&ti->cuut, ti->cuu, 1);
+  compile_cap(&ti->cudt, ti->cud, 1);
+  compile_cap(&ti->cuft, ti->cuf, 1);
+  compile_cap(&ti->cubt, ti->cub, 1);
+  compile_cap(&ti->hpat, ti->hpa, 1);
+  compile_cap(&ti->vpat, ti->vpa, 1);
+  compile_cap(&ti->echt, ti->ech, 1);
+  compile_cap(&ti->rept, ti->rep, 2);
+  compile_cap(&ti->initct, ti->initc, 4);
+  compile_cap(&ti->setaft, ti->setaf, 1);
+  compile_cap(&ti->setabt, ti->setab, 1);
+  // setaf and setab are frequently conditional (so as to use the 16 ANSI
+  // colors where possible), and can't be compiled. they're only ever used
+  // with palette indices, though, so expand them all up front.
+  if(!ti->setaft.valid){
+    estable_fill(&ti->setafs, ti->setaf, ti->colors);
+  }
+  if(!ti->setabt.valid){
+    estable_fill(&ti->setabs, ti->setab, ti->colors);
   }
   return 0;
 }
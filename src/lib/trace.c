@@ -0,0 +1,761 @@
+#include <limits.h>
+#include <stdint.h>
+#include "internal.h"
+
+// types of records (see trace.h)
+enum {
+  TRACE_CREATE = 1, // id, bound-to id + 1 (0 if unbound), rows, cols, y, x
+  TRACE_DESTROY,    // id
+  TRACE_MOVE,       // id, y, x
+  TRACE_RESIZE,     // id, keepy, keepx, keepleny, keeplenx, yoff, xoff, ylen, xlen
+  TRACE_ABOVE,      // id, id of the plane it's moved above
+  TRACE_BELOW,      // id, id of the plane it's moved below
+  TRACE_TOP,        // id
+  TRACE_BOTTOM,     // id
+  TRACE_REPARENT,   // id, new parent's id + 1 (0 if unbound)
+  TRACE_ERASE,      // id
+  TRACE_BASE,       // id, attrword, channels, EGC
+  TRACE_SCROLLING,  // id, scrolling
+  TRACE_CURSOR,     // id, y, x
+  TRACE_PEN,        // id, attrword, channels
+  TRACE_PUTC,       // id, y, x, EGC (styled by the pen)
+  TRACE_PUTEGC,     // id, y, x, EGC
+  TRACE_CELLS,      // id, y, x, leny, lenx, then per cell attrword, channels, EGC
+  TRACE_RENDER,     // rows, cols of the standard plane following the render
+};
+
+static uint64_t
+trace_now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return timespec_to_ns(&ts);
+}
+
+static void
+put_uvarint(nctrace* t, uint64_t v){
+  do{
+    unsigned char b = v & 0x7fu;
+    if(v >>= 7u){
+      b |= 0x80u;
+    }
+    if(fbuf_putc(&t->f, b)){
+      t->failed = true;
+    }
+  }while(v);
+}
+
+static void
+put_svarint(nctrace* t, int64_t v){
+  put_uvarint(t, ((uint64_t)v << 1u) ^ (uint64_t)(v >> 63));
+}
+
+static void
+put_egc(nctrace* t, const char* egc, size_t len){
+  put_uvarint(t, len);
+  if(fbuf_putn(&t->f, egc, len)){
+    t->failed = true;
+  }
+}
+
+// write the EGC of 'c', which is backed by 'n'
+static void
+put_cell_egc(nctrace* t, const ncplane* n, const cell* c){
+  if(cell_simple_p(c)){
+    char egc[CELL_INLINE_BYTES + 1];
+    put_egc(t, egc, cell_simple_egc(c, egc));
+  }else{
+    const char* egc = egcpool_extended_gcluster(&n->pool, c);
+    put_egc(t, egc, strlen(egc));
+  }
+}
+
+// lock the trace, returning NULL (and leaving it unlocked) if we've already
+// failed, and thus given up recording.
+static nctrace*
+trace_lock(const notcurses* nc){
+  nctrace* t = nc->trace;
+  pthread_mutex_lock(&t->lock);
+  if(t->failed){
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+  }
+  return t;
+}
+
+static void
+trace_unlock(nctrace* t){
+  pthread_mutex_unlock(&t->lock);
+}
+
+// begin a record of 'type' concerning 'n' (if not NULL). the lock is held.
+static void
+record(nctrace* t, unsigned type, const ncplane* n){
+  const uint64_t now = trace_now();
+  if(fbuf_putc(&t->f, type)){
+    t->failed = true;
+  }
+  put_uvarint(t, now - t->lastns);
+  t->lastns = now;
+  if(n){
+    put_uvarint(t, n->traceid);
+  }
+}
+
+// a plane's identifier, plus one, or 0 for NULL
+static inline uint64_t
+plane_ref(const ncplane* n){
+  return n ? n->traceid + 1ull : 0;
+}
+
+// a put is about to be made to 'n' using the specified styling. if the
+// replay's cursor or pen would differ, record them first.
+static void
+record_put_state(nctrace* t, ncplane* n, uint32_t attrword, uint64_t channels){
+  if(n->y != n->tracey || n->x != n->tracex){
+    record(t, TRACE_CURSOR, n);
+    put_svarint(t, n->y);
+    put_svarint(t, n->x);
+    n->tracey = n->y;
+    n->tracex = n->x;
+  }
+  if(attrword != n->traceattr || channels != n->tracechannels){
+    record(t, TRACE_PEN, n);
+    put_uvarint(t, attrword);
+    put_uvarint(t, channels);
+    n->traceattr = attrword;
+    n->tracechannels = channels;
+  }
+}
+
+int trace_start(notcurses* nc, const char* path){
+  nctrace* t = malloc(sizeof(*t));
+  if(t == NULL){
+    return -1;
+  }
+  memset(t, 0, sizeof(*t));
+  if((t->fp = fopen(path, "wb")) == NULL){
+    fprintf(stderr, "Couldn't open trace %s (%s)\n", path, strerror(errno));
+    free(t);
+    return -1;
+  }
+  if(pthread_mutex_init(&t->lock, NULL)){
+    fclose(t->fp);
+    free(t);
+    return -1;
+  }
+  t->lastns = trace_now();
+  t->nextid = 1;
+  nc->stdplane->traceid = 0;
+  if(fbuf_putn(&t->f, NCTRACE_MAGIC, strlen(NCTRACE_MAGIC)) ||
+     fbuf_putc(&t->f, NCTRACE_VERSION)){
+    t->failed = true;
+  }
+  put_uvarint(t, nc->stdplane->leny);
+  put_uvarint(t, nc->stdplane->lenx);
+  nc->trace = t;
+  return 0;
+}
+
+int trace_stop(notcurses* nc){
+  nctrace* t = nc->trace;
+  if(t == NULL){
+    return 0;
+  }
+  int ret = 0;
+  if(t->failed){
+    fprintf(stderr, "Trace is incomplete (ran out of memory?)\n");
+    ret = -1;
+  }
+  if(fbuf_flush(&t->f, t->fp)){
+    ret = -1;
+  }
+  if(fclose(t->fp)){
+    ret = -1;
+  }
+  fbuf_free(&t->f);
+  pthread_mutex_destroy(&t->lock);
+  free(t);
+  nc->trace = NULL;
+  return ret;
+}
+
+void trace_create(ncplane* n, const ncplane* boundto, int yoff, int xoff){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    n->traceid = t->nextid++;
+    record(t, TRACE_CREATE, n);
+    put_uvarint(t, plane_ref(boundto));
+    put_uvarint(t, n->leny);
+    put_uvarint(t, n->lenx);
+    put_svarint(t, yoff);
+    put_svarint(t, xoff);
+    trace_unlock(t);
+  }
+}
+
+// records consisting only of the plane
+static void
+trace_plane(ncplane* n, unsigned type){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, type, n);
+    trace_unlock(t);
+  }
+}
+
+void trace_destroy(ncplane* n){
+  trace_plane(n, TRACE_DESTROY);
+}
+
+void trace_top(ncplane* n){
+  trace_plane(n, TRACE_TOP);
+}
+
+void trace_bottom(ncplane* n){
+  trace_plane(n, TRACE_BOTTOM);
+}
+
+// the replay's cursor is moved by the operation, so we no longer know where it
+// lies relative to ours. force a CURSOR record before the next put.
+static inline void
+trace_lose_cursor(ncplane* n){
+  n->tracey = n->tracex = -1;
+}
+
+void trace_erase(ncplane* n){
+  trace_plane(n, TRACE_ERASE);
+  trace_lose_cursor(n);
+}
+
+void trace_move(ncplane* n, int y, int x){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, TRACE_MOVE, n);
+    put_svarint(t, y);
+    put_svarint(t, x);
+    trace_unlock(t);
+  }
+}
+
+void trace_resize(ncplane* n, int keepy, int keepx, int keepleny,
+                  int keeplenx, int yoff, int xoff, int ylen, int xlen){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, TRACE_RESIZE, n);
+    put_svarint(t, keepy);
+    put_svarint(t, keepx);
+    put_svarint(t, keepleny);
+    put_svarint(t, keeplenx);
+    put_svarint(t, yoff);
+    put_svarint(t, xoff);
+    put_svarint(t, ylen);
+    put_svarint(t, xlen);
+    trace_unlock(t);
+  }
+  trace_lose_cursor(n);
+}
+
+static void
+trace_relative(ncplane* n, unsigned type, const ncplane* other){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, type, n);
+    put_uvarint(t, plane_ref(other));
+    trace_unlock(t);
+  }
+}
+
+void trace_above(ncplane* n, const ncplane* above){
+  trace_relative(n, TRACE_ABOVE, above);
+}
+
+void trace_below(ncplane* n, const ncplane* below){
+  trace_relative(n, TRACE_BELOW, below);
+}
+
+void trace_reparent(ncplane* n, const ncplane* newparent){
+  trace_relative(n, TRACE_REPARENT, newparent);
+}
+
+void trace_base(ncplane* n){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, TRACE_BASE, n);
+    put_uvarint(t, n->basecell.attrword);
+    put_uvarint(t, n->basecell.channels);
+    put_cell_egc(t, n, &n->basecell);
+    trace_unlock(t);
+  }
+}
+
+void trace_scrolling(ncplane* n, bool scrollp){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, TRACE_SCROLLING, n);
+    put_uvarint(t, scrollp);
+    trace_unlock(t);
+  }
+}
+
+void trace_putc(ncplane* n, int y, int x, const cell* c){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record_put_state(t, n, c->attrword, c->channels);
+    record(t, TRACE_PUTC, n);
+    put_svarint(t, y);
+    put_svarint(t, x);
+    put_cell_egc(t, n, c);
+    trace_unlock(t);
+  }
+}
+
+void trace_putegc(ncplane* n, int y, int x, const char* egc, int bytes){
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record_put_state(t, n, n->attrword, n->channels);
+    record(t, TRACE_PUTEGC, n);
+    put_svarint(t, y);
+    put_svarint(t, x);
+    put_egc(t, egc, bytes);
+    trace_unlock(t);
+  }
+}
+
+void trace_cells(ncplane* n, int y, int x, int leny, int lenx){
+  if(y < 0){
+    y = 0;
+  }
+  if(x < 0){
+    x = 0;
+  }
+  if(leny < 0 || y + leny > n->leny){
+    leny = n->leny - y;
+  }
+  if(lenx < 0 || x + lenx > n->lenx){
+    lenx = n->lenx - x;
+  }
+  if(leny <= 0 || lenx <= 0){
+    return;
+  }
+  nctrace* t = trace_lock(n->nc);
+  if(t){
+    record(t, TRACE_CELLS, n);
+    put_uvarint(t, y);
+    put_uvarint(t, x);
+    put_uvarint(t, leny);
+    put_uvarint(t, lenx);
+    for(int yy = y ; yy < y + leny ; ++yy){
+      for(int xx = x ; xx < x + lenx ; ++xx){
+        const cell* c = &ncplane_row(n, yy)[xx];
+        put_uvarint(t, c->attrword);
+        put_uvarint(t, c->channels);
+        put_cell_egc(t, n, c);
+      }
+    }
+    trace_unlock(t);
+  }
+}
+
+void trace_render(notcurses* nc){
+  nctrace* t = trace_lock(nc);
+  if(t){
+    record(t, TRACE_RENDER, NULL);
+    put_uvarint(t, nc->stdplane->leny);
+    put_uvarint(t, nc->stdplane->lenx);
+    // the render might have resized the standard plane
+    trace_lose_cursor(nc->stdplane);
+    // get each frame's records out, in case we never make it to a clean stop
+    if(fbuf_flush(&t->f, t->fp) || fflush(t->fp) == EOF){
+      t->failed = true;
+    }
+    trace_unlock(t);
+  }
+}
+
+// replay state
+typedef struct replayer {
+  notcurses* nc;
+  FILE* fp;
+  ncplane** planes;  // indexed by trace identifier, NULL if destroyed
+  unsigned slots;    // allocated elements of 'planes'
+  char* egc;         // the most recently read EGC, NUL-terminated
+  size_t egcsize;    // bytes allocated for 'egc'
+} replayer;
+
+static int
+get_uvarint(replayer* r, uint64_t* v){
+  *v = 0;
+  for(unsigned shift = 0 ; shift < 64 ; shift += 7){
+    int c = getc(r->fp);
+    if(c == EOF){
+      return -1;
+    }
+    *v |= (uint64_t)(c & 0x7f) << shift;
+    if(!(c & 0x80)){
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// read an unsigned varint which must fit in an int
+static int
+get_uint(replayer* r, int* v){
+  uint64_t u;
+  if(get_uvarint(r, &u) || u > INT_MAX){
+    return -1;
+  }
+  *v = u;
+  return 0;
+}
+
+static int
+get_sint(replayer* r, int* v){
+  uint64_t u;
+  if(get_uvarint(r, &u)){
+    return -1;
+  }
+  int64_t s = (int64_t)(u >> 1u) ^ -(int64_t)(u & 1u);
+  if(s < INT_MIN || s > INT_MAX){
+    return -1;
+  }
+  *v = s;
+  return 0;
+}
+
+static int
+get_egc(replayer* r, size_t* len){
+  uint64_t l;
+  if(get_uvarint(r, &l) || l >= SIZE_MAX / 2){
+    return -1;
+  }
+  if(l + 1 > r->egcsize){
+    char* tmp = realloc(r->egc, l + 1);
+    if(tmp == NULL){
+      return -1;
+    }
+    r->egc = tmp;
+    r->egcsize = l + 1;
+  }
+  if(fread(r->egc, 1, l, r->fp) != l){
+    return -1;
+  }
+  r->egc[l] = '\0';
+  if(len){
+    *len = l;
+  }
+  return 0;
+}
+
+// read a plane reference. with 'plusone', 0 refers to no plane, and '*n'
+// is set to NULL. returns -1 for a plane which doesn't exist. the plane's
+// identifier is written to '*idp', if it is not NULL.
+static int
+get_plane_id(replayer* r, ncplane** n, bool plusone, uint64_t* idp){
+  uint64_t id;
+  if(get_uvarint(r, &id)){
+    return -1;
+  }
+  if(plusone){
+    if(id == 0){
+      *n = NULL;
+      return 0;
+    }
+    --id;
+  }
+  if(id >= r->slots || r->planes[id] == NULL){
+    return -1;
+  }
+  *n = r->planes[id];
+  if(idp){
+    *idp = id;
+  }
+  return 0;
+}
+
+static inline int
+get_plane(replayer* r, ncplane** n, bool plusone){
+  return get_plane_id(r, n, plusone, NULL);
+}
+
+// load the cell 'c' of 'n' from the most recently read EGC and the styling
+static int
+replay_cell(replayer* r, ncplane* n, cell* c, uint32_t attrword, uint64_t channels){
+  cell_release(n, c);
+  c->gcluster = 0;
+  if(cell_load(n, c, r->egc) < 0){
+    return -1;
+  }
+  c->attrword = attrword;
+  c->channels = channels;
+  return 0;
+}
+
+// read styling, and load the most recently read EGC into 'c' with it
+static int
+get_cell(replayer* r, ncplane* n, cell* c){
+  uint64_t attrword, channels;
+  if(get_uvarint(r, &attrword) || attrword > UINT32_MAX ||
+     get_uvarint(r, &channels) || get_egc(r, NULL)){
+    return -1;
+  }
+  return replay_cell(r, n, c, attrword, channels);
+}
+
+// adopt the recorded geometry of the standard plane, if we're headless
+static int
+replay_geometry(replayer* r, int rows, int cols){
+  notcurses* nc = r->nc;
+  if(nc->vscreen == NULL){
+    return 0;
+  }
+  rows += nc->margin_t + nc->margin_b;
+  cols += nc->margin_l + nc->margin_r;
+  if(rows == nc->vscreen->dimy && cols == nc->vscreen->dimx){
+    return 0;
+  }
+  return notcurses_headless_resize(nc, rows, cols);
+}
+
+static int
+replay_create(replayer* r){
+  uint64_t id;
+  ncplane* boundto;
+  int rows, cols, yoff, xoff;
+  if(get_uvarint(r, &id) || id == 0 || id >= UINT_MAX ||
+     get_plane(r, &boundto, true) || get_uint(r, &rows) ||
+     get_uint(r, &cols) || get_sint(r, &yoff) || get_sint(r, &xoff)){
+    return -1;
+  }
+  if(id >= r->slots){
+    unsigned slots = r->slots * 2;
+    if(slots <= id){
+      slots = id + 1;
+    }
+    ncplane** tmp = realloc(r->planes, sizeof(*r->planes) * slots);
+    if(tmp == NULL){
+      return -1;
+    }
+    memset(tmp + r->slots, 0, sizeof(*tmp) * (slots - r->slots));
+    r->planes = tmp;
+    r->slots = slots;
+  }
+  if(r->planes[id]){
+    return -1;
+  }
+  if((r->planes[id] = ncplane_create(r->nc, boundto, rows, cols, yoff, xoff,
+                                     NULL, NULL, false)) == NULL){
+    return -1;
+  }
+  return 0;
+}
+
+static int
+replay_cells(replayer* r, ncplane* n){
+  int y, x, leny, lenx;
+  if(get_uint(r, &y) || get_uint(r, &x) || get_uint(r, &leny) ||
+     get_uint(r, &lenx) || y + leny > n->leny || x + lenx > n->lenx){
+    return -1;
+  }
+  for(int yy = y ; yy < y + leny ; ++yy){
+    cell* row = ncplane_row_writable(n, yy);
+    if(row == NULL){
+      return -1;
+    }
+    for(int xx = x ; xx < x + lenx ; ++xx){
+      if(get_cell(r, n, &row[xx])){
+        return -1;
+      }
+    }
+  }
+  ncplane_dirty_rows(n, y, leny);
+  return 0;
+}
+
+// replay the record of 'type' concerning 'n', identified in the trace by
+// 'id'. the results of the operations are ignored, as they ought match those
+// of the recording.
+static int
+replay_plane_record(replayer* r, int type, ncplane* n, uint64_t id){
+  int y, x;
+  ncplane* other;
+  switch(type){
+    case TRACE_DESTROY:
+      if(ncplane_destroy(n) == 0){
+        r->planes[id] = NULL;
+      }
+      break;
+    case TRACE_MOVE:
+      if(get_sint(r, &y) || get_sint(r, &x)){
+        return -1;
+      }
+      ncplane_move_yx(n, y, x);
+      break;
+    case TRACE_RESIZE:{
+      int args[8];
+      for(size_t i = 0 ; i < sizeof(args) / sizeof(*args) ; ++i){
+        if(get_sint(r, &args[i])){
+          return -1;
+        }
+      }
+      ncplane_resize(n, args[0], args[1], args[2], args[3],
+                     args[4], args[5], args[6], args[7]);
+      break;
+    }case TRACE_ABOVE:
+      if(get_plane(r, &other, false)){
+        return -1;
+      }
+      ncplane_move_above(n, other);
+      break;
+    case TRACE_BELOW:
+      if(get_plane(r, &other, false)){
+        return -1;
+      }
+      ncplane_move_below(n, other);
+      break;
+    case TRACE_TOP:
+      ncplane_move_top(n);
+      break;
+    case TRACE_BOTTOM:
+      ncplane_move_bottom(n);
+      break;
+    case TRACE_REPARENT:
+      if(get_plane(r, &other, true)){
+        return -1;
+      }
+      ncplane_reparent(n, other);
+      break;
+    case TRACE_ERASE:
+      ncplane_erase(n);
+      break;
+    case TRACE_BASE:
+      if(get_cell(r, n, &n->basecell)){
+        return -1;
+      }
+      ncplane_dirty(n);
+      break;
+    case TRACE_SCROLLING:{
+      uint64_t scrollp;
+      if(get_uvarint(r, &scrollp)){
+        return -1;
+      }
+      ncplane_set_scrolling(n, scrollp);
+      break;
+    }case TRACE_CURSOR:
+      if(get_sint(r, &y) || get_sint(r, &x) ||
+         y < 0 || y > n->leny || x < 0 || x > n->lenx){
+        return -1;
+      }
+      n->y = y;
+      n->x = x;
+      break;
+    case TRACE_PEN:{
+      uint64_t attrword, channels;
+      if(get_uvarint(r, &attrword) || attrword > UINT32_MAX ||
+         get_uvarint(r, &channels)){
+        return -1;
+      }
+      n->attrword = attrword;
+      n->channels = channels;
+      break;
+    }case TRACE_PUTC:{
+      if(get_sint(r, &y) || get_sint(r, &x) || get_egc(r, NULL)){
+        return -1;
+      }
+      cell c = CELL_TRIVIAL_INITIALIZER;
+      if(replay_cell(r, n, &c, n->attrword, n->channels)){
+        return -1;
+      }
+      ncplane_putc_yx(n, y, x, &c);
+      cell_release(n, &c);
+      break;
+    }case TRACE_PUTEGC:{
+      size_t len;
+      if(get_sint(r, &y) || get_sint(r, &x) || get_egc(r, &len)){
+        return -1;
+      }
+      ncplane_putegc_yx(n, y, x, r->egc, NULL);
+      break;
+    }case TRACE_CELLS:
+      return replay_cells(r, n);
+    default:
+      return -1;
+  }
+  return 0;
+}
+
+int notcurses_replay(notcurses* nc, FILE* fp, bool realtime){
+  char magic[sizeof(NCTRACE_MAGIC)];
+  if(fread(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+     memcmp(magic, NCTRACE_MAGIC, strlen(NCTRACE_MAGIC)) ||
+     magic[sizeof(magic) - 1] != NCTRACE_VERSION){
+    logerror(nc, "Not a notcurses trace\n");
+    return -1;
+  }
+  replayer r = {
+    .nc = nc,
+    .fp = fp,
+  };
+  int frames = -1;
+  int rows, cols;
+  if(get_uint(&r, &rows) || get_uint(&r, &cols)){
+    goto done;
+  }
+  if((r.planes = malloc(sizeof(*r.planes))) == NULL){
+    goto done;
+  }
+  r.planes[0] = nc->stdplane;
+  r.slots = 1;
+  // the standard plane is only resized during rendering, so refresh to have
+  // it take the recorded geometry from the outset
+  if(replay_geometry(&r, rows, cols) || (nc->vscreen &&
+     notcurses_refresh(nc, NULL, NULL))){
+    goto done;
+  }
+  const uint64_t startns = trace_now();
+  uint64_t tracens = 0;
+  int rendered = 0;
+  int type;
+  while((type = getc(fp)) != EOF){
+    uint64_t delta;
+    if(get_uvarint(&r, &delta)){
+      goto done;
+    }
+    tracens += delta;
+    if(type == TRACE_CREATE){
+      if(replay_create(&r)){
+        goto done;
+      }
+    }else if(type == TRACE_RENDER){
+      if(get_uint(&r, &rows) || get_uint(&r, &cols) ||
+         replay_geometry(&r, rows, cols)){
+        goto done;
+      }
+      if(realtime){
+        struct timespec ts;
+        ns_to_timespec(startns + tracens, &ts);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+      }
+      if(notcurses_render(nc)){
+        goto done;
+      }
+      ++rendered;
+    }else{
+      ncplane* n;
+      uint64_t id;
+      if(get_plane_id(&r, &n, false, &id) ||
+         replay_plane_record(&r, type, n, id)){
+        goto done;
+      }
+    }
+  }
+  frames = rendered;
+
+done:
+  if(frames < 0){
+    logerror(nc, "Malformed trace\n");
+  }
+  free(r.planes);
+  free(r.egc);
+  return frames;
+}
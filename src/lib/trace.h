@@ -0,0 +1,83 @@
+#ifndef NOTCURSES_TRACE
+#define NOTCURSES_TRACE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "notcurses/notcurses.h"
+#include "fbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// recording of the calls which modify planes, for later replay with
+// notcurses_replay(). recording is enabled by naming a file in the
+// NOTCURSES_TRACE environment variable at notcurses_init() time.
+//
+// the trace begins with the magic "nctrace", a version byte, and the geometry
+// of the standard plane. it is followed by records, each a type byte, the
+// nanoseconds elapsed since the previous record, and the type's arguments.
+// integers are LEB128 varints (signed ones zigzagged), and EGCs are a varint
+// length followed by that many bytes. planes are identified by numbers
+// assigned as they're created, the standard plane being 0.
+//
+// puts are recorded at the two points through which all of them flow,
+// ncplane_putc_yx() and ncplane_putegc_yx(). the plane's cursor and styling
+// are only recorded when they differ from what the replay will have. writes
+// made directly to a plane's framebuffer (blits, fills, merges, rotations,
+// duplications, and fades) are recorded as a snapshot of the affected cells.
+// palette changes are not recorded.
+
+#define NCTRACE_MAGIC "nctrace"
+#define NCTRACE_VERSION 1
+
+typedef struct nctrace {
+  FILE* fp;
+  fbuf f;                // records not yet written to 'fp'
+  pthread_mutex_t lock;  // guards everything here
+  uint64_t lastns;       // monotonic time of the most recent record
+  unsigned nextid;       // assigned to the next plane created
+  bool failed;           // a record couldn't be written; we've stopped
+} nctrace;
+
+struct ncplane;
+struct notcurses;
+
+// start recording to 'path', the standard plane having been created
+int trace_start(struct notcurses* nc, const char* path);
+
+// flush outstanding records, and stop recording. returns -1 if the trace
+// could not be completely written.
+int trace_stop(struct notcurses* nc);
+
+// hooks for each recorded operation. these must only be called on planes
+// for which ncplane_traced() is true.
+void trace_create(struct ncplane* n, const struct ncplane* boundto,
+                  int yoff, int xoff);
+void trace_destroy(struct ncplane* n);
+void trace_move(struct ncplane* n, int y, int x);
+void trace_resize(struct ncplane* n, int keepy, int keepx, int keepleny,
+                  int keeplenx, int yoff, int xoff, int ylen, int xlen);
+void trace_above(struct ncplane* n, const struct ncplane* above);
+void trace_below(struct ncplane* n, const struct ncplane* below);
+void trace_top(struct ncplane* n);
+void trace_bottom(struct ncplane* n);
+void trace_reparent(struct ncplane* n, const struct ncplane* newparent);
+void trace_erase(struct ncplane* n);
+void trace_base(struct ncplane* n);
+void trace_scrolling(struct ncplane* n, bool scrollp);
+void trace_putc(struct ncplane* n, int y, int x, const cell* c);
+void trace_putegc(struct ncplane* n, int y, int x, const char* egc, int bytes);
+// snapshot the cells of the 'leny'x'lenx' region at 'y', 'x', clipped to the
+// plane. -1 for a length means through the end of the plane.
+void trace_cells(struct ncplane* n, int y, int x, int leny, int lenx);
+// record a render, and flush the records
+void trace_render(struct notcurses* nc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
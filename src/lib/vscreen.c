@@ -0,0 +1,701 @@
+#include "internal.h"
+
+// parser states
+enum {
+  VS_GROUND,     // printing glyphs and executing controls
+  VS_ESC,        // got ESC
+  VS_CSI,        // collecting a CSI's parameter and intermediate bytes
+  VS_CHARSET,    // got a designation (e.g. ESC '('); one more byte follows
+  VS_OSC,        // operating system command, terminated by BEL or ST
+  VS_STRING,     // DCS, SOS, PM, or APC, terminated by ST
+  VS_STRINGESC,  // got ESC within a string; '\\' completes ST
+  VS_LINUXPAL,   // Linux console palette OSC ("ESC ] P nrrggbb")
+};
+
+// an erased cell is a space with no styles, taking the current background
+// (as do terminals with 'bce'). any EGC it held must already be released.
+static inline void
+vscreen_blank(const vscreen* vs, cell* c){
+  c->gcluster = ' ';
+  c->attrword = vs->pen.attrword & 0x000000ffu; // background palette index
+  c->channels = vs->pen.channels & 0x00000000ffffffffull;
+}
+
+// blank a row whose EGCs have been moved elsewhere (or released)
+static void
+vscreen_blankrow(vscreen* vs, int y){
+  for(int x = 0 ; x < vs->dimx ; ++x){
+    vscreen_blank(vs, &vs->cells[y * vs->dimx + x]);
+  }
+}
+
+// cells [x0, x1) of row 'y' are about to be overwritten. a wide glyph can't
+// be half overwritten, so any straddling either boundary loses its other half.
+static void
+vscreen_unwiden(vscreen* vs, int y, int x0, int x1){
+  cell* row = &vs->cells[y * vs->dimx];
+  if(x0 > 0 && cell_wide_right_p(&row[x0])){
+    pool_release(&vs->pool, &row[x0 - 1]);
+    row[x0 - 1].gcluster = ' ';
+    row[x0 - 1].channels &= ~CELL_WIDEASIAN_MASK;
+  }
+  if(x1 < vs->dimx && cell_wide_right_p(&row[x1])){
+    row[x1].gcluster = ' ';
+    row[x1].channels &= ~CELL_WIDEASIAN_MASK;
+  }
+}
+
+// erase cells [x0, x1) of row 'y'
+static void
+vscreen_erase(vscreen* vs, int y, int x0, int x1){
+  if(x0 < 0){
+    x0 = 0;
+  }
+  if(x1 > vs->dimx){
+    x1 = vs->dimx;
+  }
+  if(x0 >= x1){
+    return;
+  }
+  vscreen_unwiden(vs, y, x0, x1);
+  for(int x = x0 ; x < x1 ; ++x){
+    cell* c = &vs->cells[y * vs->dimx + x];
+    pool_release(&vs->pool, c);
+    vscreen_blank(vs, c);
+  }
+}
+
+// scroll rows [top, bottom] up by 'n' rows (down, if 'n' is negative),
+// blanking those exposed
+static void
+vscreen_scroll(vscreen* vs, int top, int bottom, int n){
+  const int rows = bottom - top + 1;
+  if(n > rows){
+    n = rows;
+  }else if(n < -rows){
+    n = -rows;
+  }
+  const size_t rowbytes = sizeof(*vs->cells) * vs->dimx;
+  if(n > 0){
+    for(int y = top ; y < top + n ; ++y){
+      vscreen_erase(vs, y, 0, vs->dimx);
+    }
+    memmove(&vs->cells[top * vs->dimx], &vs->cells[(top + n) * vs->dimx],
+            rowbytes * (rows - n));
+    for(int y = bottom - n + 1 ; y <= bottom ; ++y){
+      vscreen_blankrow(vs, y);
+    }
+  }else if(n < 0){
+    n = -n;
+    for(int y = bottom - n + 1 ; y <= bottom ; ++y){
+      vscreen_erase(vs, y, 0, vs->dimx);
+    }
+    memmove(&vs->cells[(top + n) * vs->dimx], &vs->cells[top * vs->dimx],
+            rowbytes * (rows - n));
+    for(int y = top ; y < top + n ; ++y){
+      vscreen_blankrow(vs, y);
+    }
+  }
+}
+
+static void
+vscreen_goto(vscreen* vs, int y, int x){
+  if(y < 0){
+    y = 0;
+  }else if(y >= vs->dimy){
+    y = vs->dimy - 1;
+  }
+  if(x < 0){
+    x = 0;
+  }else if(x >= vs->dimx){
+    x = vs->dimx - 1;
+  }
+  vs->y = y;
+  vs->x = x;
+  vs->wrapnext = false;
+}
+
+// move down a row, scrolling if we're at the bottom of the scrolling region
+static void
+vscreen_linefeed(vscreen* vs){
+  if(vs->y == vs->bottom){
+    vscreen_scroll(vs, vs->top, vs->bottom, 1);
+  }else if(vs->y < vs->dimy - 1){
+    ++vs->y;
+  }
+  vs->wrapnext = false;
+}
+
+// move up a row, scrolling if we're at the top of the scrolling region
+static void
+vscreen_revindex(vscreen* vs){
+  if(vs->y == vs->top){
+    vscreen_scroll(vs, vs->top, vs->bottom, -1);
+  }else if(vs->y > 0){
+    --vs->y;
+  }
+  vs->wrapnext = false;
+}
+
+// load 'len' bytes of 'egc' into 'c', which holds no EGC
+static int
+vscreen_stash(vscreen* vs, cell* c, const char* egc, size_t len){
+  if(egc_inlinable_p(egc, len)){
+    c->gcluster = egc_inline(egc, len);
+    return 0;
+  }
+  int eoffset = egcpool_stash(&vs->pool, egc, len);
+  if(eoffset < 0){
+    c->gcluster = ' ';
+    return -1;
+  }
+  c->gcluster = egcpool_gcluster(eoffset);
+  return 0;
+}
+
+// print an EGC occupying 'cols' (1 or 2) columns at the cursor, wrapping
+// first if a previous glyph filled the line, or if this one doesn't fit
+static void
+vscreen_print(vscreen* vs, const char* egc, size_t len, int cols){
+  if(cols > vs->dimx || len >= sizeof(vs->last)){
+    return;
+  }
+  if(vs->wrapnext || vs->x + cols > vs->dimx){
+    vs->x = 0;
+    vscreen_linefeed(vs);
+  }
+  cell* c = &vs->cells[vs->y * vs->dimx + vs->x];
+  vscreen_unwiden(vs, vs->y, vs->x, vs->x + cols);
+  for(int i = 0 ; i < cols ; ++i){
+    pool_release(&vs->pool, &c[i]);
+  }
+  vscreen_stash(vs, c, egc, len);
+  c->attrword = vs->pen.attrword;
+  c->channels = vs->pen.channels;
+  if(cols == 2){
+    cell_set_wide(c);
+    c[1].gcluster = 0;
+    c[1].attrword = c->attrword;
+    c[1].channels = c->channels;
+  }
+  if(egc != vs->last){
+    memcpy(vs->last, egc, len);
+    vs->last[len] = '\0';
+    vs->lastcols = cols;
+  }
+  if((vs->x += cols) >= vs->dimx){
+    vs->x = vs->dimx - 1;
+    vs->wrapnext = true;
+  }
+}
+
+// append a zero-width code point to the glyph preceding the cursor
+static void
+vscreen_join(vscreen* vs, const char* u, size_t len){
+  int x = vs->wrapnext ? vs->x : vs->x - 1;
+  if(x < 0){
+    return;
+  }
+  cell* c = &vs->cells[vs->y * vs->dimx + x];
+  if(cell_wide_right_p(c) && x > 0){
+    --c;
+  }
+  char egc[VSCREEN_EGCMAX];
+  size_t elen;
+  if(cell_simple_p(c)){
+    elen = cell_simple_egc(c, egc);
+  }else{
+    const char* e = egcpool_extended_gcluster(&vs->pool, c);
+    if((elen = strlen(e)) >= sizeof(egc)){
+      return;
+    }
+    memcpy(egc, e, elen);
+  }
+  if(elen + len >= sizeof(egc)){
+    return;
+  }
+  memcpy(egc + elen, u, len);
+  elen += len;
+  pool_release(&vs->pool, c);
+  vscreen_stash(vs, c, egc, elen);
+  size_t lastlen = strlen(vs->last);
+  if(vs->lastcols && lastlen + len < sizeof(vs->last)){
+    memcpy(vs->last + lastlen, u, len);
+    vs->last[lastlen + len] = '\0';
+  }
+}
+
+// a complete code point has been decoded into vs->utf8. as in utf8_egc_len(),
+// those of zero (or no defined) width extend the previous glyph.
+static void
+vscreen_codepoint(vscreen* vs){
+  uint32_t wc;
+  vs->utf8[vs->utf8len] = '\0';
+  if(utf8_decode(vs->utf8, &wc) != vs->utf8len){
+    return;
+  }
+  int cols = ucs_width(wc);
+  if(cols > 0){
+    vscreen_print(vs, vs->utf8, vs->utf8len, cols);
+  }else if(wc >= 0xa0){ // C1 controls are ignored
+    vscreen_join(vs, vs->utf8, vs->utf8len);
+  }
+}
+
+static void
+vscreen_reset(vscreen* vs){
+  memset(&vs->pen, 0, sizeof(vs->pen));
+  for(int y = 0 ; y < vs->dimy ; ++y){
+    vscreen_erase(vs, y, 0, vs->dimx);
+  }
+  vs->top = 0;
+  vs->bottom = vs->dimy - 1;
+  vs->savedy = vs->savedx = 0;
+  vs->last[0] = '\0';
+  vs->lastcols = 0;
+  vscreen_goto(vs, 0, 0);
+}
+
+// execute a C0 control. returns false if 'b' isn't one.
+static bool
+vscreen_control(vscreen* vs, unsigned char b){
+  switch(b){
+    case '\b':
+      vscreen_goto(vs, vs->y, vs->x - 1);
+      break;
+    case '\t':
+      vscreen_goto(vs, vs->y, (vs->x / 8 + 1) * 8);
+      break;
+    case '\n': case '\v': case '\f':
+      vscreen_linefeed(vs);
+      break;
+    case '\r':
+      vscreen_goto(vs, vs->y, 0);
+      break;
+    default:
+      if(b >= 0x20 && b != 0x7f){
+        return false;
+      }
+      break; // BEL, NUL, DEL, shifts, etc.
+  }
+  return true;
+}
+
+// the value of parameter 'i', or 'def' if it was omitted
+static inline int
+csi_param(const int* params, int np, int i, int def){
+  return i < np && params[i] >= 0 ? params[i] : def;
+}
+
+// a count or 1-biased coordinate, for which 0 is the same as 1
+static inline int
+csi_count(const int* params, int np, int i){
+  const int v = csi_param(params, np, i, 1);
+  return v ? v : 1;
+}
+
+static void
+vscreen_sgr(vscreen* vs, const int* params, int np){
+  if(np == 0){
+    memset(&vs->pen, 0, sizeof(vs->pen));
+    return;
+  }
+  cell* pen = &vs->pen;
+  for(int i = 0 ; i < np ; ++i){
+    const int p = params[i] < 0 ? 0 : params[i];
+    if(p >= 30 && p <= 37){
+      cell_set_fg_palindex(pen, p - 30);
+    }else if(p >= 90 && p <= 97){
+      cell_set_fg_palindex(pen, p - 90 + 8);
+    }else if(p >= 40 && p <= 47){
+      cell_set_bg_palindex(pen, p - 40);
+    }else if(p >= 100 && p <= 107){
+      cell_set_bg_palindex(pen, p - 100 + 8);
+    }else if(p == 38 || p == 48){
+      const bool fg = p == 38;
+      if(i + 2 < np && params[i + 1] == 5){
+        const int idx = params[i + 2];
+        if(idx >= 0 && idx < NCPALETTESIZE){
+          fg ? cell_set_fg_palindex(pen, idx) : cell_set_bg_palindex(pen, idx);
+        }
+        i += 2;
+      }else if(i + 4 < np && params[i + 1] == 2){
+        const int r = params[i + 2];
+        const int g = params[i + 3];
+        const int bl = params[i + 4];
+        fg ? cell_set_fg_rgb(pen, r, g, bl) : cell_set_bg_rgb(pen, r, g, bl);
+        i += 4;
+      }else{
+        return; // we can't know how many parameters to skip
+      }
+    }else switch(p){
+      case 0: memset(pen, 0, sizeof(*pen)); break;
+      case 1: cell_styles_on(pen, NCSTYLE_BOLD); break;
+      case 2: cell_styles_on(pen, NCSTYLE_DIM); break;
+      case 3: cell_styles_on(pen, NCSTYLE_ITALIC); break;
+      case 4: cell_styles_on(pen, NCSTYLE_UNDERLINE); break;
+      case 5: cell_styles_on(pen, NCSTYLE_BLINK); break;
+      case 7: cell_styles_on(pen, NCSTYLE_REVERSE); break;
+      case 8: cell_styles_on(pen, NCSTYLE_INVIS); break;
+      case 22: cell_styles_off(pen, NCSTYLE_BOLD | NCSTYLE_DIM); break;
+      case 23: cell_styles_off(pen, NCSTYLE_ITALIC); break;
+      case 24: cell_styles_off(pen, NCSTYLE_UNDERLINE); break;
+      case 25: cell_styles_off(pen, NCSTYLE_BLINK); break;
+      case 27: cell_styles_off(pen, NCSTYLE_REVERSE); break;
+      case 28: cell_styles_off(pen, NCSTYLE_INVIS); break;
+      case 39: cell_set_fg_default(pen); break;
+      case 49: cell_set_bg_default(pen); break;
+    }
+  }
+}
+
+// a CSI has been completed by the final byte 'f'. sequences with private
+// markers or intermediate bytes (modes, etc.) don't affect the screen.
+static void
+vscreen_csi(vscreen* vs, unsigned char f){
+  int params[VSCREEN_PARAMS];
+  int np = 0;
+  if(vs->seqlen){
+    params[np++] = -1;
+  }
+  for(size_t i = 0 ; i < vs->seqlen ; ++i){
+    const char c = vs->seq[i];
+    if(c == ';' || c == ':'){
+      if(np == VSCREEN_PARAMS){
+        return;
+      }
+      params[np++] = -1;
+    }else if(c >= '0' && c <= '9'){
+      int* p = &params[np - 1];
+      if(*p < 0){
+        *p = 0;
+      }
+      if(*p < 100000){
+        *p = *p * 10 + (c - '0');
+      }
+    }else{
+      return; // private marker or intermediate byte
+    }
+  }
+  const int n = csi_count(params, np, 0);
+  switch(f){
+    case 'A': vscreen_goto(vs, vs->y - n, vs->x); break;
+    case 'B': case 'e': vscreen_goto(vs, vs->y + n, vs->x); break;
+    case 'C': case 'a': vscreen_goto(vs, vs->y, vs->x + n); break;
+    case 'D': vscreen_goto(vs, vs->y, vs->x - n); break;
+    case 'E': vscreen_goto(vs, vs->y + n, 0); break;
+    case 'F': vscreen_goto(vs, vs->y - n, 0); break;
+    case 'G': case '`': vscreen_goto(vs, vs->y, n - 1); break;
+    case 'd': vscreen_goto(vs, n - 1, vs->x); break;
+    case 'H': case 'f':
+      vscreen_goto(vs, n - 1, csi_count(params, np, 1) - 1);
+      break;
+    case 'J':
+      switch(csi_param(params, np, 0, 0)){
+        case 0:
+          vscreen_erase(vs, vs->y, vs->x, vs->dimx);
+          for(int y = vs->y + 1 ; y < vs->dimy ; ++y){
+            vscreen_erase(vs, y, 0, vs->dimx);
+          }
+          break;
+        case 1:
+          for(int y = 0 ; y < vs->y ; ++y){
+            vscreen_erase(vs, y, 0, vs->dimx);
+          }
+          vscreen_erase(vs, vs->y, 0, vs->x + 1);
+          break;
+        case 2: case 3:
+          for(int y = 0 ; y < vs->dimy ; ++y){
+            vscreen_erase(vs, y, 0, vs->dimx);
+          }
+          break;
+      }
+      break;
+    case 'K':
+      switch(csi_param(params, np, 0, 0)){
+        case 0: vscreen_erase(vs, vs->y, vs->x, vs->dimx); break;
+        case 1: vscreen_erase(vs, vs->y, 0, vs->x + 1); break;
+        case 2: vscreen_erase(vs, vs->y, 0, vs->dimx); break;
+      }
+      break;
+    case 'X':
+      vscreen_erase(vs, vs->y, vs->x, vs->x + n);
+      break;
+    case 'b':
+      if(vs->lastcols){
+        for(int i = 0 ; i < n && i < vs->dimy * vs->dimx ; ++i){
+          vscreen_print(vs, vs->last, strlen(vs->last), vs->lastcols);
+        }
+      }
+      break;
+    case 'S': vscreen_scroll(vs, vs->top, vs->bottom, n); break;
+    case 'T': vscreen_scroll(vs, vs->top, vs->bottom, -n); break;
+    case 'L': case 'M':
+      if(vs->y >= vs->top && vs->y <= vs->bottom){
+        vscreen_scroll(vs, vs->y, vs->bottom, f == 'M' ? n : -n);
+        vscreen_goto(vs, vs->y, 0);
+      }
+      break;
+    case 'm':
+      vscreen_sgr(vs, params, np);
+      break;
+    case 'r':{
+      const int top = csi_count(params, np, 0) - 1;
+      int bottom = csi_param(params, np, 1, 0);
+      if(bottom == 0 || bottom > vs->dimy){
+        bottom = vs->dimy;
+      }
+      if(top < bottom - 1){
+        vs->top = top;
+        vs->bottom = bottom - 1;
+        vscreen_goto(vs, 0, 0);
+      }
+      break;
+    }case 's':
+      vs->savedy = vs->y;
+      vs->savedx = vs->x;
+      break;
+    case 'u':
+      vscreen_goto(vs, vs->savedy, vs->savedx);
+      break;
+  }
+}
+
+static void
+vscreen_esc(vscreen* vs, unsigned char b){
+  vs->state = VS_GROUND;
+  switch(b){
+    case '[':
+      vs->state = VS_CSI;
+      vs->seqlen = 0;
+      vs->seqoverflow = false;
+      break;
+    case ']':
+      vs->state = VS_OSC;
+      vs->seqlen = 0;
+      break;
+    case 'P': case 'X': case '^': case '_':
+      vs->state = VS_STRING;
+      break;
+    case '(': case ')': case '*': case '+': case '-': case '.': case '/':
+    case '#': case '%': case ' ':
+      vs->state = VS_CHARSET;
+      break;
+    case 'D': vscreen_linefeed(vs); break;
+    case 'E': vscreen_goto(vs, vs->y, 0); vscreen_linefeed(vs); break;
+    case 'M': vscreen_revindex(vs); break;
+    case '7':
+      vs->savedy = vs->y;
+      vs->savedx = vs->x;
+      break;
+    case '8': vscreen_goto(vs, vs->savedy, vs->savedx); break;
+    case 'c': vscreen_reset(vs); break;
+    case '\x1b': vs->state = VS_ESC; break;
+    default:
+      if(vscreen_control(vs, b) && b < 0x20){
+        vs->state = VS_ESC; // controls are executed within escapes
+      }
+      break;
+  }
+}
+
+static void
+vscreen_byte(vscreen* vs, unsigned char b){
+  switch(vs->state){
+    case VS_GROUND:
+      if(b >= 0x80){
+        if((b & 0xc0) == 0x80){ // continuation
+          if(vs->utf8need){
+            vs->utf8[vs->utf8len++] = b;
+            if(--vs->utf8need == 0){
+              vscreen_codepoint(vs);
+            }
+          }
+        }else{
+          vs->utf8len = 1;
+          vs->utf8[0] = b;
+          if((b & 0xe0) == 0xc0){
+            vs->utf8need = 1;
+          }else if((b & 0xf0) == 0xe0){
+            vs->utf8need = 2;
+          }else if((b & 0xf8) == 0xf0){
+            vs->utf8need = 3;
+          }else{
+            vs->utf8need = 0;
+          }
+        }
+        return;
+      }
+      vs->utf8need = 0;
+      if(b == 0x1b){
+        vs->state = VS_ESC;
+      }else if(!vscreen_control(vs, b)){
+        const char c = b;
+        vscreen_print(vs, &c, 1, 1);
+      }
+      break;
+    case VS_ESC:
+      vscreen_esc(vs, b);
+      break;
+    case VS_CSI:
+      if(b >= 0x40 && b <= 0x7e){
+        vs->state = VS_GROUND;
+        if(!vs->seqoverflow){
+          vscreen_csi(vs, b);
+        }
+      }else if(b >= 0x20 && b <= 0x3f){
+        if(vs->seqlen == sizeof(vs->seq)){
+          vs->seqoverflow = true;
+        }else{
+          vs->seq[vs->seqlen++] = b;
+        }
+      }else if(b == 0x1b){
+        vs->state = VS_ESC;
+      }else{
+        vscreen_control(vs, b);
+      }
+      break;
+    case VS_CHARSET:
+      vs->state = VS_GROUND;
+      break;
+    case VS_OSC:
+      if(vs->seqlen++ == 0 && b == 'P'){
+        vs->state = VS_LINUXPAL;
+        vs->oscleft = 7;
+      }else if(vs->seqlen == 1 && b == 'R'){
+        vs->state = VS_GROUND;
+      }else if(b == '\a'){
+        vs->state = VS_GROUND;
+      }else if(b == 0x1b){
+        vs->state = VS_STRINGESC;
+      }
+      break;
+    case VS_STRING:
+      if(b == 0x1b){
+        vs->state = VS_STRINGESC;
+      }
+      break;
+    case VS_STRINGESC:
+      if(b == '\\'){
+        vs->state = VS_GROUND;
+      }else{
+        vscreen_esc(vs, b);
+      }
+      break;
+    case VS_LINUXPAL:
+      if(--vs->oscleft == 0){
+        vs->state = VS_GROUND;
+      }
+      break;
+  }
+}
+
+int vscreen_write(vscreen* vs, const char* buf, size_t len){
+  for(size_t i = 0 ; i < len ; ++i){
+    vscreen_byte(vs, buf[i]);
+  }
+  return 0;
+}
+
+int vscreen_resize(vscreen* vs, int dimy, int dimx){
+  if(dimy <= 0 || dimx <= 0){
+    return -1;
+  }
+  cell* cells = malloc(sizeof(*cells) * dimy * dimx);
+  if(cells == NULL){
+    return -1;
+  }
+  for(int y = 0 ; y < vs->dimy ; ++y){
+    for(int x = 0 ; x < vs->dimx ; ++x){
+      cell* c = &vs->cells[y * vs->dimx + x];
+      if(y >= dimy || x >= dimx){
+        pool_release(&vs->pool, c);
+      }else if(x == dimx - 1 && cell_wide_left_p(c)){
+        pool_release(&vs->pool, c); // its right half was cut off
+        c->gcluster = ' ';
+        c->channels &= ~CELL_WIDEASIAN_MASK;
+      }
+    }
+  }
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      cell* c = &cells[y * dimx + x];
+      if(y < vs->dimy && x < vs->dimx){
+        *c = vs->cells[y * vs->dimx + x];
+      }else{
+        c->gcluster = ' ';
+        c->attrword = 0;
+        c->channels = 0;
+      }
+    }
+  }
+  free(vs->cells);
+  vs->cells = cells;
+  vs->dimy = dimy;
+  vs->dimx = dimx;
+  vs->top = 0;
+  vs->bottom = dimy - 1;
+  vscreen_goto(vs, vs->y, vs->x);
+  if(vs->savedy >= dimy){
+    vs->savedy = dimy - 1;
+  }
+  if(vs->savedx >= dimx){
+    vs->savedx = dimx - 1;
+  }
+  return 0;
+}
+
+int vscreen_init(vscreen* vs, int dimy, int dimx){
+  memset(vs, 0, sizeof(*vs));
+  egcpool_init(&vs->pool);
+  vs->state = VS_GROUND;
+  return vscreen_resize(vs, dimy, dimx);
+}
+
+void vscreen_free(vscreen* vs){
+  egcpool_dump(&vs->pool);
+  free(vs->cells);
+  vs->cells = NULL;
+}
+
+char* notcurses_headless_at(const notcurses* nc, int y, int x,
+                            uint32_t* attrword, uint64_t* channels){
+  if(nc->vscreen == NULL){
+    return NULL;
+  }
+  const cell* c = vscreen_at(nc->vscreen, y, x);
+  if(c == NULL){
+    return NULL;
+  }
+  if(attrword){
+    *attrword = c->attrword;
+  }
+  if(channels){
+    *channels = c->channels;
+  }
+  return pool_egc_copy(&nc->vscreen->pool, c);
+}
+
+int notcurses_headless_cursor(const notcurses* nc, int* restrict y, int* restrict x){
+  if(nc->vscreen == NULL){
+    return -1;
+  }
+  if(y){
+    *y = nc->vscreen->y;
+  }
+  if(x){
+    *x = nc->vscreen->x;
+  }
+  return 0;
+}
+
+int notcurses_headless_resize(notcurses* nc, int rows, int cols){
+  if(nc->vscreen == NULL){
+    return -1;
+  }
+  // the writer mustn't be interpreting a frame while we reallocate
+  if(notcurses_render_wait(nc)){
+    return -1;
+  }
+  return vscreen_resize(nc->vscreen, rows, cols);
+}
@@ -0,0 +1,83 @@
+#ifndef NOTCURSES_VSCREEN
+#define NOTCURSES_VSCREEN
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "notcurses/notcurses.h"
+#include "egcpool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a virtual terminal, into which a headless context (NCOPTION_HEADLESS)
+// writes its output. the escapes and glyphs written to it are interpreted as
+// an ECMA-48 (xterm-like) terminal would, updating a grid of cells which can
+// then be inspected. it understands cursor motion, erasure, scrolling regions,
+// SGR styles and colors (including 256-color and RGB forms), REP, and autowrap
+// with a pending wrap at the right margin ('am' with 'xenl'). zero-width code
+// points join the preceding glyph. other sequences (modes, OSC, DCS, etc.)
+// are consumed, and have no effect.
+//
+// cells use the same representation as lastframe: the glyph is in 'gcluster'
+// (backed by 'pool'), the styles and palette indices are in 'attrword', and
+// colors are in 'channels'. the left half of a wide glyph and the right half
+// following it both have CELL_WIDEASIAN_MASK set, the right half having a
+// zero 'gcluster'. erased cells are spaces. colors emitted as palette indices
+// (setaf/setab, or the 16 ANSI colors) are recorded as such, and RGB colors
+// as RGB.
+
+#define VSCREEN_PARAMS 16    // most parameters interpreted in a CSI
+#define VSCREEN_SEQMAX 64    // longest CSI we'll buffer (longer are dropped)
+#define VSCREEN_EGCMAX 64    // longest EGC we'll store (joiners are dropped)
+
+typedef struct vscreen {
+  int dimy, dimx;        // geometry
+  cell* cells;           // dimy * dimx cells, row-major
+  egcpool pool;          // backing store for the cells' multibyte EGCs
+  int y, x;              // cursor
+  bool wrapnext;         // a glyph was written to the last column
+  int top, bottom;       // scrolling region, inclusive
+  int savedy, savedx;    // cursor saved by sc (DECSC/SCOSC)
+  cell pen;              // current rendition (attrword and channels only)
+  char last[VSCREEN_EGCMAX]; // the most recently printed EGC, for REP
+  int lastcols;          // columns occupied by 'last', 0 if nothing printed
+  // parser state
+  int state;             // see vscreen.c
+  char seq[VSCREEN_SEQMAX]; // parameter and intermediate bytes of a CSI
+  size_t seqlen;
+  bool seqoverflow;      // the current CSI overran 'seq'
+  int oscleft;           // hex digits remaining in a Linux console palette OSC
+  char utf8[5];          // code point being decoded, and a NUL
+  int utf8len, utf8need;
+} vscreen;
+
+// create a blank 'dimy' x 'dimx' virtual terminal, with the cursor homed
+int vscreen_init(vscreen* vs, int dimy, int dimx);
+
+void vscreen_free(vscreen* vs);
+
+// change the geometry. the content of the overlapping region is retained,
+// the cursor is clamped to the new geometry, and the scrolling region is
+// reset to the whole screen.
+int vscreen_resize(vscreen* vs, int dimy, int dimx);
+
+// interpret 'len' bytes of output. escapes and multibyte characters can be
+// split across calls. never fails, but returns int to stand in for write(2).
+int vscreen_write(vscreen* vs, const char* buf, size_t len);
+
+// the cell at 'y', 'x', or NULL if it is outside the screen
+static inline const cell*
+vscreen_at(const vscreen* vs, int y, int x){
+  if(y < 0 || y >= vs->dimy || x < 0 || x >= vs->dimx){
+    return NULL;
+  }
+  return &vs->cells[y * vs->dimx + x];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#include <errno.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <notcurses/notcurses.h>
+
+// notcurses-replay: replay a trace recorded by setting NOTCURSES_TRACE, and
+// report statistics on its rendering as JSON. by default the trace is
+// rendered into a headless context, so that the replay (and thus any
+// comparison of its statistics across builds) depends only on the trace.
+
+static void
+usage(const char* exe, int status){
+  FILE* out = status == EXIT_SUCCESS ? stdout : stderr;
+  fprintf(out, "usage: %s [ -htr ] [ -o jsonfile ] trace\n", exe);
+  fprintf(out, " -h: this message\n");
+  fprintf(out, " -t: replay to the terminal rather than a headless context\n");
+  fprintf(out, " -r: pace renders as they were recorded\n");
+  fprintf(out, " -o jsonfile: write results to this file rather than stdout\n");
+  exit(status);
+}
+
+static void
+write_stats(FILE* out, const char* trace, int frames, const ncstats* s){
+  fprintf(out, "{\"notcurses-replay\":{\"version\":\"%s\",\"trace\":\"%s\","
+          "\"frames\":%d,\"renders\":%" PRIu64 ",\"failed_renders\":%" PRIu64
+          ",\"render_bytes\":%" PRIu64 ",\"render_ns\":%" PRIu64
+          ",\"render_min_ns\":%" PRId64 ",\"render_max_ns\":%" PRId64
+          ",\"paint_ns\":%" PRIu64 ",\"postpaint_ns\":%" PRIu64
+          ",\"raster_ns\":%" PRIu64 ",\"write_ns\":%" PRIu64
+          ",\"cellelisions\":%" PRIu64 ",\"cellemissions\":%" PRIu64
+          ",\"cellsculled\":%" PRIu64 "}}\n",
+          notcurses_version(), trace, frames, s->renders, s->failed_renders,
+          s->render_bytes, s->render_ns,
+          s->renders ? s->render_min_ns : 0, s->render_max_ns,
+          s->paint_ns, s->postpaint_ns, s->raster_ns, s->write_ns,
+          s->cellelisions, s->cellemissions, s->cellsculled);
+}
+
+int main(int argc, char** argv){
+  if(!setlocale(LC_ALL, "")){
+    fprintf(stderr, "Couldn't set locale\n");
+    return EXIT_FAILURE;
+  }
+  FILE* out = stdout;
+  bool headless = true;
+  bool realtime = false;
+  int c;
+  while((c = getopt(argc, argv, "htro:")) != EOF){
+    switch(c){
+      case 'h':
+        usage(*argv, EXIT_SUCCESS);
+        break;
+      case 't':
+        headless = false;
+        break;
+      case 'r':
+        realtime = true;
+        break;
+      case 'o':
+        if(out != stdout){
+          fprintf(stderr, "Supplied -o twice\n");
+          usage(*argv, EXIT_FAILURE);
+        }
+        if((out = fopen(optarg, "wb")) == NULL){
+          fprintf(stderr, "Error opening %s for JSON (%s?)\n", optarg, strerror(errno));
+          return EXIT_FAILURE;
+        }
+        break;
+      default:
+        usage(*argv, EXIT_FAILURE);
+    }
+  }
+  if(argc - optind != 1){
+    usage(*argv, EXIT_FAILURE);
+  }
+  const char* trace = argv[optind];
+  FILE* fp = fopen(trace, "rb");
+  if(fp == NULL){
+    fprintf(stderr, "Error opening %s (%s?)\n", trace, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  // we oughtn't record our own replay
+  unsetenv("NOTCURSES_TRACE");
+  notcurses_options opts = {
+    .flags = NCOPTION_INHIBIT_SETLOCALE | NCOPTION_SUPPRESS_BANNERS |
+             (headless ? NCOPTION_HEADLESS : 0),
+  };
+  struct notcurses* nc = notcurses_init(&opts, NULL);
+  if(nc == NULL){
+    fclose(fp);
+    return EXIT_FAILURE;
+  }
+  int frames = notcurses_replay(nc, fp, realtime);
+  fclose(fp);
+  ncstats stats;
+  notcurses_stats(nc, &stats);
+  if(notcurses_stop(nc) || frames < 0){
+    fprintf(stderr, "Error replaying %s\n", trace);
+    return EXIT_FAILURE;
+  }
+  write_stats(out, trace, frames, &stats);
+  if(out != stdout && fclose(out)){
+    fprintf(stderr, "Error writing JSON (%s?)\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,70 @@ TEST_CASE("Cell") {
     cell_release(n_, &c);
   }
 
+  // EGCs of up to four bytes are stored within the cell, leaving the pool be
+  SUBCASE("LoadInline") {
+    const char* egcs[] = { "µ", "▀", "⣿", "à", "\xf0\x9f\xa6\xb2", };
+    for(auto egc : egcs){
+      cell c = CELL_TRIVIAL_INITIALIZER;
+      REQUIRE((int)strlen(egc) == cell_load(n_, &c, egc));
+      CHECK(cell_simple_p(&c));
+      CHECK(0 == n_->pool.poolused);
+      char buf[5];
+      CHECK((int)strlen(egc) == cell_simple_egc(&c, buf));
+      CHECK(0 == strcmp(egc, buf));
+      CHECK(0 == strcmp(egc, cell_extended_gcluster(n_, &c)));
+      char* dup = cell_strdup(n_, &c);
+      REQUIRE(dup);
+      CHECK(0 == strcmp(egc, dup));
+      free(dup);
+      cell d = CELL_TRIVIAL_INITIALIZER;
+      CHECK((int)strlen(egc) == cell_duplicate(n_, &d, &c));
+      CHECK(0 == cellcmp(n_, &c, n_, &d));
+      cell_release(n_, &d);
+      cell_release(n_, &c);
+    }
+  }
+
+  // longer EGCs still go to the pool
+  SUBCASE("LoadPooled") {
+    const char* egc = "a\xcc\x80\xcc\x81"; // five bytes
+    cell c = CELL_TRIVIAL_INITIALIZER;
+    REQUIRE(5 == cell_load(n_, &c, egc));
+    CHECK(!cell_simple_p(&c));
+    CHECK(6 == n_->pool.poolused);
+    CHECK(0 == strcmp(egc, cell_extended_gcluster(n_, &c)));
+    cell_release(n_, &c);
+    CHECK(0 == n_->pool.poolused);
+  }
+
+  // a four-byte EGC ending in 0x01 would look like a pool offset if inlined
+  SUBCASE("LoadMimicsPoolOffset") {
+    const char* egc = "\x01\x01\x01\x01";
+    cell c = CELL_TRIVIAL_INITIALIZER;
+    REQUIRE(4 == cell_load(n_, &c, egc));
+    CHECK(!cell_simple_p(&c));
+    CHECK(0 == strcmp(egc, cell_extended_gcluster(n_, &c)));
+    cell_release(n_, &c);
+    CHECK(0 == n_->pool.poolused);
+    notcurses_options nopts{};
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE |
+                  NCOPTION_HEADLESS;
+    auto nc = notcurses_init(&nopts, nullptr);
+    REQUIRE(nc);
+    auto n = notcurses_stdplane(nc);
+    CHECK(0 <= ncplane_putegc_yx(n, 0, 0, egc, nullptr));
+    CHECK(0 < ncplane_putsimple_yx(n, 0, 1, 'x'));
+    char* dup = ncplane_at_yx(n, 0, 0, nullptr, nullptr);
+    REQUIRE(dup);
+    CHECK(0 == strcmp(egc, dup));
+    free(dup);
+    CHECK(0 == notcurses_render(nc));
+    dup = notcurses_at_yx(nc, 0, 0, nullptr, nullptr);
+    REQUIRE(dup);
+    free(dup);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
   SUBCASE("MultibyteWidth") {
     CHECK(0 == mbswidth(""));       // zero bytes, zero columns
     CHECK(-1 == mbswidth("\x7"));   // single byte, non-printable
@@ -257,6 +321,124 @@ TEST_CASE("Cell") {
     free(egc);
   }
 
+  // a block read with ncplane_get_cells() and written elsewhere with
+  // ncplane_put_cells() reproduces the original, wide glyphs and all
+  SUBCASE("BlockRoundTrip") {
+    auto p = ncplane_new(nc_, 2, 12, 0, 0, nullptr);
+    REQUIRE(p);
+    auto q = ncplane_new(nc_, 4, 16, 0, 0, nullptr);
+    REQUIRE(q);
+    ncplane_set_fg_rgb(p, 0x40, 0x80, 0xc0);
+    CHECK(0 < ncplane_putstr_yx(p, 0, 0, "a中b a\xcc\x80\xcc\x81 xyz"));
+    ncplane_styles_set(p, NCSTYLE_BOLD);
+    CHECK(0 < ncplane_putstr_yx(p, 1, 1, "全角 \xf0\x9f\xa6\xb2!"));
+    cell cells[2 * 12];
+    CHECK(24 == ncplane_get_cells(p, 0, 0, 2, 12, cells, 12));
+    CHECK(24 == ncplane_put_cells(q, 1, 2, 2, 12, p, cells, 12));
+    for(auto& c : cells){
+      cell_release(p, &c);
+    }
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 12 ; ++x){
+        cell c0 = CELL_TRIVIAL_INITIALIZER, c1 = CELL_TRIVIAL_INITIALIZER;
+        CHECK(0 <= ncplane_at_yx_cell(p, y, x, &c0));
+        CHECK(0 <= ncplane_at_yx_cell(q, y + 1, x + 2, &c1));
+        CHECK(0 == cellcmp(p, &c0, q, &c1));
+        cell_release(p, &c0);
+        cell_release(q, &c1);
+      }
+    }
+    // a subset of the columns, using the stride
+    CHECK(6 == ncplane_get_cells(q, 1, 7, 2, 3, cells, 12));
+    CHECK(6 == ncplane_put_cells(p, 0, 0, 2, 3, q, cells, 12));
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 3 ; ++x){
+        cell_release(q, &cells[y * 12 + x]);
+      }
+    }
+    char* egc = ncplane_at_yx(p, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "a\xcc\x80\xcc\x81"));
+    free(egc);
+    // blocks must lie entirely within the plane
+    CHECK(-1 == ncplane_get_cells(p, 1, 10, 2, 3, cells, 3));
+    CHECK(-1 == ncplane_put_cells(p, 0, 0, 1, 3, p, cells, 2));
+    CHECK(0 == ncplane_destroy(q));
+    CHECK(0 == ncplane_destroy(p));
+  }
+
+  // writing a block obliterates wide glyphs split by its edges
+  SUBCASE("BlockSplitsWide") {
+    auto p = ncplane_new(nc_, 1, 8, 0, 0, nullptr);
+    REQUIRE(p);
+    CHECK(12 == ncplane_putstr_yx(p, 0, 0, "中中中中"));
+    cell cells[2] = { CELL_SIMPLE_INITIALIZER('x'), CELL_SIMPLE_INITIALIZER('y') };
+    CHECK(2 == ncplane_put_cells(p, 0, 1, 1, 2, nullptr, cells, 2));
+    const char* expected[] = { "", "x", "y", "", "中", "", "中", "", };
+    for(int x = 0 ; x < 8 ; ++x){
+      cell c = CELL_TRIVIAL_INITIALIZER;
+      CHECK(0 <= ncplane_at_yx_cell(p, 0, x, &c));
+      CHECK(0 == strcmp(extended_gcluster(p, &c), expected[x]));
+      CHECK((x >= 4) == cell_double_wide_p(&c));
+      cell_release(p, &c);
+    }
+    // complex cells require a source plane
+    cell c = CELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < cell_load(p, &c, "a\xcc\x80\xcc\x81"));
+    CHECK(-1 == ncplane_put_cells(p, 0, 0, 1, 1, nullptr, &c, 1));
+    cell_release(p, &c);
+    CHECK(0 == ncplane_destroy(p));
+  }
+
+  // writing from an EGC table matches writing the EGCs one at a time
+  SUBCASE("BlockEGCTable") {
+    auto p = ncplane_new(nc_, 2, 8, 0, 0, nullptr);
+    REQUIRE(p);
+    auto q = ncplane_new(nc_, 2, 8, 0, 0, nullptr);
+    REQUIRE(q);
+    const char* egcs[] = { "a", "中", "a\xcc\x80\xcc\x81", };
+    // the index following that of the wide glyph is ignored
+    const uint32_t indices[] = {
+      0, 1, 2, 2, 0,
+      2, 0, 0, 0, 1,
+    };
+    ncplane_set_fg_rgb(p, 0xff, 0x80, 0x40);
+    ncplane_set_fg_rgb(q, 0xff, 0x80, 0x40);
+    CHECK(10 == ncplane_put_egcs(p, 0, 1, 2, 5, egcs, 3, indices, nullptr, 5));
+    CHECK(0 < ncplane_putstr_yx(q, 0, 1, "a中a\xcc\x80\xcc\x81" "a"));
+    CHECK(0 < ncplane_putstr_yx(q, 1, 1, "a\xcc\x80\xcc\x81" "aaa中"));
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 8 ; ++x){
+        cell c0 = CELL_TRIVIAL_INITIALIZER, c1 = CELL_TRIVIAL_INITIALIZER;
+        CHECK(0 <= ncplane_at_yx_cell(p, y, x, &c0));
+        CHECK(0 <= ncplane_at_yx_cell(q, y, x, &c1));
+        CHECK(0 == cellcmp(p, &c0, q, &c1));
+        cell_release(p, &c0);
+        cell_release(q, &c1);
+      }
+    }
+    // per-cell styling
+    cell styles[2] = { CELL_TRIVIAL_INITIALIZER, CELL_TRIVIAL_INITIALIZER };
+    styles[1].attrword = NCSTYLE_BOLD;
+    cell_set_fg_rgb(&styles[1], 0x20, 0x40, 0x60);
+    CHECK(2 == ncplane_put_egcs(p, 0, 0, 1, 2, egcs, 3, indices, styles, 2));
+    uint32_t attrword;
+    uint64_t channels;
+    char* egc = ncplane_at_yx(p, 0, 1, &attrword, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "中"));
+    CHECK(NCSTYLE_BOLD == attrword);
+    CHECK(0x204060 == channels_fg(channels));
+    free(egc);
+    // indices must lie within the table, and entries be single EGCs
+    const uint32_t bad = 3;
+    CHECK(-1 == ncplane_put_egcs(p, 0, 0, 1, 1, egcs, 3, &bad, nullptr, 1));
+    const char* multi[] = { "ab", };
+    CHECK(-1 == ncplane_put_egcs(p, 0, 0, 1, 1, multi, 1, indices, nullptr, 1));
+    CHECK(0 == ncplane_destroy(q));
+    CHECK(0 == ncplane_destroy(p));
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -1,3 +1,5 @@
+#include <string>
+#include <clocale>
 #include <vector>
 #include "main.h"
 #include "egcpool.h"
@@ -46,6 +48,78 @@ TEST_CASE("EGCpool") {
     REQUIRE(1 == c3);
   }
 
+  SUBCASE("UTF8Decode") {
+    uint32_t cp;
+    CHECK(0 == utf8_decode("", &cp));
+    CHECK(1 == utf8_decode("a", &cp));
+    CHECK('a' == cp);
+    CHECK(2 == utf8_decode("à", &cp));
+    CHECK(0xe0 == cp);
+    CHECK(3 == utf8_decode("血", &cp));
+    CHECK(0x8840 == cp);
+    CHECK(4 == utf8_decode("\U0001f52c", &cp));
+    CHECK(0x1f52c == cp);
+    CHECK(-1 == utf8_decode("\x80", &cp)); // lone continuation
+    CHECK(-1 == utf8_decode("\xc0\xa0", &cp)); // overlong
+    CHECK(-1 == utf8_decode("\xe0\x80\xa0", &cp)); // overlong
+    CHECK(-1 == utf8_decode("\xed\xa0\x80", &cp)); // surrogate
+    CHECK(-1 == utf8_decode("\xf4\x90\x80\x80", &cp)); // past U+10FFFF
+    CHECK(-1 == utf8_decode("\xe8\xa1", &cp)); // truncated
+  }
+
+  SUBCASE("UCSWidth") {
+    CHECK(1 == ucs_width('a'));
+    CHECK(1 == ucs_width(' '));
+    CHECK(-1 == ucs_width('\n'));
+    CHECK(-1 == ucs_width(0x7f));
+    CHECK(-1 == ucs_width(0x85)); // C1 control
+    CHECK(1 == ucs_width(0xe0));
+    CHECK(1 == ucs_width(0xad)); // soft hyphen
+    CHECK(0 == ucs_width(0x300)); // combining grave accent
+    CHECK(0 == ucs_width(0x200d)); // zero width joiner
+    CHECK(0 == ucs_width(0xfe0f)); // variation selector
+    CHECK(0 == ucs_width(0x1160)); // hangul jungseong filler
+    CHECK(-1 == ucs_width(0x2028)); // line separator
+    CHECK(2 == ucs_width(0x8840));
+    CHECK(2 == ucs_width(0xff21)); // fullwidth latin A
+    CHECK(2 == ucs_width(0x1f52c));
+    CHECK(1 == ucs_width(0xe000)); // private use
+    CHECK(-1 == ucs_width(0x378)); // unassigned
+    CHECK(-1 == ucs_width(0x110000));
+  }
+
+  // widths mustn't depend on the locale
+  SUBCASE("UTF8EGCLocale") {
+    std::string prev = setlocale(LC_ALL, nullptr);
+    REQUIRE(setlocale(LC_ALL, "C"));
+    int c;
+    CHECK(3 == utf8_egc_len("血", &c));
+    CHECK(2 == c);
+    CHECK(3 == utf8_egc_len("à", &c));
+    CHECK(1 == c);
+    CHECK(setlocale(LC_ALL, prev.c_str()));
+  }
+
+  // check the (possibly vectorized) ASCII scan at every alignment, with runs
+  // ended by NUL, a control, and UTF-8
+  SUBCASE("ASCIIRun") {
+    const char* enders[] = { "", "\x1b[0m", "à", "\x7f", };
+    for(auto ender : enders){
+      for(size_t off = 0 ; off < 32 ; ++off){
+        for(size_t len = 0 ; len < 100 ; ++len){
+          std::string s(off, '\x01');
+          for(size_t i = 0 ; i < len ; ++i){
+            s += ' ' + i % 95;
+          }
+          s += ender;
+          CHECK(len == utf8_ascii_run(s.c_str() + off));
+        }
+      }
+    }
+    std::string tabbed("\ttab");
+    CHECK(0 == utf8_ascii_run(tabbed.c_str()));
+  }
+
   SUBCASE("AddAndRemove") {
     const char* wstr = "\ufdfd"; // bismallih
     int c;
@@ -112,6 +186,82 @@ TEST_CASE("EGCpool") {
     CHECK(0 < pool_.poolwrite);
   }
 
+  // a released slot ought be reused by the next EGC of its size
+  SUBCASE("ReuseReleased") {
+    const char* w1 = "\u0061\u0300\u0301"; // five bytes
+    const char* w2 = "\u0065\u0300\u0301"; // five bytes
+    const char* w3 = "\u0061\u0300"; // three bytes
+    int o1 = egcpool_stash(&pool_, w1, strlen(w1));
+    int o2 = egcpool_stash(&pool_, w3, strlen(w3));
+    REQUIRE(0 <= o1);
+    REQUIRE(o1 < o2);
+    auto write = pool_.poolwrite;
+    egcpool_release(&pool_, o1);
+    CHECK((int)strlen(w2) + 1 == pool_.poolfree);
+    CHECK((int)strlen(w3) + 1 == pool_.poolused);
+    // a different size mustn't take the released slot
+    int o3 = egcpool_stash(&pool_, w3, strlen(w3));
+    CHECK(o1 != o3);
+    CHECK(write < pool_.poolwrite);
+    write = pool_.poolwrite;
+    CHECK(o1 == egcpool_stash(&pool_, w2, strlen(w2)));
+    CHECK(0 == pool_.poolfree);
+    CHECK(write == pool_.poolwrite);
+    CHECK(!strcmp(pool_.pool + o1, w2));
+    CHECK(!strcmp(pool_.pool + o2, w3));
+    CHECK(!strcmp(pool_.pool + o3, w3));
+  }
+
+  // long EGCs share slots rounded up to a power of two
+  SUBCASE("ReuseReleasedLong") {
+    std::string s1("a"), s2("e");
+    for(int i = 0 ; i < 20 ; ++i){
+      s1 += "\u0300";
+      s2 += "\u0301";
+    }
+    s2 += "\u0302";
+    int o1 = egcpool_stash(&pool_, s1.c_str(), s1.size());
+    REQUIRE(0 <= o1);
+    egcpool_release(&pool_, o1);
+    CHECK(64 == pool_.poolfree);
+    CHECK(o1 == egcpool_stash(&pool_, s2.c_str(), s2.size()));
+    CHECK(!strcmp(pool_.pool + o1, s2.c_str()));
+    CHECK(0 == pool_.poolfree);
+    CHECK((int)s2.size() + 1 == pool_.poolused);
+  }
+
+  // sustained churn through a fixed population mustn't grow the pool, once
+  // each size has reached its peak population
+  SUBCASE("Churn") {
+    const char* egcs[] = { "é́", "血", "\U0001f469‍\U0001f52c",
+                           "é̂", "\U0001f1fa\U0001f1f8", };
+    const size_t count = sizeof(egcs) / sizeof(*egcs);
+    std::vector<int> live;
+    for(auto i = 0u ; i < 4096 ; ++i){
+      live.push_back(egcpool_stash(&pool_, egcs[i % count], strlen(egcs[i % count])));
+      REQUIRE(0 <= live.back());
+    }
+    auto churn = [&](unsigned from, unsigned to){
+      for(auto i = from ; i < to ; ++i){
+        auto slot = i % live.size();
+        egcpool_release(&pool_, live[slot]);
+        auto egc = egcs[(i * 3) % count];
+        live[slot] = egcpool_stash(&pool_, egc, strlen(egc));
+        REQUIRE(0 <= live[slot]);
+      }
+    };
+    churn(0, live.size() * count);
+    const auto size = pool_.poolsize;
+    const auto write = pool_.poolwrite;
+    churn(live.size() * count, 1u << 18u);
+    CHECK(size == pool_.poolsize);
+    CHECK(write == pool_.poolwrite);
+    CHECK(pool_.poolused + pool_.poolfree == pool_.poolwrite);
+    for(auto i = 0u ; i < live.size() ; ++i){
+      CHECK(egcpool_check_validity(&pool_, live[i]));
+    }
+  }
+
   // POOL_MINIMUM_ALLOC is the minimum size of an egcpool once it goes active.
   // add EGCs to it past this boundary, and verify that they're all still
   // accurate.
@@ -229,15 +379,102 @@ TEST_CASE("EGCpoolLong" * doctest::skip(true)) {
       REQUIRE(loc == total);
       total += r + 1;
       CHECK(egcpool_check_validity(&pool_, loc));
-      CHECK((1u << 25) > loc);
+      CHECK((1 << 24) > loc);
       if(++wcs == 0x9fa5){
         wcs = 0x4e00;
       }
     }
-    CHECK((1u << 25) <= total);
+    CHECK(POOL_MAXIMUM_BYTES <= total);
   }
 
   // common cleanup
   egcpool_dump(&pool_);
 
 }
+
+// planes' egcpools are rebuilt from their live EGCs on resize and erase, and
+// when fragmented at render time with NCOPTION_COMPACT_EGCPOOLS
+TEST_CASE("EGCpoolCompaction") {
+  if(!enforce_utf8()){
+    return;
+  }
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE
+                | NCOPTION_HEADLESS | NCOPTION_COMPACT_EGCPOOLS;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  REQUIRE(nc_);
+  const char* egc = "à́"; // too long to live within a cell
+  auto n = ncplane_new(nc_, 40, 80, 0, 0, nullptr);
+  REQUIRE(n);
+  for(int y = 0 ; y < 40 ; ++y){
+    for(int x = 0 ; x < 80 ; ++x){
+      REQUIRE(1 == ncplane_putegc_yx(n, y, x, egc, nullptr));
+    }
+  }
+  CHECK(3200 * ((int)strlen(egc) + 1) == n->pool.poolused);
+  ncstats stats;
+  notcurses_stats(nc_, &stats);
+  const auto compactions = stats.egcpool_compactions;
+
+  SUBCASE("Resize") {
+    auto size = n->pool.poolsize;
+    CHECK(0 == ncplane_resize(n, 2, 2, 2, 2, 0, 0, 2, 2));
+    CHECK(4 * ((int)strlen(egc) + 1) == n->pool.poolused);
+    CHECK(n->pool.poolused == n->pool.poolwrite);
+    CHECK(0 == n->pool.poolfree);
+    CHECK(size > n->pool.poolsize);
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 2 ; ++x){
+        auto s = ncplane_at_yx(n, y, x, nullptr, nullptr);
+        REQUIRE(s);
+        CHECK(0 == strcmp(egc, s));
+        free(s);
+      }
+    }
+    notcurses_stats(nc_, &stats);
+    CHECK(compactions + 1 == stats.egcpool_compactions);
+    CHECK((uint64_t)n->pool.poolsize <= stats.egcpool_max_bytes);
+    CHECK((uint64_t)n->pool.poolsize <= stats.egcpool_bytes);
+  }
+
+  // the base cell must survive the erasure
+  SUBCASE("Erase") {
+    cell c = CELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 < cell_load(n, &c, "è́"));
+    CHECK(0 <= ncplane_set_base_cell(n, &c));
+    cell_release(n, &c);
+    ncplane_erase(n);
+    CHECK((int)strlen(egc) + 1 == n->pool.poolused);
+    CHECK(0 == n->pool.poolfree);
+    auto s = ncplane_at_yx(n, 0, 0, nullptr, nullptr);
+    REQUIRE(s);
+    CHECK(0 == strcmp("", s));
+    free(s);
+    CHECK(0 < ncplane_base(n, &c));
+    CHECK(0 == strcmp("è́", cell_extended_gcluster(n, &c)));
+  }
+
+  // overwrite most of the plane with short EGCs, fragmenting the pool
+  SUBCASE("Render") {
+    std::string digits;
+    for(int x = 0 ; x < 77 ; ++x){
+      digits += '0' + x % 10;
+    }
+    for(int y = 0 ; y < 40 ; ++y){
+      CHECK(77 == ncplane_putstr_yx(n, y, 0, digits.c_str()));
+    }
+    CHECK(egcpool_fragmented_p(&n->pool));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(!egcpool_fragmented_p(&n->pool));
+    CHECK(120 * ((int)strlen(egc) + 1) == n->pool.poolused);
+    CHECK(0 == n->pool.poolfree);
+    auto s = ncplane_at_yx(n, 39, 79, nullptr, nullptr);
+    REQUIRE(s);
+    CHECK(0 == strcmp(egc, s));
+    free(s);
+    notcurses_stats(nc_, &stats);
+    CHECK(compactions + 1 == stats.egcpool_compactions);
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
@@ -0,0 +1,278 @@
+#include "main.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+
+// compare the headless virtual terminal against lastframe, returning the
+// number of cells whose glyph (or, with RGB, visible colors) differ
+static int
+screen_mismatches(struct notcurses* nc){
+  int dimy, dimx;
+  notcurses_term_dim_yx(nc, &dimy, &dimx);
+  const bool rgb = nc->tcache.RGBflag;
+  int bad = 0;
+  for(int y = 0 ; y < dimy ; ++y){
+    bool covered = false; // by the wide glyph to our left
+    for(int x = 0 ; x < dimx ; ++x){
+      uint32_t lattr, vattr;
+      uint64_t lchan, vchan;
+      char* lf = notcurses_at_yx(nc, y, x, &lattr, &lchan);
+      REQUIRE(lf);
+      char* vt = notcurses_headless_at(nc, y + nc->margin_t, x + nc->margin_l,
+                                       &vattr, &vchan);
+      REQUIRE(vt);
+      // an empty cell is written as a space, unless a wide glyph covers it
+      const char* want = *lf || covered ? lf : " ";
+      covered = *lf && (lchan & CELL_WIDEASIAN_MASK);
+      bool ok = strcmp(want, vt) == 0;
+      if(ok && rgb){
+        if(channels_bg_default_p(lchan)){
+          ok = channels_bg_default_p(vchan);
+        }else{
+          ok = channels_bg(lchan) == channels_bg(vchan);
+        }
+        if(ok && strcmp(want, " ") && *want){
+          if(channels_fg_default_p(lchan)){
+            ok = channels_fg_default_p(vchan);
+          }else{
+            ok = channels_fg(lchan) == channels_fg(vchan);
+          }
+        }
+      }
+      if(!ok && bad++ < 5){
+        fprintf(stderr, "mismatch at %d/%d: wanted '%s' 0x%016jx got '%s' 0x%016jx\n",
+                y, x, want, (uintmax_t)lchan, vt, (uintmax_t)vchan);
+      }
+      free(vt);
+      free(lf);
+    }
+  }
+  return bad;
+}
+
+static struct notcurses*
+headless_notcurses(uint64_t flags){
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE
+                | NCOPTION_HEADLESS | flags;
+  return notcurses_init(&nopts, nullptr);
+}
+
+// draw styled text, wide glyphs, and overlapping blended planes
+static void
+draw(struct notcurses* nc, int frame, struct ncplane** planes, int count){
+  auto n = notcurses_stdplane(nc);
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    ncplane_set_fg_rgb(n, (y * 7 + frame) % 256, 0x80, 0x40);
+    ncplane_set_bg_rgb(n, 0x20, (y * 3) % 256, 0x60);
+    ncplane_styles_set(n, y % 3 ? NCSTYLE_NONE : NCSTYLE_BOLD);
+    ncplane_cursor_move_yx(n, y, 0);
+    for(int x = 0 ; x < dimx ; ++x){
+      ncplane_putsimple(n, (x + y + frame) % 5 ? 'a' + (x + y) % 26 : ' ');
+    }
+  }
+  for(int i = 0 ; i < count ; ++i){
+    if(planes[i] == nullptr){
+      planes[i] = ncplane_new(nc, 6, 20, 0, 0, nullptr);
+      REQUIRE(planes[i]);
+    }
+    auto p = planes[i];
+    ncplane_move_yx(p, (i * 5 + frame) % dimy, (i * 11 + frame * 3) % dimx);
+    ncplane_erase(p);
+    ncplane_set_fg_rgb(p, 0xff, (i * 40) % 256, 0);
+    ncplane_set_bg_rgb(p, 0, 0, (i * 60) % 256);
+    ncplane_set_bg_alpha(p, i % 2 ? CELL_ALPHA_BLEND : CELL_ALPHA_OPAQUE);
+    for(int y = 0 ; y < 6 ; y += 2){
+      ncplane_putstr_yx(p, y, i % 2, "全角 ▚▞ é ✔");
+    }
+  }
+}
+
+TEST_CASE("Headless") {
+  if(!enforce_utf8()){
+    return;
+  }
+
+  SUBCASE("NoTerminal") {
+    auto nc = headless_notcurses(0);
+    REQUIRE(nc);
+    CHECK(nullptr == nc->ttyfp);
+    CHECK(0 > nc->ttyfd);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    CHECK(24 == dimy);
+    CHECK(80 == dimx);
+    CHECK(0 < ncplane_putstr_yx(notcurses_stdplane(nc), 2, 3, "hello"));
+    CHECK(0 == notcurses_render(nc));
+    char* egc = notcurses_headless_at(nc, 2, 4, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "e"));
+    free(egc);
+    CHECK(nullptr == notcurses_headless_at(nc, dimy, 0, nullptr, nullptr));
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // the interpreted output must reproduce every frame, however it was written
+  SUBCASE("MatchesRender") {
+    for(uint64_t flags : { 0ull, NCOPTION_ASYNC_WRITE, NCOPTION_SYNC_UPDATES,
+                           NCOPTION_PARALLEL_RENDER }){
+      auto nc = headless_notcurses(flags);
+      REQUIRE(nc);
+      struct ncplane* planes[4] = {};
+      for(int frame = 0 ; frame < 5 ; ++frame){
+        draw(nc, frame, planes, 4);
+        CHECK(0 == notcurses_render(nc));
+        CHECK(0 == notcurses_render_wait(nc));
+        CHECK(0 == screen_mismatches(nc));
+      }
+      CHECK(0 == notcurses_refresh(nc, nullptr, nullptr));
+      CHECK(0 == screen_mismatches(nc));
+      CHECK(0 == notcurses_stop(nc));
+    }
+  }
+
+  // headless contexts claim nothing process-wide, and so coexist freely
+  SUBCASE("Concurrent") {
+    const int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+    auto nc0 = headless_notcurses(0);
+    REQUIRE(nc0);
+    auto nc1 = headless_notcurses(0);
+    REQUIRE(nc1);
+    CHECK(flags == fcntl(STDIN_FILENO, F_GETFL, 0));
+    auto tty = testing_notcurses();
+    REQUIRE(tty);
+    CHECK(0 == notcurses_stop(tty));
+    CHECK(0 > notcurses_inputready_fd(nc0));
+    CHECK(0 < ncplane_putstr_yx(notcurses_stdplane(nc0), 0, 0, "zero"));
+    CHECK(0 < ncplane_putstr_yx(notcurses_stdplane(nc1), 0, 0, "one"));
+    CHECK(0 == notcurses_render(nc0));
+    CHECK(0 == notcurses_render(nc1));
+    char* egc = notcurses_headless_at(nc0, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "z"));
+    free(egc);
+    egc = notcurses_headless_at(nc1, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "o"));
+    free(egc);
+    CHECK(0 == notcurses_stop(nc1));
+    CHECK(0 == notcurses_stop(nc0));
+  }
+
+  SUBCASE("Margins") {
+    notcurses_options nopts{};
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE
+                  | NCOPTION_HEADLESS;
+    nopts.margin_t = 2;
+    nopts.margin_l = 3;
+    nopts.margin_b = 1;
+    nopts.margin_r = 4;
+    auto nc = notcurses_init(&nopts, nullptr);
+    REQUIRE(nc);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    CHECK(24 - 3 == dimy);
+    CHECK(80 - 7 == dimx);
+    struct ncplane* planes[2] = {};
+    draw(nc, 0, planes, 2);
+    CHECK(0 == notcurses_render(nc));
+    CHECK(0 == screen_mismatches(nc));
+    // nothing is written to the margins
+    char* egc = notcurses_headless_at(nc, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, " "));
+    free(egc);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  SUBCASE("Resize") {
+    auto nc = headless_notcurses(0);
+    REQUIRE(nc);
+    struct ncplane* planes[3] = {};
+    draw(nc, 0, planes, 3);
+    CHECK(0 == notcurses_render(nc));
+    CHECK(0 == notcurses_headless_resize(nc, 30, 100));
+    CHECK(0 == notcurses_render(nc));
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    CHECK(30 == dimy);
+    CHECK(100 == dimx);
+    draw(nc, 1, planes, 3);
+    CHECK(0 == notcurses_render(nc));
+    CHECK(0 == screen_mismatches(nc));
+    CHECK(0 == notcurses_headless_resize(nc, 10, 33));
+    CHECK(0 == notcurses_refresh(nc, &dimy, &dimx));
+    CHECK(10 == dimy);
+    CHECK(33 == dimx);
+    CHECK(0 == screen_mismatches(nc));
+    CHECK(0 > notcurses_headless_resize(nc, 0, 10));
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // writing a frame elsewhere mustn't disturb what we know of the terminal
+  SUBCASE("RenderToFile") {
+    auto nc = headless_notcurses(0);
+    REQUIRE(nc);
+    struct ncplane* planes[2] = {};
+    draw(nc, 0, planes, 2);
+    CHECK(0 == notcurses_render(nc));
+    // leave the terminal's cursor and colors somewhere other than where a
+    // full frame would leave them
+    auto n = notcurses_stdplane(nc);
+    ncplane_set_fg_rgb(n, 0x10, 0x20, 0x30);
+    CHECK(1 == ncplane_putsimple_yx(n, 2, 5, 'Y'));
+    CHECK(0 == notcurses_render(nc));
+    struct ncstats before, after;
+    notcurses_stats(nc, &before);
+    char* buf = nullptr;
+    size_t buflen = 0;
+    FILE* fp = open_memstream(&buf, &buflen);
+    REQUIRE(fp);
+    CHECK(0 == notcurses_render_to_file(nc, fp));
+    fclose(fp);
+    CHECK(0 < buflen);
+    free(buf);
+    notcurses_stats(nc, &after);
+    CHECK(before.cellemissions == after.cellemissions);
+    CHECK(before.render_bytes == after.render_bytes);
+    ncplane_set_fg_rgb(n, 0x30, 0x20, 0x10);
+    CHECK(1 == ncplane_putsimple_yx(n, 2, 6, 'Z'));
+    CHECK(1 == ncplane_putsimple_yx(n, 10, 0, 'X'));
+    CHECK(0 == notcurses_render(nc));
+    char* egc = notcurses_headless_at(nc, 10, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "X"));
+    free(egc);
+    CHECK(0 == screen_mismatches(nc));
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // a scrolling plane, shifted by the terminal's scrolling region
+  SUBCASE("HardwareScroll") {
+    auto nc = headless_notcurses(0);
+    REQUIRE(nc);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    auto bar = ncplane_new(nc, 1, dimx, 0, 0, nullptr);
+    REQUIRE(bar);
+    auto lg = ncplane_new(nc, dimy - 1, dimx, 1, 0, nullptr);
+    REQUIRE(lg);
+    ncplane_move_below(lg, bar);
+    ncplane_set_scrolling(lg, true);
+    for(int logged = 0 ; logged < dimy * 3 ; ++logged){
+      CHECK(0 < ncplane_printf(lg, "%*d 全角\n", logged % dimx / 2, logged));
+      CHECK(0 < ncplane_printf_yx(bar, 0, 0, "line %d", logged));
+      CHECK(0 == notcurses_render(nc));
+      CHECK(0 == screen_mismatches(nc));
+    }
+    struct ncstats stats;
+    notcurses_stats(nc, &stats);
+    if(nc->tcache.csr){
+      CHECK(0 < stats.hwscrolls);
+    }
+    CHECK(0 == notcurses_stop(nc));
+  }
+}
@@ -139,6 +139,50 @@ TEST_CASE("NCPlane") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // runs of ASCII are written wholesale; verify that the result matches
+  // writing them an EGC at a time, including obliteration of wide glyphs,
+  // combining characters following ASCII, and scrolling.
+  SUBCASE("EmitStrRuns") {
+    const char s[] = "xyz中e\xcc\x81 plain ascii, quite long enough to scroll";
+    struct ncplane* ps[2];
+    for(auto& p : ps){
+      p = ncplane_new(nc_, 3, 12, 1, 1, nullptr);
+      REQUIRE(p);
+      CHECK(!ncplane_set_scrolling(p, true));
+      CHECK(12 == ncplane_putstr_yx(p, 0, 0, "中中中中"));
+      CHECK(0 == ncplane_cursor_move_yx(p, 0, 1));
+    }
+    CHECK(strlen(s) == ncplane_putstr(ps[0], s));
+    size_t off = 0;
+    while(s[off]){
+      int wcs;
+      CHECK(0 < ncplane_putegc(ps[1], s + off, &wcs));
+      off += wcs;
+    }
+    int y0, x0, y1, x1;
+    ncplane_cursor_yx(ps[0], &y0, &x0);
+    ncplane_cursor_yx(ps[1], &y1, &x1);
+    CHECK(y0 == y1);
+    CHECK(x0 == x1);
+    for(int y = 0 ; y < 3 ; ++y){
+      for(int x = 0 ; x < 12 ; ++x){
+        cell c0 = CELL_TRIVIAL_INITIALIZER, c1 = CELL_TRIVIAL_INITIALIZER;
+        CHECK(0 <= ncplane_at_yx_cell(ps[0], y, x, &c0));
+        CHECK(0 <= ncplane_at_yx_cell(ps[1], y, x, &c1));
+        CHECK(0 == cellcmp(ps[0], &c0, ps[1], &c1));
+        cell_release(ps[0], &c0);
+        cell_release(ps[1], &c1);
+      }
+    }
+    // a bounded write stops at its limit, even mid-run
+    CHECK(5 == ncplane_putnstr_yx(ps[0], 2, 0, 5, "abcdefgh"));
+    ncplane_cursor_yx(ps[0], &y0, &x0);
+    CHECK(5 == x0);
+    for(auto p : ps){
+      CHECK(0 == ncplane_destroy(p));
+    }
+  }
+
   // Verify we can emit a wide string, and it advances the cursor
   SUBCASE("EmitWideStr") {
     const wchar_t s[] = L"Σιβυλλα τι θελεις; respondebat illa: αποθανειν θελω.";
@@ -0,0 +1,667 @@
+#include "main.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+// build a scene exercising blending, wide glyphs, EGCs, and HIGHCONTRAST,
+// varying a little with 'frame' so that damage detection gets a workout.
+static void
+draw_scene(struct notcurses* nc, int frame, struct ncplane** planes, int count){
+  auto n = notcurses_stdplane(nc);
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    ncplane_set_fg_rgb(n, (y * 7 + frame) % 256, 0x80, 0x40);
+    ncplane_set_bg_rgb(n, 0x20, (y * 3) % 256, 0x60);
+    ncplane_cursor_move_yx(n, y, 0);
+    for(int x = 0 ; x < dimx ; ++x){
+      ncplane_putsimple(n, 'a' + (x + y + frame) % 26);
+    }
+  }
+  for(int i = 0 ; i < count ; ++i){
+    if(planes[i] == nullptr){
+      planes[i] = ncplane_new(nc, 6, 20, 0, 0, nullptr);
+      REQUIRE(planes[i]);
+    }
+    auto p = planes[i];
+    ncplane_move_yx(p, (i * 5 + frame) % dimy, (i * 11 + frame * 3) % dimx);
+    ncplane_erase(p);
+    ncplane_set_fg_rgb(p, 0xff, (i * 40) % 256, 0);
+    ncplane_set_bg_rgb(p, 0, 0, (i * 60) % 256);
+    ncplane_set_bg_alpha(p, i % 2 ? CELL_ALPHA_BLEND : CELL_ALPHA_OPAQUE);
+    ncplane_set_fg_alpha(p, i % 3 ? CELL_ALPHA_OPAQUE : CELL_ALPHA_HIGHCONTRAST);
+    for(int y = 0 ; y < 6 ; y += 2){
+      ncplane_putstr_yx(p, y, i % 2, "全角 ▚▞ é ✔");
+    }
+  }
+}
+
+// render several frames of the scene, returning everything rasterized.
+static std::string
+render_scene(uint64_t flags){
+  char* buf = nullptr;
+  size_t buflen = 0;
+  FILE* fp = open_memstream(&buf, &buflen);
+  REQUIRE(fp);
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE | flags;
+  nopts.renderfp = fp;
+  auto nc = notcurses_init(&nopts, nullptr);
+  REQUIRE(nc);
+  struct ncplane* planes[8] = {};
+  for(int frame = 0 ; frame < 4 ; ++frame){
+    draw_scene(nc, frame, planes, sizeof(planes) / sizeof(*planes));
+    CHECK(0 == notcurses_render(nc));
+    CHECK(0 == notcurses_render_wait(nc)); // no frames may be dropped
+  }
+  CHECK(0 == notcurses_render_to_file(nc, fp));
+  CHECK(0 == notcurses_stop(nc));
+  fclose(fp);
+  std::string ret(buf, buflen);
+  free(buf);
+  return ret;
+}
+
+// split rasterized output into its SGR parameters (as a ';'-separated stream,
+// with empty lists written as 0), and everything else. 'sgrs' counts the SGR
+// escapes.
+static void
+split_sgr(const std::string& out, std::string& params, std::string& rest, int& sgrs){
+  sgrs = 0;
+  for(size_t i = 0 ; i < out.size() ; ){
+    size_t slen = sgr_len(out.data() + i, out.size() - i);
+    if(slen){
+      std::string p = out.substr(i + 2, slen - 3);
+      params += (p.empty() ? "0" : p) + ";";
+      ++sgrs;
+      i += slen;
+    }else{
+      rest += out[i++];
+    }
+  }
+}
+
+// apply assorted geometry and content changes to the scene drawn by
+// draw_scene(), exercising each path which must mark rows for re-rendering.
+static void
+mutate_scene(struct notcurses* nc, struct ncplane** planes){
+  ncplane_destroy(planes[1]);
+  planes[1] = nullptr;
+  ncplane_move_yx(planes[2], 3, 7);
+  ncplane_move_top(planes[7]);
+  ncplane_move_bottom(planes[0]);
+  CHECK(0 == ncplane_resize_simple(planes[3], 3, 10));
+  CHECK(0 < ncplane_set_base(planes[4], "x", 0, 0));
+  CHECK(0 < ncplane_putstr_yx(planes[5], 1, 2, "dirty"));
+  ncplane_erase(planes[6]);
+  CHECK(0 < ncplane_putsimple_yx(notcurses_stdplane(nc), 0, 0, '*'));
+}
+
+// describe the last rendered frame, cell by cell
+static std::string
+capture_frame(struct notcurses* nc){
+  int dimy, dimx;
+  notcurses_term_dim_yx(nc, &dimy, &dimx);
+  std::string ret;
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      uint32_t attrword;
+      uint64_t channels;
+      char* egc = notcurses_at_yx(nc, y, x, &attrword, &channels);
+      REQUIRE(egc);
+      ret += egc;
+      ret += "/" + std::to_string(attrword) + "/" + std::to_string(channels) + " ";
+      free(egc);
+      cell c = CELL_TRIVIAL_INITIALIZER;
+      c.channels = channels;
+      if(cell_double_wide_p(&c)){
+        ++x; // lastframe doesn't maintain the right halves of wide glyphs
+      }
+    }
+    ret += "\n";
+  }
+  return ret;
+}
+
+// render the mutated scene, either incrementally atop earlier frames (only
+// dirtied rows being solved anew), or in one full render.
+static std::string
+render_mutated(bool incremental, uint64_t flags){
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE | flags;
+  auto nc = notcurses_init(&nopts, nullptr);
+  REQUIRE(nc);
+  struct ncplane* planes[8] = {};
+  for(int frame = incremental ? 0 : 3 ; frame < 4 ; ++frame){
+    draw_scene(nc, frame, planes, sizeof(planes) / sizeof(*planes));
+    if(incremental){
+      CHECK(0 == notcurses_render(nc));
+    }
+  }
+  mutate_scene(nc, planes);
+  CHECK(0 == notcurses_render(nc));
+  auto ret = capture_frame(nc);
+  CHECK(0 == notcurses_stop(nc));
+  return ret;
+}
+
+TEST_CASE("Render") {
+  if(!enforce_utf8()){
+    return;
+  }
+
+  // painting in parallel bands must produce exactly the serial output
+  SUBCASE("ParallelMatchesSerial") {
+    auto serial = render_scene(NCOPTION_HEADLESS);
+    auto parallel = render_scene(NCOPTION_HEADLESS | NCOPTION_PARALLEL_RENDER);
+    CHECK(0 < serial.size());
+    CHECK(serial == parallel);
+  }
+
+  // handing frames to the writer thread must not change what's written
+  SUBCASE("AsyncMatchesSync") {
+    auto sync = render_scene(NCOPTION_HEADLESS);
+    auto async = render_scene(NCOPTION_HEADLESS | NCOPTION_ASYNC_WRITE);
+    CHECK(0 < sync.size());
+    CHECK(sync == async);
+  }
+
+  // frames rendered faster than they can be written might be dropped, but
+  // all of them are accounted for, and a fence drains the writer
+  SUBCASE("AsyncFence") {
+    notcurses_options nopts{};
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE |
+                  NCOPTION_ASYNC_WRITE;
+    auto nc = notcurses_init(&nopts, nullptr);
+    REQUIRE(nc);
+    struct ncplane* planes[8] = {};
+    struct ncstats stats;
+    notcurses_reset_stats(nc, &stats);
+    const int frames = 16;
+    for(int frame = 0 ; frame < frames ; ++frame){
+      draw_scene(nc, frame, planes, sizeof(planes) / sizeof(*planes));
+      CHECK(0 == notcurses_render(nc));
+    }
+    CHECK(0 == notcurses_render_wait(nc));
+    notcurses_stats(nc, &stats);
+    CHECK(frames == stats.renders);
+    CHECK(frames > stats.frames_dropped);
+    CHECK(0 == stats.queuedbytes);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // synchronized update brackets wrap each frame, and change nothing else
+  SUBCASE("SyncUpdates") {
+    auto plain = render_scene(NCOPTION_HEADLESS);
+    auto synced = render_scene(NCOPTION_HEADLESS | NCOPTION_SYNC_UPDATES);
+    notcurses_options nopts{};
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE |
+                  NCOPTION_HEADLESS;
+    auto nc = notcurses_init(&nopts, nullptr);
+    REQUIRE(nc);
+    const std::string bsu = nc->tcache.bsu;
+    const std::string esu = nc->tcache.esu;
+    CHECK(0 == notcurses_stop(nc));
+    REQUIRE(0 < bsu.size());
+    REQUIRE(0 < esu.size());
+    CHECK(0 == synced.find(bsu));
+    int frames = 0;
+    for(size_t pos ; (pos = synced.find(bsu)) != std::string::npos ; ++frames){
+      synced.erase(pos, bsu.size());
+      size_t end = synced.find(esu, pos);
+      REQUIRE(std::string::npos != end);
+      CHECK(std::string::npos == synced.substr(pos, end - pos).find(bsu));
+      synced.erase(end, esu.size());
+    }
+    CHECK(5 == frames); // four renders, and notcurses_render_to_file()
+    CHECK(plain == synced);
+  }
+
+  // frames rendered too soon after the last write are held until the next
+  // tick, and coalesced into any frame rendered meanwhile
+  SUBCASE("MaxFPSCoalesces") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    CHECK(0 == notcurses_set_maxfps(nc, 4));
+    REQUIRE(nc->writer);
+    auto n = notcurses_stdplane(nc);
+    struct ncstats stats;
+    notcurses_reset_stats(nc, &stats);
+    CHECK(1 == ncplane_putsimple_yx(n, 0, 0, 'x'));
+    CHECK(0 == notcurses_render(nc)); // written immediately, starting the tick
+    CHECK(0 == notcurses_render_wait(nc));
+    for(int i = 0 ; i < 5 ; ++i){
+      CHECK(1 == ncplane_putsimple_yx(n, 0, 0, 'a' + i));
+      CHECK(0 == notcurses_render(nc));
+    }
+    notcurses_stats(nc, &stats);
+    CHECK(6 == stats.renders);
+    CHECK(4 == stats.renders_coalesced);
+    CHECK(0 == stats.frames_dropped);
+    CHECK(0 < stats.queuedbytes);
+    // the held frame is written at the tick, without any further call
+    usleep(600000);
+    notcurses_stats(nc, &stats);
+    CHECK(0 == stats.queuedbytes);
+    char* egc = notcurses_at_yx(nc, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "e"));
+    free(egc);
+    // lifting the limit returns us to synchronous writes
+    CHECK(0 == notcurses_set_maxfps(nc, 0));
+    CHECK(nullptr == nc->writer);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // each phase of each frame is timed, and recorded in its histogram
+  SUBCASE("PhaseTimings") {
+    for(uint64_t flags : { 0ull, NCOPTION_ASYNC_WRITE }){
+      notcurses_options nopts{};
+      nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE |
+                    NCOPTION_HEADLESS | flags;
+      auto nc = notcurses_init(&nopts, nullptr);
+      REQUIRE(nc);
+      struct ncplane* planes[8] = {};
+      struct ncstats stats;
+      notcurses_reset_stats(nc, &stats);
+      const int frames = 4;
+      for(int frame = 0 ; frame < frames ; ++frame){
+        draw_scene(nc, frame, planes, sizeof(planes) / sizeof(*planes));
+        CHECK(0 == notcurses_render(nc));
+        CHECK(0 == notcurses_render_wait(nc));
+      }
+      notcurses_stats(nc, &stats);
+      CHECK(frames == stats.renders);
+      const uint64_t* hists[] = {
+        stats.paint_hist, stats.postpaint_hist, stats.raster_hist, stats.write_hist,
+      };
+      for(auto hist : hists){
+        uint64_t samples = 0;
+        for(int i = 0 ; i < NCSTATS_BUCKETS ; ++i){
+          samples += hist[i];
+        }
+        CHECK(frames == samples);
+      }
+      CHECK(0 < stats.paint_ns);
+      CHECK(0 < stats.raster_ns);
+      CHECK(0 < stats.write_ns);
+      if(!flags){
+        CHECK(stats.paint_ns + stats.postpaint_ns + stats.raster_ns +
+              stats.write_ns <= stats.render_ns);
+      }
+      const uint64_t p50 = ncstats_percentile(stats.raster_hist, 0.5);
+      const uint64_t p999 = ncstats_percentile(stats.raster_hist, 0.999);
+      CHECK(0 < p50);
+      CHECK(p50 <= p999);
+      CHECK(stats.raster_ns / frames <= p999);
+      notcurses_reset_stats(nc, &stats);
+      notcurses_stats(nc, &stats);
+      CHECK(0 == stats.write_ns);
+      CHECK(0 == ncstats_percentile(stats.write_hist, 0.5));
+      CHECK(0 == notcurses_stop(nc));
+    }
+  }
+
+  // every rasterized byte must be attributed to exactly one category
+  SUBCASE("ByteCategories") {
+    for(uint64_t flags : { 0ull, NCOPTION_ASYNC_WRITE, NCOPTION_SYNC_UPDATES }){
+      notcurses_options nopts{};
+      nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE |
+                    NCOPTION_HEADLESS | flags;
+      auto nc = notcurses_init(&nopts, nullptr);
+      REQUIRE(nc);
+      struct ncplane* planes[8] = {};
+      struct ncstats stats;
+      notcurses_reset_stats(nc, &stats);
+      for(int frame = 0 ; frame < 4 ; ++frame){
+        draw_scene(nc, frame, planes, sizeof(planes) / sizeof(*planes));
+        auto n = notcurses_stdplane(nc);
+        ncplane_styles_set(n, frame % 2 ? NCSTYLE_BOLD : NCSTYLE_NONE);
+        ncplane_set_fg_palindex(n, frame + 1);
+        ncplane_set_bg_default(n);
+        CHECK(0 < ncplane_putstr_yx(n, 0, 0, "palette      "));
+        ncplane_styles_set(n, NCSTYLE_NONE);
+        ncplane_set_fg_default(n);
+        if(notcurses_canchangecolor(nc)){
+          palette256* pal = palette256_new(nc);
+          REQUIRE(pal);
+          palette256_set_rgb(pal, frame + 1, 0x10 * frame, 0x20, 0x30);
+          CHECK(0 == palette256_use(nc, pal));
+          palette256_free(pal);
+        }
+        CHECK(0 == notcurses_render(nc));
+        CHECK(0 == notcurses_render_wait(nc));
+      }
+      notcurses_stats(nc, &stats);
+      CHECK(0 < stats.render_bytes);
+      CHECK(0 < stats.motion_bytes);
+      CHECK(0 < stats.glyph_bytes);
+      CHECK(stats.render_bytes == stats.motion_bytes + stats.style_bytes +
+            stats.rgb_bytes + stats.palette_bytes + stats.default_bytes +
+            stats.glyph_bytes + stats.palprog_bytes + stats.sync_bytes);
+      CHECK((flags == NCOPTION_SYNC_UPDATES) == (0 < stats.sync_bytes));
+      CHECK(0 == notcurses_stop(nc));
+    }
+  }
+
+  // a full-width scrolling plane ought be scrolled by the terminal, leaving
+  // lastframe just as if every row had been redrawn
+  SUBCASE("HardwareScroll") {
+    for(uint64_t flags : { 0ull, NCOPTION_ASYNC_WRITE }){
+      notcurses_options nopts{};
+      nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE | flags;
+      auto nc = notcurses_init(&nopts, nullptr);
+      REQUIRE(nc);
+      const bool canscroll = nc->tcache.csr && (nc->tcache.ind || nc->tcache.indn);
+      int dimy, dimx;
+      notcurses_term_dim_yx(nc, &dimy, &dimx);
+      auto bar = ncplane_new(nc, 1, dimx, 0, 0, nullptr);
+      REQUIRE(bar);
+      auto lg = ncplane_new(nc, dimy - 1, dimx, 1, 0, nullptr);
+      REQUIRE(lg);
+      ncplane_move_below(lg, bar);
+      ncplane_set_scrolling(lg, true);
+      auto box = ncplane_new(nc, 2, 10, dimy / 2, dimx / 2, nullptr);
+      REQUIRE(box);
+      CHECK(0 < ncplane_putstr(box, "全角 box"));
+      // each line differs from its neighbors in every column, so that a shift
+      // left to the diff would redraw everything
+      auto putline = [&](int line){
+        for(int x = 0 ; x < dimx / 2 ; ++x){
+          CHECK(1 == ncplane_putsimple(lg, 'a' + (line + x) % 26));
+        }
+        CHECK(0 < ncplane_printf(lg, "全角 é ✔ %d\n", line));
+      };
+      int logged = 0;
+      for(int i = 0 ; i < dimy ; ++i){
+        putline(logged++);
+      }
+      CHECK(0 == notcurses_render(nc));
+      CHECK(0 == notcurses_render_wait(nc));
+      struct ncstats stats;
+      notcurses_reset_stats(nc, &stats);
+      for(int frame = 0 ; frame < 6 ; ++frame){
+        const int newlines = 1 + frame % 2;
+        for(int i = 0 ; i < newlines ; ++i){
+          putline(logged++);
+        }
+        CHECK(0 < ncplane_printf_yx(bar, 0, 0, "frame %d", frame));
+        notcurses_stats(nc, &stats);
+        const uint64_t scrolled = stats.hwscrolls;
+        const uint64_t bytes = stats.render_bytes;
+        CHECK(0 == notcurses_render(nc));
+        CHECK(0 == notcurses_render_wait(nc));
+        notcurses_stats(nc, &stats);
+        CHECK(scrolled + (canscroll ? newlines : 0) == stats.hwscrolls);
+        if(canscroll){
+          // the exposed rows, the bar, and the box, not the whole screen
+          CHECK(stats.render_bytes - bytes < (uint64_t)dimx * 4);
+        }
+        // solving every row of the plane anew must find nothing to redraw
+        const uint64_t scrollbytes = stats.render_bytes;
+        CHECK(0 == ncplane_move_yx(lg, 1, 0));
+        CHECK(0 == notcurses_render(nc));
+        CHECK(0 == notcurses_render_wait(nc));
+        notcurses_stats(nc, &stats);
+        CHECK(scrollbytes == stats.render_bytes);
+      }
+      CHECK(0 == notcurses_stop(nc));
+    }
+  }
+
+  // solving only the dirtied rows must match solving the whole screen
+  SUBCASE("DirtyRowsMatchFullRender") {
+    auto full = render_mutated(false, NCOPTION_HEADLESS);
+    CHECK(full == render_mutated(true, NCOPTION_HEADLESS));
+    CHECK(full == render_mutated(true, NCOPTION_HEADLESS | NCOPTION_PARALLEL_RENDER));
+    CHECK(full == render_mutated(true, NCOPTION_HEADLESS | NCOPTION_ASYNC_WRITE));
+  }
+
+  // rows entirely covered by opaque cells are never painted from below
+  SUBCASE("OcclusionCulled") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    auto n = notcurses_stdplane(nc);
+    CHECK(0 < ncplane_putstr_yx(n, dimy - 1, 0, "beneath"));
+    auto top = ncplane_new(nc, dimy / 2, dimx, 0, 0, nullptr);
+    REQUIRE(top);
+    CHECK(0 < ncplane_set_base(top, "*", 0, 0));
+    auto bisected = ncplane_new(nc, dimy, dimx / 2, 0, dimx / 2, nullptr);
+    REQUIRE(bisected);
+    ncplane_move_bottom(bisected);
+    struct ncstats stats;
+    notcurses_reset_stats(nc, &stats);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    CHECK((uint64_t)((dimy / 2) * (dimx + dimx / 2)) == stats.cellsculled);
+    uint64_t channels;
+    char* egc = notcurses_at_yx(nc, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "*"));
+    free(egc);
+    egc = notcurses_at_yx(nc, dimy - 1, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "b"));
+    free(egc);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // only damaged cells are rasterized, and undamaged rows are skipped
+  SUBCASE("SparseDamage") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    auto n = notcurses_stdplane(nc);
+    CHECK(0 == notcurses_render(nc));
+    struct ncstats stats;
+    notcurses_reset_stats(nc, &stats);
+    CHECK(3 == ncplane_putstr_yx(n, dimy / 2, dimx / 2, "abc"));
+    CHECK(0 < ncplane_putstr_yx(n, dimy / 2, dimx / 2 + 5, "全"));
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    CHECK(4 == stats.cellemissions);
+    CHECK((uint64_t)(dimy * dimx - 4) == stats.cellelisions);
+    notcurses_reset_stats(nc, &stats);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    CHECK(0 == stats.cellemissions);
+    CHECK((uint64_t)(dimy * dimx) == stats.cellelisions);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // moves within a row are made relative to the cursor, rather than with cup
+  SUBCASE("CursorPlanning") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    if(dimx > 40){
+      auto n = notcurses_stdplane(nc);
+      CHECK(0 == notcurses_render(nc));
+      const int y = dimy / 2;
+      CHECK(1 == ncplane_putsimple_yx(n, y, 10, 'x'));
+      CHECK(1 == ncplane_putsimple_yx(n, y, 12, 'y'));
+      CHECK(1 == ncplane_putsimple_yx(n, y, 40, 'z'));
+      struct ncstats stats;
+      notcurses_reset_stats(nc, &stats);
+      CHECK(0 == notcurses_render(nc));
+      notcurses_stats(nc, &stats);
+      size_t cuplen = strlen(tiparm(nc->tcache.cup, y, 40));
+      size_t oplen = nc->tcache.op ? strlen(nc->tcache.op) : 0;
+      CHECK(stats.render_bytes < 3 * cuplen + oplen + 3);
+      CHECK(y == nc->rstate.y);
+      CHECK(41 == nc->rstate.x);
+      char* egc = notcurses_at_yx(nc, y, 12, nullptr, nullptr);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, "y"));
+      free(egc);
+    }
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // precompiled capabilities expand exactly as tiparm() would expand them
+  SUBCASE("EscapeTemplates") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    const tinfo* ti = &nc->tcache;
+    char buf[ESTEMPLATE_MAXLEN + 1];
+    if(ti->cupt.valid){
+      for(int y = 0 ; y < 300 ; y += 37){
+        for(int x = 0 ; x < 300 ; x += 41){
+          const int p[2] = { y, x };
+          buf[estemplate_expand(&ti->cupt, buf, p)] = '\0';
+          CHECK(0 == strcmp(buf, tiparm(ti->cup, y, x)));
+        }
+      }
+    }
+    const struct {
+      const char* cap;
+      const estemplate* t;
+    } caps[] = {
+      { ti->cuu, &ti->cuut, }, { ti->cud, &ti->cudt, },
+      { ti->cuf, &ti->cuft, }, { ti->cub, &ti->cubt, },
+      { ti->hpa, &ti->hpat, }, { ti->vpa, &ti->vpat, },
+      { ti->ech, &ti->echt, },
+    };
+    for(const auto& c : caps){
+      if(c.t->valid){
+        for(int n = 1 ; n < 1000 ; n = n * 3 + 1){
+          buf[estemplate_expand(c.t, buf, &n)] = '\0';
+          CHECK(0 == strcmp(buf, tiparm(c.cap, n)));
+        }
+      }
+    }
+    if(ti->setaf){
+      fbuf f = {};
+      for(int pal = 0 ; pal < ti->colors && pal < 256 ; ++pal){
+        CHECK(0 == term_fg_palindex(nc, &f, pal));
+        const char* seq = tiparm(ti->setaf, pal);
+        CHECK(f.used == strlen(seq));
+        CHECK(0 == memcmp(f.buf, seq, f.used));
+        fbuf_reset(&f);
+      }
+      fbuf_free(&f);
+    }
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // a cell's style and color changes are merged into a single SGR
+  SUBCASE("CombinedSGR") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    if(nc->tcache.sgrmerge && nc->tcache.setaf && nc->tcache.setab){
+      auto n = notcurses_stdplane(nc);
+      int dimx = ncplane_dim_x(n);
+      for(int x = 0 ; x < dimx ; ++x){
+        ncplane_set_attr(n, x % 2 ? NCSTYLE_BOLD : NCSTYLE_NONE);
+        ncplane_set_fg_rgb(n, x % 256, 0x80, 0xff - x % 256);
+        ncplane_set_bg_rgb(n, 0x10, x % 256, 0x40);
+        CHECK(1 == ncplane_putsimple_yx(n, 0, x, 'x'));
+      }
+      CHECK(0 == notcurses_render(nc));
+      // every pass starts from the state the render left, so the latter two
+      // emit the same changes
+      std::string outs[3];
+      for(int pass = 0 ; pass < 3 ; ++pass){
+        nc->tcache.sgrmerge = pass == 2;
+        char* buf = nullptr;
+        size_t buflen = 0;
+        FILE* fp = open_memstream(&buf, &buflen);
+        REQUIRE(fp);
+        CHECK(0 == notcurses_render_to_file(nc, fp));
+        fclose(fp);
+        outs[pass] = std::string(buf, buflen);
+        free(buf);
+      }
+      std::string params[2], rest[2];
+      int sgrs[2];
+      for(int i = 0 ; i < 2 ; ++i){
+        split_sgr(outs[i + 1], params[i], rest[i], sgrs[i]);
+      }
+      // the same parameters are emitted, in the same order, around the same
+      // glyphs and cursor movement, using fewer escapes and bytes
+      CHECK(params[0] == params[1]);
+      CHECK(rest[0] == rest[1]);
+      CHECK(sgrs[1] < sgrs[0]);
+      CHECK(outs[2].size() < outs[1].size());
+      if(nc->tcache.RGBflag){
+        CHECK(std::string::npos != outs[2].find("38;2;1;128;254;48;2;16;1;64m"));
+      }
+    }
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // runs of identical cells are emitted with rep, ech, or el when possible
+  SUBCASE("RepeatedCells") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    int dimy, dimx;
+    notcurses_term_dim_yx(nc, &dimy, &dimx);
+    auto n = notcurses_stdplane(nc);
+    CHECK(0 == notcurses_render(nc));
+    const int y = dimy / 2;
+    const int len = dimx / 2;
+    struct ncstats stats;
+    for(int x = 0 ; x < len ; ++x){
+      CHECK(1 == ncplane_putsimple_yx(n, y, x, '-'));
+    }
+    notcurses_reset_stats(nc, &stats);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    CHECK((uint64_t)len == stats.cellemissions);
+    if(nc->tcache.rep){
+      CHECK(stats.render_bytes < (uint64_t)len);
+    }
+    // multibyte glyphs can be repeated, too
+    for(int x = 0 ; x < len ; ++x){
+      CHECK(1 == ncplane_putegc_yx(n, y + 1, x, "─", nullptr));
+    }
+    notcurses_reset_stats(nc, &stats);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    CHECK((uint64_t)len == stats.cellemissions);
+    if(nc->tcache.rep){
+      CHECK(stats.render_bytes < (uint64_t)len);
+    }
+    // now blank out all but the first, running to the end of the line
+    for(int x = 1 ; x < dimx ; ++x){
+      CHECK(1 == ncplane_putsimple_yx(n, y, x, ' '));
+    }
+    notcurses_reset_stats(nc, &stats);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    if(nc->tcache.cleareol || nc->tcache.ech){
+      CHECK(stats.render_bytes < (uint64_t)len);
+    }
+    for(int x = 0 ; x < dimx ; ++x){
+      char* egc = notcurses_at_yx(nc, y, x, nullptr, nullptr);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, x ? " " : "-"));
+      free(egc);
+    }
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // the render arena is allocated once, and retained across frames
+  SUBCASE("ArenaRetained") {
+    auto nc = testing_notcurses();
+    REQUIRE(nc);
+    struct ncstats stats;
+    notcurses_stats(nc, &stats);
+    CHECK(0 == stats.arenabytes);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats(nc, &stats);
+    auto arenabytes = stats.arenabytes;
+    CHECK(0 < arenabytes);
+    CHECK(0 == notcurses_render(nc));
+    notcurses_reset_stats(nc, &stats);
+    notcurses_stats(nc, &stats);
+    CHECK(arenabytes == stats.arenabytes);
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+}
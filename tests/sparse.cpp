@@ -0,0 +1,166 @@
+#include "main.h"
+#include "internal.h"
+#include <cstdlib>
+
+// compare every cell of two planes of the same geometry
+static int
+plane_mismatches(struct ncplane* a, struct ncplane* b){
+  int dimy, dimx;
+  ncplane_dim_yx(a, &dimy, &dimx);
+  int bad = 0;
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      cell ca = CELL_TRIVIAL_INITIALIZER, cb = CELL_TRIVIAL_INITIALIZER;
+      if(ncplane_at_yx_cell(a, y, x, &ca) < 0 || ncplane_at_yx_cell(b, y, x, &cb) < 0 ||
+         cellcmp(a, &ca, b, &cb)){
+        ++bad;
+      }
+      cell_release(a, &ca);
+      cell_release(b, &cb);
+    }
+  }
+  return bad;
+}
+
+static uint64_t
+fbbytes(struct notcurses* nc){
+  ncstats stats;
+  notcurses_stats(nc, &stats);
+  return stats.fbbytes;
+}
+
+TEST_CASE("SparsePlanes") {
+  if(!enforce_utf8()){
+    return;
+  }
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE
+                | NCOPTION_HEADLESS;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  REQUIRE(nc_);
+  REQUIRE(0 == notcurses_headless_resize(nc_, 20, 60));
+  REQUIRE(0 == notcurses_render(nc_));
+
+  // storage is only allocated for the tiles written to, and freed on erase
+  SUBCASE("Lazy") {
+    const auto before = fbbytes(nc_);
+    auto n = ncplane_new_sparse(nc_, nullptr, 100000, 80, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(ncplane_sparse_p(n));
+    const auto empty = fbbytes(nc_);
+    CHECK(empty - before < 100000 * sizeof(cell));
+    CHECK(0 < ncplane_putstr_yx(n, 50000, 10, "far, far below"));
+    CHECK(0 < ncplane_putstr_yx(n, 50001, 0, "and its neighbor"));
+    CHECK(empty + NCPLANE_TILE_ROWS * 80 * sizeof(cell) == fbbytes(nc_));
+    char* egc = ncplane_at_yx(n, 50000, 10, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "f"));
+    free(egc);
+    egc = ncplane_at_yx(n, 99999, 79, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, ""));
+    free(egc);
+    ncplane_erase(n);
+    CHECK(empty == fbbytes(nc_));
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(before == fbbytes(nc_));
+  }
+
+  // a sparse plane holds exactly what a dense one would, through writes,
+  // scrolling, blocks, fills, and resizes
+  SUBCASE("MatchesDense") {
+    struct ncplane* ps[2] = {
+      ncplane_new(nc_, 40, 30, 0, 0, nullptr),
+      ncplane_new_sparse(nc_, nullptr, 40, 30, 0, 0, nullptr),
+    };
+    REQUIRE(ps[0]);
+    REQUIRE(ps[1]);
+    const char* egcs[] = { "a", "中", "a\xcc\x80\xcc\x81", };
+    const uint32_t indices[] = { 0, 1, 1, 2, 2, 1, 0, 0, };
+    for(auto p : ps){
+      ncplane_set_fg_rgb(p, 0x40, 0x80, 0xc0);
+      CHECK(0 < ncplane_putstr_yx(p, 3, 2, "some text 全角 a\xcc\x80\xcc\x81"));
+      CHECK(8 == ncplane_put_egcs(p, 20, 5, 2, 4, egcs, 3, indices, nullptr, 4));
+      CHECK(0 < ncplane_gradient_sized(p, "▒", 0, 0x800000, 0x8000, 0x80, 0x808080, 3, 4));
+      ncplane_set_scrolling(p, true);
+      CHECK(0 == ncplane_cursor_move_yx(p, 39, 0));
+      for(int i = 0 ; i < 5 ; ++i){
+        CHECK(0 < ncplane_printf(p, "scrolled line %d\n", i));
+      }
+    }
+    CHECK(0 == plane_mismatches(ps[0], ps[1]));
+    for(auto p : ps){
+      CHECK(0 == ncplane_resize(p, 10, 2, 25, 20, 0, -2, 50, 24));
+    }
+    CHECK(0 == plane_mismatches(ps[0], ps[1]));
+    auto d = ncplane_dup(ps[1], nullptr);
+    REQUIRE(d);
+    CHECK(ncplane_sparse_p(d));
+    CHECK(0 == plane_mismatches(ps[0], d));
+    CHECK(0 == ncplane_destroy(d));
+    for(auto p : ps){
+      CHECK(0 == ncplane_destroy(p));
+    }
+  }
+
+  // converting to and from sparse storage preserves content, dropping blank
+  // tiles
+  SUBCASE("Convert") {
+    auto n = ncplane_new(nc_, 64, 40, 0, 0, nullptr);
+    REQUIRE(n);
+    auto ref = ncplane_new(nc_, 64, 40, 0, 0, nullptr);
+    REQUIRE(ref);
+    for(auto p : { n, ref }){
+      CHECK(0 < ncplane_putstr_yx(p, 1, 0, "the first tile"));
+      CHECK(0 < ncplane_putstr_yx(p, 63, 20, "the last tile"));
+    }
+    const auto dense = fbbytes(nc_);
+    CHECK(0 == ncplane_set_sparse(n, true));
+    CHECK(ncplane_sparse_p(n));
+    CHECK(nullptr != n->tiles[0]);
+    CHECK(nullptr == n->tiles[1]);
+    CHECK(nullptr == n->tiles[2]);
+    CHECK(nullptr != n->tiles[3]);
+    CHECK(dense > fbbytes(nc_));
+    CHECK(0 == plane_mismatches(n, ref));
+    CHECK(0 == ncplane_set_sparse(n, false));
+    CHECK(!ncplane_sparse_p(n));
+    CHECK(dense == fbbytes(nc_));
+    CHECK(0 == plane_mismatches(n, ref));
+    CHECK(0 == ncplane_destroy(ref));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // rows never written are drawn with the base cell
+  SUBCASE("RenderBase") {
+    auto n = ncplane_new_sparse(nc_, nullptr, 20, 60, 0, 0, nullptr);
+    REQUIRE(n);
+    cell c = CELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < cell_load(n, &c, "x"));
+    CHECK(0 <= ncplane_set_base_cell(n, &c));
+    cell_release(n, &c);
+    CHECK(0 < ncplane_putstr_yx(n, 18, 0, "written"));
+    auto m = ncplane_new_sparse(nc_, nullptr, 20, 60, 0, 0, nullptr);
+    REQUIRE(m);
+    CHECK(0 < ncplane_putstr_yx(m, 2, 0, "merged"));
+    CHECK(0 == ncplane_mergedown(m, n));
+    CHECK(ncplane_sparse_p(n));
+    CHECK(0 == ncplane_destroy(m));
+    CHECK(0 == notcurses_render(nc_));
+    char* egc = notcurses_headless_at(nc_, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "x"));
+    free(egc);
+    egc = notcurses_headless_at(nc_, 18, 1, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "r"));
+    free(egc);
+    egc = notcurses_headless_at(nc_, 2, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "m"));
+    free(egc);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
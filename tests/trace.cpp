@@ -0,0 +1,183 @@
+#include "main.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// a headless context, recording to 'path' if it's not NULL
+static struct notcurses*
+trace_notcurses(const char* path){
+  if(path){
+    setenv("NOTCURSES_TRACE", path, 1);
+  }
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_INHIBIT_SETLOCALE
+                | NCOPTION_HEADLESS;
+  auto nc = notcurses_init(&nopts, nullptr);
+  unsetenv("NOTCURSES_TRACE");
+  return nc;
+}
+
+struct screencell {
+  std::string egc;
+  uint32_t attrword;
+  uint64_t channels;
+};
+
+// everything written to the virtual terminal
+static std::vector<screencell>
+dump_screen(struct notcurses* nc){
+  std::vector<screencell> cells;
+  int dimy, dimx;
+  notcurses_term_dim_yx(nc, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      screencell sc;
+      char* egc = notcurses_headless_at(nc, y, x, &sc.attrword, &sc.channels);
+      REQUIRE(egc);
+      sc.egc = egc;
+      free(egc);
+      cells.push_back(sc);
+    }
+  }
+  return cells;
+}
+
+static int
+mismatches(const std::vector<screencell>& a, const std::vector<screencell>& b){
+  int bad = 0;
+  for(size_t i = 0 ; i < a.size() && i < b.size() ; ++i){
+    if(a[i].egc != b[i].egc || a[i].attrword != b[i].attrword ||
+       a[i].channels != b[i].channels){
+      if(bad++ < 5){
+        fprintf(stderr, "mismatch at %zu: '%s' vs '%s'\n", i,
+                a[i].egc.c_str(), b[i].egc.c_str());
+      }
+    }
+  }
+  return bad;
+}
+
+TEST_CASE("Trace") {
+  if(!enforce_utf8()){
+    return;
+  }
+  char path[] = "/tmp/notcurses-trace-XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(0 <= fd);
+  close(fd);
+  auto nc_ = trace_notcurses(path);
+  REQUIRE(nc_);
+  auto n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+  REQUIRE(0 == notcurses_headless_resize(nc_, 20, 60));
+  REQUIRE(0 == notcurses_render(nc_));
+
+  // replay the trace into a fresh context, expecting the same final screen
+  auto replay = [&](int frames){
+    auto recorded = dump_screen(nc_);
+    CHECK(0 == notcurses_stop(nc_));
+    nc_ = nullptr;
+    auto nc = trace_notcurses(nullptr);
+    REQUIRE(nc);
+    FILE* fp = fopen(path, "rb");
+    REQUIRE(fp);
+    CHECK(frames == notcurses_replay(nc, fp, false));
+    fclose(fp);
+    auto replayed = dump_screen(nc);
+    CHECK(recorded.size() == replayed.size());
+    CHECK(0 == mismatches(recorded, replayed));
+    CHECK(0 == notcurses_stop(nc));
+  };
+
+  SUBCASE("Planes") {
+    ncplane_set_fg_rgb(n_, 0x80, 0xc0, 0x40);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "traced text on the standard plane"));
+    ncplane_styles_set(n_, NCSTYLE_BOLD);
+    CHECK(0 < ncplane_putstr_yx(n_, 2, 4, "bold, with a wide glyph: 中"));
+    auto p = ncplane_new(nc_, 5, 20, 3, 3, nullptr);
+    REQUIRE(p);
+    cell c = CELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < cell_load(p, &c, "▒"));
+    cell_set_bg_rgb(&c, 0x20, 0x20, 0x80);
+    CHECK(0 <= ncplane_set_base_cell(p, &c));
+    cell_release(p, &c);
+    CHECK(0 < ncplane_putstr_yx(p, 1, 1, "a plane"));
+    CHECK(0 == notcurses_render(nc_));
+    auto q = ncplane_bound(p, 4, 10, 1, 10, nullptr);
+    REQUIRE(q);
+    CHECK(0 < ncplane_putstr_yx(q, 0, 0, "bound"));
+    CHECK(0 == ncplane_move_yx(p, 6, 30));
+    CHECK(0 == ncplane_move_below(q, p));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_resize(p, 0, 0, 5, 10, 0, 0, 8, 16));
+    ncplane_erase(q);
+    CHECK(0 < ncplane_putstr_yx(q, 3, 0, "erased"));
+    ncplane_move_top(q);
+    auto d = ncplane_dup(p, nullptr);
+    REQUIRE(d);
+    CHECK(0 == ncplane_move_yx(d, 12, 2));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(p));
+    CHECK(0 == notcurses_render(nc_));
+    replay(5);
+  }
+
+  SUBCASE("Scrolling") {
+    auto p = ncplane_new(nc_, 4, 30, 5, 5, nullptr);
+    REQUIRE(p);
+    ncplane_set_scrolling(p, true);
+    for(int i = 0 ; i < 10 ; ++i){
+      ncplane_set_fg_rgb(p, 0x10 * i, 0xff, 0x80);
+      CHECK(0 < ncplane_printf(p, "line %d\n", i));
+    }
+    CHECK(0 == notcurses_render(nc_));
+    replay(2);
+  }
+
+  // writes made directly to the framebuffer are recorded as snapshots
+  SUBCASE("Snapshots") {
+    auto p = ncplane_new(nc_, 6, 20, 2, 2, nullptr);
+    REQUIRE(p);
+    CHECK(0 < ncplane_gradient(p, "x", 0, 0x800000ull, 0x8000ull, 0x80ull,
+                               0x808080ull, 5, 19));
+    std::vector<uint32_t> rgba(8 * 8);
+    for(size_t i = 0 ; i < rgba.size() ; ++i){
+      rgba[i] = 0xff000000ul | (i * 0x030507ul & 0xfffffful);
+    }
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.y = 10;
+    vopts.x = 30;
+    vopts.leny = 8;
+    vopts.lenx = 8;
+    vopts.blitter = NCBLIT_2x1;
+    CHECK(0 < ncblit_rgba(rgba.data(), 8 * sizeof(*rgba.data()), &vopts));
+    CHECK(0 == notcurses_render(nc_));
+    ncplane_greyscale(p);
+    const char* egcs[] = { "a", "中", "a\xcc\x80\xcc\x81", };
+    const uint32_t indices[] = { 0, 1, 1, 2, 2, 1, 0, 0, };
+    CHECK(8 == ncplane_put_egcs(n_, 1, 40, 2, 4, egcs, 3, indices, nullptr, 4));
+    CHECK(0 == notcurses_render(nc_));
+    replay(3);
+  }
+
+  // only clean up if the subcase didn't already
+  if(nc_){
+    CHECK(0 == notcurses_stop(nc_));
+  }
+  unlink(path);
+}
+
+TEST_CASE("TraceMalformed") {
+  auto nc = trace_notcurses(nullptr);
+  REQUIRE(nc);
+  FILE* fp = tmpfile();
+  REQUIRE(fp);
+  fputs("not a trace", fp);
+  rewind(fp);
+  CHECK(-1 == notcurses_replay(nc, fp, false));
+  fclose(fp);
+  CHECK(0 == notcurses_stop(nc));
+}
@@ -164,6 +164,19 @@ TEST_CASE("Visual") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // blitters without an implementation must be rejected
+  SUBCASE("UnimplementedBlitter") {
+    std::vector<uint32_t> rgba(12 * 4, 0xff88bbcc);
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.leny = 12;
+    vopts.lenx = 4;
+    vopts.blitter = NCBLIT_SIXEL;
+    vopts.flags = NCVISUAL_OPTION_NODEGRADE;
+    CHECK(0 > ncblit_rgba(rgba.data(), 4 * sizeof(uint32_t), &vopts));
+    CHECK(0 > ncblit_bgrx(rgba.data(), 4 * sizeof(uint32_t), &vopts));
+  }
+
   // write a checkerboard pattern and verify the NCBLIT_2x1 output
   SUBCASE("Dualblitter") {
     if(enforce_utf8()){
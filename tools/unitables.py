@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+
+# Generate src/lib/unitables.h, the code point width table used by
+# utf8_egc_len(), from the Unicode Character Database as provided by
+# Python's unicodedata module. Widths follow those of glibc's wcwidth(),
+# so that our layout agrees with that of the terminal:
+#
+#  -1: C0 and C1 controls, line and paragraph separators, surrogates, and
+#      unassigned code points (none of these are drawn)
+#   0: nonspacing and enclosing marks, formatting characters (save the soft
+#      hyphen and prepended concatenation marks), and Hangul medial vowels
+#      and final consonants (all of which join the preceding character)
+#   2: East Asian Wide and Fullwidth characters
+#   1: everything else
+#
+# usage: tools/unitables.py > src/lib/unitables.h
+
+import sys
+import unicodedata
+
+BLOCKBITS = 8 # code points per second-stage block, as a power of two
+CODEPOINTS = 0x110000
+
+PREPENDED_CONCATENATION_MARKS = [
+  *range(0x600, 0x606), 0x6dd, 0x70f, 0x890, 0x891, 0x8e2, 0x110bd, 0x110cd,
+]
+
+def width(cp):
+  if cp == 0:
+    return 0
+  if cp < 0x20 or 0x7f <= cp < 0xa0:
+    return -1
+  c = chr(cp)
+  cat = unicodedata.category(c)
+  if cat in ('Cs', 'Cn', 'Zl', 'Zp'):
+    return -1
+  if cp == 0xad or cp in PREPENDED_CONCATENATION_MARKS:
+    return 1
+  if cat in ('Mn', 'Me', 'Cf'):
+    return 0
+  if 0x1160 <= cp <= 0x11ff or 0xd7b0 <= cp <= 0xd7ff:
+    return 0
+  if unicodedata.east_asian_width(c) in ('W', 'F'):
+    return 2
+  # glibc considers these wide, though their East Asian Width is otherwise
+  if 0x3248 <= cp <= 0x324f or 0x4dc0 <= cp <= 0x4dff:
+    return 2
+  return 1
+
+def main():
+  blocksize = 1 << BLOCKBITS
+  blocks = []
+  blockidx = {}
+  stage1 = []
+  for base in range(0, CODEPOINTS, blocksize):
+    # two bits per code point, with -1 stored as 3
+    packed = [0] * (blocksize // 4)
+    for i in range(blocksize):
+      packed[i // 4] |= (width(base + i) & 3) << ((i % 4) * 2)
+    packed = tuple(packed)
+    if packed not in blockidx:
+      blockidx[packed] = len(blocks)
+      blocks.append(packed)
+    stage1.append(blockidx[packed])
+  if len(blocks) > 256:
+    sys.exit("too many blocks (%d) for 8-bit indices" % len(blocks))
+  out = sys.stdout
+  out.write("// generated by tools/unitables.py from Unicode %s. do not edit.\n"
+            % unicodedata.unidata_version)
+  out.write("#ifndef NOTCURSES_UNITABLES\n#define NOTCURSES_UNITABLES\n\n")
+  out.write("#include <stdint.h>\n\n")
+  out.write("#define UCS_WIDTH_BLOCKBITS %d\n\n" % BLOCKBITS)
+  out.write("// the second-stage block describing each %d code points\n" % blocksize)
+  out.write("static const uint8_t ucs_width_stage1[%d] = {\n" % len(stage1))
+  for i in range(0, len(stage1), 16):
+    out.write("  " + " ".join("%d," % b for b in stage1[i:i + 16]) + "\n")
+  out.write("};\n\n")
+  out.write("// the widths of a block's code points, two bits apiece, least\n"
+            "// significant first. -1 is stored as 3.\n")
+  out.write("static const uint8_t ucs_width_stage2[%d][%d] = {\n"
+            % (len(blocks), blocksize // 4))
+  for block in blocks:
+    out.write("  {\n")
+    for i in range(0, len(block), 16):
+      out.write("    " + " ".join("0x%02x," % b for b in block[i:i + 16]) + "\n")
+    out.write("  },\n")
+  out.write("};\n\n#endif\n")
+
+if __name__ == '__main__':
+  main()